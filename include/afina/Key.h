@@ -0,0 +1,159 @@
+#ifndef AFINA_KEY_H
+#define AFINA_KEY_H
+
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <random>
+#include <string>
+
+namespace Afina {
+
+namespace Hashing {
+
+// Multiplies a by b, returns low and high halves of the product in a and b
+inline void Multiply(std::uint64_t &a, std::uint64_t &b) {
+    __uint128_t product = static_cast<__uint128_t>(a) * b;
+    a = static_cast<std::uint64_t>(product);
+    b = static_cast<std::uint64_t>(product >> 64);
+}
+
+inline std::uint64_t Mix(std::uint64_t a, std::uint64_t b) {
+    Multiply(a, b);
+    return a ^ b;
+}
+
+inline std::uint64_t Read8(const unsigned char *p) {
+    std::uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline std::uint64_t Read4(const unsigned char *p) {
+    std::uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/**
+ * Seed of the process, random so clients can't choose keys colliding in the storage indexes
+ */
+inline std::uint64_t Seed() {
+    static const std::uint64_t seed = []() {
+        std::random_device device;
+        return static_cast<std::uint64_t>(device()) << 32 | device();
+    }();
+    return seed;
+}
+
+} // namespace Hashing
+
+/**
+ * wyhash of the bytes seeded with Hashing::Seed: reads 16 bytes per multiplication, keys up to 16 bytes
+ * are hashed without loops
+ */
+inline std::uint64_t Hash(const char *data, std::size_t size) {
+    using namespace Hashing;
+    static constexpr std::uint64_t SECRET[4] = {0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL, 0x4b33a62ed433d4a3ULL,
+                                                0x4d5a2da51de1aa47ULL};
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(data);
+    std::uint64_t seed = Seed();
+    seed ^= Mix(seed ^ SECRET[0], SECRET[1]);
+    std::uint64_t a, b;
+    if (size <= 16) {
+        if (size >= 4) {
+            std::size_t middle = (size >> 3) << 2;
+            a = Read4(p) << 32 | Read4(p + middle);
+            b = Read4(p + size - 4) << 32 | Read4(p + size - 4 - middle);
+        } else if (size > 0) {
+            a = std::uint64_t(p[0]) << 16 | std::uint64_t(p[size >> 1]) << 8 | p[size - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        std::size_t left = size;
+        if (left >= 48) {
+            std::uint64_t seed1 = seed, seed2 = seed;
+            do {
+                seed = Mix(Read8(p) ^ SECRET[1], Read8(p + 8) ^ seed);
+                seed1 = Mix(Read8(p + 16) ^ SECRET[2], Read8(p + 24) ^ seed1);
+                seed2 = Mix(Read8(p + 32) ^ SECRET[3], Read8(p + 40) ^ seed2);
+                p += 48;
+                left -= 48;
+            } while (left >= 48);
+            seed ^= seed1 ^ seed2;
+        }
+        while (left > 16) {
+            seed = Mix(Read8(p) ^ SECRET[1], Read8(p + 8) ^ seed);
+            p += 16;
+            left -= 16;
+        }
+        a = Read8(p + left - 16);
+        b = Read8(p + left - 8);
+    }
+    a ^= SECRET[1];
+    b ^= seed;
+    Multiply(a, b);
+    return Mix(a ^ SECRET[0] ^ size, b ^ SECRET[1]);
+}
+
+inline std::uint64_t Hash(const std::string &data) { return Hash(data.data(), data.size()); }
+
+/**
+ * # Key of the storage association
+ * Refers to the key bytes owned by the caller and carries their hash, see Afina::Hash. Protocol layer hashes
+ * every key once, while the command is parsed, and storage uses that hash all the way: to choose stripe or
+ * shard and to look key up in the index. Keys built from strings implicitly are hashed on the spot.
+ *
+ * Key doesn't own the bytes, so it must not outlive the string it was built from
+ */
+class Key {
+public:
+    // Empty key, placeholder to be assigned
+    Key() : Key("", 0) {}
+
+    Key(const char *data, std::size_t size, std::uint64_t hash) : _data(data), _size(size), _hash(hash) {}
+    Key(const char *data, std::size_t size) : Key(data, size, Hash(data, size)) {}
+    Key(const std::string &key, std::uint64_t hash) : Key(key.data(), key.size(), hash) {}
+    Key(const std::string &key) : Key(key.data(), key.size()) {}
+    Key(const char *key) : Key(key, std::strlen(key)) {}
+
+    const char *data() const { return _data; }
+    std::size_t size() const { return _size; }
+    std::uint64_t hash() const { return _hash; }
+
+    std::string str() const { return std::string(_data, _size); }
+
+    bool operator==(const Key &other) const {
+        return _size == other._size && _hash == other._hash && std::memcmp(_data, other._data, _size) == 0;
+    }
+    bool operator!=(const Key &other) const { return !(*this == other); }
+
+private:
+    const char *_data;
+    std::size_t _size;
+    std::uint64_t _hash;
+};
+
+inline std::ostream &operator<<(std::ostream &out, const Key &key) { return out.write(key.data(), key.size()); }
+
+/**
+ * # Key kept past the expression it was built in
+ * Key converted from the string implicitly is fine as a call argument: temporary string lives until the call
+ * returns. Key stored to be used later, like the one of Storage::ReadItem, could outlive it instead, so it is
+ * built from the string only explicitly and never from the temporary one. Keys of the parsed command are
+ * taken as is
+ */
+class StoredKey : public Key {
+public:
+    StoredKey() {}
+    StoredKey(const Key &key) : Key(key) {}
+    explicit StoredKey(const std::string &key) : Key(key) {}
+    StoredKey(std::string &&key) = delete;
+    StoredKey(const std::string &&key) = delete;
+};
+
+} // namespace Afina
+
+#endif // AFINA_KEY_H
@@ -1,7 +1,12 @@
 #ifndef AFINA_STORAGE_H
 #define AFINA_STORAGE_H
 
+#include <cstdint>
 #include <string>
+#include <utility>
+#include <vector>
+
+#include "Key.h"
 
 namespace Afina {
 
@@ -10,6 +15,44 @@ namespace Afina {
  */
 class Storage {
 public:
+    /**
+     * Result of the conditional update
+     */
+    enum class Status {
+        // New value is stored
+        STORED,
+        // Value could not be stored, for example it is too big
+        NOT_STORED,
+        // Value was modified since the version client has seen
+        EXISTS,
+        // There is no value for the key
+        NOT_FOUND
+    };
+
+    /**
+     * Key to read in batch and the read result, see GetMany. Item refers to the key bytes until it is read
+     */
+    struct ReadItem {
+        StoredKey key;
+        // Output: true if key was found, value and metadata are filled in only then
+        bool found;
+        std::string value;
+        uint32_t flags;
+        uint64_t cas;
+    };
+
+    /**
+     * Association to store in batch and the result, see PutMany. Item refers to the key bytes and the value
+     */
+    struct WriteItem {
+        StoredKey key;
+        const std::string *value;
+        uint32_t flags;
+        uint32_t expire;
+        // Output: true if association was stored
+        bool stored;
+    };
+
     Storage() {}
     virtual ~Storage() {}
 
@@ -27,8 +70,12 @@ public:
      *
      * @param key to be associated with value
      * @param value to be assigned for the key
+     * @param flags opaque client word stored along with the value
+     * @param expire unix time in seconds the association expires at, 0 means it never expires
+     * @param cas optional output parameter for the new version of the association, see CompareAndSet
      */
-    virtual bool Put(const std::string &key, const std::string &value) = 0;
+    virtual bool Put(const Key &key, const std::string &value, uint32_t flags = 0, uint32_t expire = 0,
+                     uint64_t *cas = nullptr) = 0;
 
     /**
      * Stores association between given key/value pair if key isn't present in
@@ -40,8 +87,12 @@ public:
      *
      * @param key to be associated with value
      * @param value to be assigned for the key
+     * @param flags opaque client word stored along with the value
+     * @param expire unix time in seconds the association expires at, 0 means it never expires
+     * @param cas optional output parameter for the new version of the association, see CompareAndSet
      */
-    virtual bool PutIfAbsent(const std::string &key, const std::string &value) = 0;
+    virtual bool PutIfAbsent(const Key &key, const std::string &value, uint32_t flags = 0,
+                     uint32_t expire = 0, uint64_t *cas = nullptr) = 0;
 
     /**
      * Updates existing association between given key/value pair
@@ -53,8 +104,12 @@ public:
      *
      * @param key to be associated with value
      * @param value to be assigned for the key
+     * @param flags opaque client word stored along with the value
+     * @param expire unix time in seconds the association expires at, 0 means it never expires
+     * @param cas optional output parameter for the new version of the association, see CompareAndSet
      */
-    virtual bool Set(const std::string &key, const std::string &value) = 0;
+    virtual bool Set(const Key &key, const std::string &value, uint32_t flags = 0, uint32_t expire = 0,
+                     uint64_t *cas = nullptr) = 0;
 
     /**
      * Removes association for the given key
@@ -70,20 +125,104 @@ public:
      *
      * @param key to be removed
      */
-    virtual bool Delete(const std::string &key) = 0;
+    virtual bool Delete(const Key &key) = 0;
+
+    /**
+     * Adds data to the end of the existing value. Flags, expiration time of the association stay the
+     * same, version changes. Read and update are done atomically
+     *
+     * @param key of the association to update
+     * @param value data to add
+     * @param cas optional output parameter for the new version of the association
+     * @return false if there is no such key or no memory for the longer value
+     */
+    virtual bool Append(const Key &key, const std::string &value, uint64_t *cas = nullptr) = 0;
+
+    /**
+     * Same as Append but adds data before the existing value
+     */
+    virtual bool Prepend(const Key &key, const std::string &value, uint64_t *cas = nullptr) = 0;
+
+    /**
+     * Treats existing value as decimal unsigned 64-bit number and adds delta to it, wraps around on
+     * overflow. Flags, expiration time of the association stay the same, version changes. Read and
+     * update are done atomically
+     *
+     * @param key of the association to update
+     * @param delta number to add
+     * @param value output parameter for the new number
+     * @param cas optional output parameter for the new version of the association, see CompareAndSet
+     * @return STORED on success, NOT_FOUND if there is no such key, NOT_STORED if value isn't a number
+     */
+    virtual Status Incr(const Key &key, uint64_t delta, uint64_t &value, uint64_t *cas = nullptr) = 0;
+
+    /**
+     * Same as Incr but substracts delta, result never gets below 0
+     */
+    virtual Status Decr(const Key &key, uint64_t delta, uint64_t &value, uint64_t *cas = nullptr) = 0;
 
     /**
      * Retrive key for the given value
      * If there is an association for the given key then method copies value
      * into given output parameter (possibly extends its size) and return true
      *
-     * In case if given key not found method returns false and doesn't perform
-     * any changes on the output parameter
+     * In case if given key not found or association has expired method returns
+     * false and doesn't perform any changes on the output parameter
      *
      * @param key to retrive1 value for
      * @param value output parameter to copy value to
+     * @param flags optional output parameter to copy flags of the value to
+     * @param cas optional output parameter to copy version of the value to, see CompareAndSet
+     * @param expire optional output parameter to copy expiration time of the value to, 0 if it never expires
+     */
+    virtual bool Get(const Key &key, std::string &value, uint32_t *flags = nullptr, uint64_t *cas = nullptr,
+                     uint32_t *expire = nullptr) = 0;
+
+    /**
+     * Batch version of Get: looks up all the keys and fills results in place. Storage could do
+     * it cheaper than separate Get calls, for example take every lock only once
+     *
+     * @param items keys to look up and output parameters for the results
+     */
+    virtual void GetMany(std::vector<ReadItem> &items) {
+        for (auto &item : items) {
+            item.found = Get(item.key, item.value, &item.flags, &item.cas);
+        }
+    }
+
+    /**
+     * Batch version of Put: stores all the associations in order and fills results in place
+     *
+     * @param items associations to store and output parameters for the results
+     */
+    virtual void PutMany(std::vector<WriteItem> &items) {
+        for (auto &item : items) {
+            item.stored = Put(item.key, *item.value, item.flags, item.expire);
+        }
+    }
+
+    /**
+     * Updates existing association only if it hasn't changed since client has seen it. Every
+     * modification of the association gives it a new version, Get returns current one. Check and
+     * update are done atomically
+     *
+     * @param key to be associated with value
+     * @param value to be assigned for the key
+     * @param flags opaque client word stored along with the value
+     * @param expire unix time in seconds the association expires at, 0 means it never expires
+     * @param cas version of the association client expects
+     * @param new_cas optional output parameter for the version of the stored association
+     */
+    virtual Status CompareAndSet(const Key &key, const std::string &value, uint32_t flags, uint32_t expire,
+                                 uint64_t cas, uint64_t *new_cas = nullptr) = 0;
+
+    /**
+     * Appends storage statistics to the given list as name/value pairs, for example number of hits
+     * or evictions. Storage could report nothing
+     *
+     * @param stats output parameter to append statistics to
      */
-    virtual bool Get(const std::string &key, std::string &value) = 0;
+    virtual void GetStats(std::vector<std::pair<std::string, uint64_t>> &stats) const {}
 };
 
 } // namespace Afina
@@ -0,0 +1,75 @@
+#ifndef AFINA_CONCURRENCY_CONDITION_VARIABLE_H
+#define AFINA_CONCURRENCY_CONDITION_VARIABLE_H
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstdint>
+
+#include "Futex.h"
+
+namespace Afina {
+namespace Concurrency {
+
+/**
+ * # Condition variable for any lock
+ * Works with std::unique_lock of Mutex or any other Lockable, without inner mutex of
+ * std::condition_variable_any. Waiters park on the sequence number bumped by every notification,
+ * notification makes syscall only if some thread is parked
+ */
+class ConditionVariable {
+public:
+    ConditionVariable() : _sequence(0), _parked(0) {}
+
+    void notify_one() { _notify(1); }
+    void notify_all() { _notify(INT_MAX); }
+
+    template <typename Lock> void wait(Lock &lock) {
+        std::uint32_t sequence = _enter();
+        lock.unlock();
+        Futex::Wait(_sequence, sequence);
+        _leave();
+        lock.lock();
+    }
+
+    template <typename Lock, typename Clock, typename Duration>
+    std::cv_status wait_until(Lock &lock, const std::chrono::time_point<Clock, Duration> &deadline) {
+        std::uint32_t sequence = _enter();
+        lock.unlock();
+        bool woken = Futex::WaitFor(_sequence, sequence, deadline - Clock::now());
+        _leave();
+        lock.lock();
+        return woken || Clock::now() < deadline ? std::cv_status::no_timeout : std::cv_status::timeout;
+    }
+
+private:
+    ConditionVariable(const ConditionVariable &) = delete;
+    ConditionVariable &operator=(const ConditionVariable &) = delete;
+
+    // Called under the lock, so notification sent after the caller has unlocked changes the sequence
+    std::uint32_t _enter() {
+        _parked.fetch_add(1, std::memory_order_relaxed);
+        return _sequence.load(std::memory_order_relaxed);
+    }
+
+    void _leave() { _parked.fetch_sub(1, std::memory_order_relaxed); }
+
+    void _notify(int count) {
+        // Waiter has entered under the lock, before the notifier could change the condition, so its
+        // parked mark is visible here and its sequence is the old one
+        _sequence.fetch_add(1, std::memory_order_seq_cst);
+        if (_parked.load(std::memory_order_seq_cst) != 0) {
+            Futex::Wake(_sequence, count);
+        }
+    }
+
+    std::atomic<std::uint32_t> _sequence;
+    // Number of threads between checking condition and returning from wait
+    std::atomic<std::uint32_t> _parked;
+};
+
+} // namespace Concurrency
+} // namespace Afina
+
+#endif // AFINA_CONCURRENCY_CONDITION_VARIABLE_H
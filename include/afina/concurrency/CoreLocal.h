@@ -1,10 +1,72 @@
 #ifndef AFINA_CONCURRENCY_CORE_LOCAL_H
 #define AFINA_CONCURRENCY_CORE_LOCAL_H
 
+#include <sched.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <thread>
+
 namespace Afina {
 namespace Concurrency {
 
-template <typename T> class CoreLocal {};
+/**
+ * # Per-CPU instance of T
+ * Get returns slot of the CPU the caller runs on, found by sched_getcpu, which is a vDSO call without
+ * syscall on Linux. If CPU number is unavailable, thread sticks to the slot chosen by its id.
+ *
+ * Thread could be moved to another CPU right after Get, and threads of the same CPU share slot, so T must
+ * be safe for concurrent updates, e.g. atomics updated with relaxed fetch_add. Still, slot is mostly
+ * written by one CPU and its cache line rarely moves. Unlike ThreadLocal, number of slots doesn't grow
+ * with number of threads
+ */
+template <typename T> class CoreLocal {
+public:
+    CoreLocal() {
+        long cpus = sysconf(_SC_NPROCESSORS_CONF);
+        _size = cpus > 0 ? cpus : 1;
+        _slots.reset(new Slot[_size]());
+    }
+
+    CoreLocal(const CoreLocal &) = delete;
+    CoreLocal &operator=(const CoreLocal &) = delete;
+
+    /**
+     * Slot of the current CPU
+     */
+    T &Get() { return _slots[_cpu() % _size].value; }
+
+    /**
+     * Calls fn(const T &) for every slot
+     */
+    template <typename F> void ForEach(F &&fn) const {
+        for (std::size_t i = 0; i < _size; ++i) {
+            fn(static_cast<const T &>(_slots[i].value));
+        }
+    }
+
+private:
+    static constexpr std::size_t CACHE_LINE = 64;
+
+    struct Slot {
+        T value;
+        char padding[CACHE_LINE];
+    };
+
+    static std::size_t _cpu() {
+        int cpu = sched_getcpu();
+        if (cpu >= 0) {
+            return cpu;
+        }
+        thread_local std::size_t fallback = std::hash<std::thread::id>()(std::this_thread::get_id());
+        return fallback;
+    }
+
+    std::unique_ptr<Slot[]> _slots;
+    std::size_t _size;
+};
 
 } // namespace Concurrency
 } // namespace Afina
@@ -0,0 +1,84 @@
+#ifndef AFINA_CONCURRENCY_EVENT_H
+#define AFINA_CONCURRENCY_EVENT_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "Futex.h"
+
+namespace Afina {
+namespace Concurrency {
+
+/**
+ * # Manual reset event
+ * Once set, releases all waiters and lets new ones pass until reset. Setting the event makes syscall only
+ * if some thread is parked on it, so it is cheap to signal from the hot path
+ */
+class Event {
+public:
+    Event() : _state(UNSET) {}
+
+    void Set() {
+        if (_state.exchange(SET, std::memory_order_release) == PARKED) {
+            Futex::Wake(_state);
+        }
+    }
+
+    void Reset() {
+        std::uint32_t state = SET;
+        _state.compare_exchange_strong(state, UNSET, std::memory_order_relaxed);
+    }
+
+    bool IsSet() const { return _state.load(std::memory_order_acquire) == SET; }
+
+    /**
+     * Blocks until event is set
+     */
+    void Wait() {
+        while (!_park()) {
+            Futex::Wait(_state, PARKED);
+        }
+    }
+
+    /**
+     * Blocks until event is set, but for at most timeout. Returns false on timeout
+     */
+    template <typename Rep, typename Period> bool WaitFor(const std::chrono::duration<Rep, Period> &timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (!_park()) {
+            auto left = deadline - std::chrono::steady_clock::now();
+            if (!Futex::WaitFor(_state, PARKED, left) && !IsSet()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    Event(const Event &) = delete;
+    Event &operator=(const Event &) = delete;
+
+    static constexpr std::uint32_t UNSET = 0;
+    static constexpr std::uint32_t SET = 1;
+    // Unset and there could be parked threads
+    static constexpr std::uint32_t PARKED = 2;
+
+    // Returns true if event is set, otherwise marks that thread is going to park
+    bool _park() {
+        std::uint32_t state = _state.load(std::memory_order_acquire);
+        while (state != SET) {
+            if (state == PARKED || _state.compare_exchange_weak(state, PARKED, std::memory_order_relaxed)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::atomic<std::uint32_t> _state;
+};
+
+} // namespace Concurrency
+} // namespace Afina
+
+#endif // AFINA_CONCURRENCY_EVENT_H
@@ -12,6 +12,9 @@
 
 #include <iostream>
 
+#include "ConditionVariable.h"
+#include "Mutex.h"
+
 namespace Afina {
 namespace Concurrency {
 
@@ -69,7 +72,7 @@ public:
         // Prepare "task"
         auto exec = std::bind(std::forward<F>(func), std::forward<Types>(args)...);
 
-        std::unique_lock<std::mutex> _lock(this->mutex);
+        std::unique_lock<Mutex> _lock(this->mutex);
         if (tasks.size() >= _max_queue_size || state != State::kRun) {
             return false;
         }        
@@ -97,12 +100,12 @@ private:
     /**
      * Mutex to protect state below from concurrent modification
      */
-    std::mutex mutex;
+    Mutex mutex;
 
     /**
      * Conditional variable to await new data in case of empty queue
      */
-    std::condition_variable new_tasks, stop_cond;
+    ConditionVariable new_tasks, stop_cond;
 
     /**
      * Task queue
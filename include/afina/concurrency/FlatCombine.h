@@ -1,10 +1,205 @@
 #ifndef AFINA_CONCURRENCY_FLAT_COMBINE_H
 #define AFINA_CONCURRENCY_FLAT_COMBINE_H
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "Event.h"
+#include "Mutex.h"
+#include "SlotPool.h"
+
 namespace Afina {
 namespace Concurrency {
 
-template <typename Op> class FlatCombine {};
+/**
+ * # Flat combining synchronizer
+ * Instead of taking the lock for its own operation, thread publishes the operation in its own record and
+ * waits. The first waiter that gets the lock becomes combiner: it collects operations published by all
+ * threads and applies them as one batch, then marks them done. Under contention the protected data is
+ * touched by one core for many operations in a row, instead of moving between cores with the lock.
+ *
+ * Op is owned by the caller and is passed to the combine function by pointer, so it holds the arguments
+ * and the place for results. Threads get records on the first call and give them back on exit, threads
+ * above the max_clients limit lock and run their operations alone. Waiter spins for a while and then parks
+ * on the event of its record, which is set once the operation is done or the lock is given up.
+ *
+ * If combine function throws, operations of the batch are in unknown state: Execute of every one of them
+ * throws the exception
+ */
+template <typename Op> class FlatCombine {
+public:
+    // Applies operations of the batch in order, called under the lock
+    using Combiner = std::function<void(Op *const *ops, std::size_t count)>;
+
+    /**
+     * @param combine function applying batch of operations
+     * @param max_clients max number of threads having own publication records
+     */
+    explicit FlatCombine(Combiner combine, std::size_t max_clients = 64)
+        : _combine(std::move(combine)), _records(new Record[max_clients]), _clients(max_clients) {
+        for (std::size_t i = 0; i < max_clients; ++i) {
+            _records[i].pending.store(nullptr, std::memory_order_relaxed);
+        }
+        _batch.reserve(max_clients);
+        _batch_records.reserve(max_clients);
+    }
+
+    FlatCombine(const FlatCombine &) = delete;
+    FlatCombine &operator=(const FlatCombine &) = delete;
+
+    /**
+     * Applies op, possibly in the batch with operations of other threads, and returns once it is done
+     */
+    void Execute(Op &op) {
+        std::size_t slot = _clients.Get();
+        if (slot == SlotPool::NO_SLOT) {
+            std::unique_lock<Mutex> lock(_lock);
+            _run_single(op, lock);
+            return;
+        }
+
+        Record &record = _records[slot];
+        record.wake.Reset();
+        record.pending.store(&op, std::memory_order_release);
+        // Pairs with the fence of _wake_waiters: either lock owner sees the op or the op owner sees the lock free
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        for (unsigned spin = 0; record.pending.load(std::memory_order_acquire) != nullptr; ++spin) {
+            std::unique_lock<Mutex> lock(_lock, std::try_to_lock);
+            if (lock.owns_lock()) {
+                // Own operation was published before the lock was taken, so the scan picks it up
+                _run_combiner();
+                lock.unlock();
+                _wake_waiters();
+                break;
+            }
+            if (spin >= SPIN_LIMIT) {
+                // Woken up once the op is done or the lock is free, the op is checked again either way
+                record.wake.Wait();
+                record.wake.Reset();
+            }
+        }
+        if (record.error != nullptr) {
+            std::exception_ptr error = std::move(record.error);
+            record.error = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+
+    /**
+     * Applies op alone if the lock is free right now, otherwise does nothing and returns false. Caller
+     * could run it while combining another instance without risk of deadlock
+     */
+    bool TryExecute(Op &op) {
+        std::unique_lock<Mutex> lock(_lock, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            return false;
+        }
+        _run_single(op, lock);
+        return true;
+    }
+
+private:
+    static constexpr std::size_t CACHE_LINE = 64;
+    // Number of scans combiner does before it gives up the lock, so it doesn't serve others forever
+    static constexpr unsigned COMBINE_ROUNDS = 4;
+    // Number of checks waiting thread does before it parks
+    static constexpr unsigned SPIN_LIMIT = 128;
+
+    // Publication record, pending is nullptr once operation is done
+    struct Record {
+        std::atomic<Op *> pending;
+        // Exception of the batch operation was in, written before pending is cleared
+        std::exception_ptr error;
+        // Set once the operation is done or the lock is given up with the operation still pending
+        Event wake;
+        char padding[CACHE_LINE - sizeof(std::atomic<Op *>) - sizeof(std::exception_ptr) - sizeof(Event)];
+    };
+
+    // Runs op alone under the taken lock, then gives the lock up
+    void _run_single(Op &op, std::unique_lock<Mutex> &lock) {
+        Op *single = &op;
+        try {
+            _combine(&single, 1);
+        } catch (...) {
+            lock.unlock();
+            _wake_waiters();
+            throw;
+        }
+        lock.unlock();
+        _wake_waiters();
+    }
+
+    // Called after the lock is given up: parked owners of the ops still pending could be the ones that failed
+    // to take it, one of them has to become the next combiner
+    void _wake_waiters() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::size_t clients = _clients.Bound();
+        for (std::size_t i = 0; i < clients; ++i) {
+            if (_records[i].pending.load(std::memory_order_relaxed) != nullptr) {
+                _records[i].wake.Set();
+            }
+        }
+    }
+
+    void _run_combiner() {
+        for (unsigned round = 0; round < COMBINE_ROUNDS; ++round) {
+            // Records of exited threads have nothing pending and are handed to the new ones, so the bound
+            // stays at the max number of threads at once
+            std::size_t clients = _clients.Bound();
+            for (std::size_t i = 0; i < clients; ++i) {
+                Op *op = _records[i].pending.load(std::memory_order_acquire);
+                if (op != nullptr) {
+                    _batch.push_back(op);
+                    _batch_records.push_back(i);
+                }
+            }
+            if (_batch.empty()) {
+                return;
+            }
+
+            try {
+                _combine(_batch.data(), _batch.size());
+            } catch (...) {
+                // Owners are waiting for the batch anyway, they get the exception instead of hanging
+                std::exception_ptr error = std::current_exception();
+                for (std::size_t i : _batch_records) {
+                    _records[i].error = error;
+                }
+                _release_batch();
+                return;
+            }
+            _release_batch();
+        }
+    }
+
+    // Marks operations of the batch done
+    void _release_batch() {
+        for (std::size_t i : _batch_records) {
+            _records[i].pending.store(nullptr, std::memory_order_release);
+            _records[i].wake.Set();
+        }
+        _batch.clear();
+        _batch_records.clear();
+    }
+
+    Combiner _combine;
+
+    Mutex _lock;
+    std::unique_ptr<Record[]> _records;
+    // Records of the threads, record of the exited thread goes to the next one
+    SlotPool _clients;
+
+    // Operations of the current batch and their records, only touched by the combiner
+    std::vector<Op *> _batch;
+    std::vector<std::size_t> _batch_records;
+};
 
 } // namespace Concurrency
 } // namespace Afina
@@ -0,0 +1,81 @@
+#ifndef AFINA_CONCURRENCY_FUTEX_H
+#define AFINA_CONCURRENCY_FUTEX_H
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+
+namespace Afina {
+namespace Concurrency {
+
+/**
+ * # Thin wrappers over Linux futex
+ * Futex word is std::atomic<uint32_t>, which has the same layout as uint32_t on Linux. Futexes are
+ * process private
+ */
+namespace Futex {
+
+/**
+ * Sleeps while word holds expected value, until woken up or timeout passes. Spurious wakeups are possible,
+ * so caller re-checks its condition. Returns false on timeout
+ */
+inline bool Wait(std::atomic<std::uint32_t> &word, std::uint32_t expected, const timespec *timeout = nullptr) {
+    long result = syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&word), FUTEX_WAIT_PRIVATE, expected,
+                          timeout, nullptr, 0);
+    return result == 0 || errno != ETIMEDOUT;
+}
+
+/**
+ * Same as Wait, but for at most timeout
+ */
+template <typename Rep, typename Period>
+bool WaitFor(std::atomic<std::uint32_t> &word, std::uint32_t expected,
+             const std::chrono::duration<Rep, Period> &timeout) {
+    if (timeout <= timeout.zero()) {
+        return false;
+    }
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(timeout).count();
+    timespec relative;
+    relative.tv_sec = ns / 1000000000;
+    relative.tv_nsec = ns % 1000000000;
+    return Wait(word, expected, &relative);
+}
+
+/**
+ * Wakes up to count threads sleeping on the word
+ */
+inline void Wake(std::atomic<std::uint32_t> &word, int count = INT_MAX) {
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&word), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+}
+
+/**
+ * Hint for the CPU that thread is spinning
+ */
+inline void Relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+/**
+ * Number of spins before thread parks: spinning only pays off if lock owner runs on another CPU
+ */
+inline unsigned SpinLimit() {
+    static const unsigned limit = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? 128 : 0;
+    return limit;
+}
+
+} // namespace Futex
+} // namespace Concurrency
+} // namespace Afina
+
+#endif // AFINA_CONCURRENCY_FUTEX_H
@@ -0,0 +1,59 @@
+#ifndef AFINA_CONCURRENCY_LATCH_H
+#define AFINA_CONCURRENCY_LATCH_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "Futex.h"
+
+namespace Afina {
+namespace Concurrency {
+
+/**
+ * # Single use count down latch
+ * Waiters are released once counter reaches zero. Counting down makes syscall only if it releases
+ * parked threads
+ */
+class Latch {
+public:
+    explicit Latch(std::uint32_t count) : _count(count), _parked(0) {}
+
+    /**
+     * Decrements counter by n, counter must not go below zero
+     */
+    void CountDown(std::uint32_t n = 1) {
+        if (_count.fetch_sub(n, std::memory_order_seq_cst) == n) {
+            if (_parked.load(std::memory_order_seq_cst) != 0) {
+                Futex::Wake(_count);
+            }
+        }
+    }
+
+    /**
+     * Returns true if counter has reached zero
+     */
+    bool TryWait() const { return _count.load(std::memory_order_acquire) == 0; }
+
+    /**
+     * Blocks until counter reaches zero
+     */
+    void Wait() {
+        for (std::uint32_t count; (count = _count.load(std::memory_order_acquire)) != 0;) {
+            _parked.fetch_add(1, std::memory_order_seq_cst);
+            Futex::Wait(_count, count);
+            _parked.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    Latch(const Latch &) = delete;
+    Latch &operator=(const Latch &) = delete;
+
+    std::atomic<std::uint32_t> _count;
+    std::atomic<std::uint32_t> _parked;
+};
+
+} // namespace Concurrency
+} // namespace Afina
+
+#endif // AFINA_CONCURRENCY_LATCH_H
@@ -0,0 +1,71 @@
+#ifndef AFINA_CONCURRENCY_MUTEX_H
+#define AFINA_CONCURRENCY_MUTEX_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "Futex.h"
+
+namespace Afina {
+namespace Concurrency {
+
+/**
+ * # Adaptive mutex
+ * Uncontended lock and unlock are single atomic operations without syscalls. Contended lock spins for a
+ * while, as the owner is likely to release it soon, and then parks the thread on futex. Unlock only makes
+ * syscall if some thread is parked.
+ *
+ * Follows Lockable concept, so std::lock_guard and std::unique_lock work with it
+ */
+class Mutex {
+public:
+    Mutex() : _state(UNLOCKED) {}
+
+    void lock() {
+        std::uint32_t state = UNLOCKED;
+        if (_state.compare_exchange_strong(state, LOCKED, std::memory_order_acquire, std::memory_order_relaxed)) {
+            return;
+        }
+        for (unsigned spin = 0; spin < Futex::SpinLimit(); ++spin) {
+            Futex::Relax();
+            state = _state.load(std::memory_order_relaxed);
+            if (state == UNLOCKED && _state.compare_exchange_weak(state, LOCKED, std::memory_order_acquire,
+                                                                  std::memory_order_relaxed)) {
+                return;
+            }
+        }
+
+        // Thread is going to park, so whoever unlocks must wake somebody up. Once woken up thread can't know
+        // whether there are other parked threads, so it takes the lock as contended too
+        while (_state.exchange(CONTENDED, std::memory_order_acquire) != UNLOCKED) {
+            Futex::Wait(_state, CONTENDED);
+        }
+    }
+
+    bool try_lock() {
+        std::uint32_t state = UNLOCKED;
+        return _state.compare_exchange_strong(state, LOCKED, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    void unlock() {
+        if (_state.exchange(UNLOCKED, std::memory_order_release) == CONTENDED) {
+            Futex::Wake(_state, 1);
+        }
+    }
+
+private:
+    Mutex(const Mutex &) = delete;
+    Mutex &operator=(const Mutex &) = delete;
+
+    static constexpr std::uint32_t UNLOCKED = 0;
+    static constexpr std::uint32_t LOCKED = 1;
+    // Locked and there could be parked threads
+    static constexpr std::uint32_t CONTENDED = 2;
+
+    std::atomic<std::uint32_t> _state;
+};
+
+} // namespace Concurrency
+} // namespace Afina
+
+#endif // AFINA_CONCURRENCY_MUTEX_H
@@ -0,0 +1,138 @@
+#ifndef AFINA_CONCURRENCY_SHARED_MUTEX_H
+#define AFINA_CONCURRENCY_SHARED_MUTEX_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "Futex.h"
+
+namespace Afina {
+namespace Concurrency {
+
+/**
+ * # Writer preferring reader-writer lock
+ * Whole state is one futex word: number of readers, writer flag and number of waiting writers. Once some
+ * writer waits, new readers wait too, so read mostly load doesn't starve writers. Uncontended operations
+ * are single atomic operations, unlock only makes syscall if some thread is parked.
+ *
+ * Exclusive ownership follows Lockable concept, so std::lock_guard and std::unique_lock could be used for
+ * writers, and SharedLockGuard for readers
+ */
+class SharedMutex {
+public:
+    SharedMutex() : _state(0), _parked(0) {}
+
+    void lock() {
+        if (try_lock()) {
+            return;
+        }
+        // Registered writer blocks new readers until it gets the lock
+        std::uint32_t state = _state.fetch_add(WAITING_WRITER, std::memory_order_relaxed) + WAITING_WRITER;
+        for (unsigned spin = 0;; ++spin) {
+            if ((state & (READERS | WRITER)) == 0) {
+                if (_state.compare_exchange_weak(state, (state - WAITING_WRITER) | WRITER, std::memory_order_acquire,
+                                                 std::memory_order_relaxed)) {
+                    return;
+                }
+                continue;
+            }
+            _pause(spin, state);
+            state = _state.load(std::memory_order_relaxed);
+        }
+    }
+
+    bool try_lock() {
+        std::uint32_t state = _state.load(std::memory_order_relaxed);
+        return (state & (READERS | WRITER)) == 0 &&
+               _state.compare_exchange_strong(state, state | WRITER, std::memory_order_acquire,
+                                              std::memory_order_relaxed);
+    }
+
+    void unlock() {
+        _state.fetch_and(~WRITER, std::memory_order_seq_cst);
+        _wake();
+    }
+
+    void lock_shared() {
+        std::uint32_t state = _state.load(std::memory_order_relaxed);
+        for (unsigned spin = 0;; ++spin) {
+            if ((state & (WRITER | WAITING_WRITERS)) == 0) {
+                if (_state.compare_exchange_weak(state, state + 1, std::memory_order_acquire,
+                                                 std::memory_order_relaxed)) {
+                    return;
+                }
+                continue;
+            }
+            _pause(spin, state);
+            state = _state.load(std::memory_order_relaxed);
+        }
+    }
+
+    bool try_lock_shared() {
+        std::uint32_t state = _state.load(std::memory_order_relaxed);
+        return (state & (WRITER | WAITING_WRITERS)) == 0 &&
+               _state.compare_exchange_strong(state, state + 1, std::memory_order_acquire,
+                                              std::memory_order_relaxed);
+    }
+
+    void unlock_shared() {
+        // Only the last reader could let somebody in
+        if (((_state.fetch_sub(1, std::memory_order_seq_cst) - 1) & READERS) == 0) {
+            _wake();
+        }
+    }
+
+private:
+    SharedMutex(const SharedMutex &) = delete;
+    SharedMutex &operator=(const SharedMutex &) = delete;
+
+    static constexpr std::uint32_t READERS = 0xffff;
+    static constexpr std::uint32_t WAITING_WRITER = 1 << 16;
+    static constexpr std::uint32_t WAITING_WRITERS = 0x7fff << 16;
+    static constexpr std::uint32_t WRITER = 1u << 31;
+
+    // Spins for a while, then parks until state changes
+    void _pause(unsigned spin, std::uint32_t state) {
+        if (spin < Futex::SpinLimit()) {
+            Futex::Relax();
+            return;
+        }
+        // Pairs with the state change followed by the check of parked in _wake: either waker sees the thread
+        // parked, or futex sees the changed state
+        _parked.fetch_add(1, std::memory_order_seq_cst);
+        Futex::Wait(_state, state);
+        _parked.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // Called right after seq_cst change of the state, which is already a full barrier on common CPUs
+    void _wake() {
+        if (_parked.load(std::memory_order_seq_cst) != 0) {
+            // Both readers and writers could wait for the change, and only they know whom it lets in
+            Futex::Wake(_state);
+        }
+    }
+
+    std::atomic<std::uint32_t> _state;
+    // Number of threads parked on the state
+    std::atomic<std::uint32_t> _parked;
+};
+
+/**
+ * Holds shared ownership of the lock while in scope
+ */
+template <typename Lock> class SharedLockGuard {
+public:
+    explicit SharedLockGuard(Lock &lock) : _lock(lock) { _lock.lock_shared(); }
+    ~SharedLockGuard() { _lock.unlock_shared(); }
+
+private:
+    SharedLockGuard(const SharedLockGuard &) = delete;
+    SharedLockGuard &operator=(const SharedLockGuard &) = delete;
+
+    Lock &_lock;
+};
+
+} // namespace Concurrency
+} // namespace Afina
+
+#endif // AFINA_CONCURRENCY_SHARED_MUTEX_H
@@ -0,0 +1,140 @@
+#ifndef AFINA_CONCURRENCY_SLOT_POOL_H
+#define AFINA_CONCURRENCY_SLOT_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Afina {
+namespace Concurrency {
+
+/**
+ * # Per-thread indices of a fixed size array
+ * Hands out indices in [0, capacity) to the calling threads, so every thread owns its entry of some array,
+ * for example the queue or the publication record. Thread gets index on the first Get and gives it back on
+ * exit, as ThreadLocal does with its slots, so threads coming and going, like the ones of Executor, don't
+ * run out of indices. Release of the index by the exited thread happens before its acquire by the next one,
+ * so the new owner sees the entry as the old one left it.
+ *
+ * Thread finding all indices busy gets NO_SLOT and tries again on the next Get
+ */
+class SlotPool {
+public:
+    static constexpr std::size_t NO_SLOT = SIZE_MAX;
+
+    explicit SlotPool(std::size_t capacity) : _state(std::make_shared<State>(capacity)), _id(++_last_id()) {}
+
+    SlotPool(const SlotPool &) = delete;
+    SlotPool &operator=(const SlotPool &) = delete;
+
+    /**
+     * Index of the calling thread or NO_SLOT if all of them are busy
+     */
+    std::size_t Get() {
+        ThreadSlots &cache = _thread_slots();
+        if (cache.last_id == _id) {
+            return cache.last_index;
+        }
+        for (auto &slot : cache.slots) {
+            if (slot.id == _id) {
+                cache.last_id = _id;
+                cache.last_index = slot.index;
+                return slot.index;
+            }
+        }
+
+        std::size_t index = _state->Acquire();
+        if (index != NO_SLOT) {
+            cache.slots.push_back(ThreadSlot{_id, _state, index});
+            cache.last_id = _id;
+            cache.last_index = index;
+        }
+        return index;
+    }
+
+    /**
+     * All indices ever handed out are below the bound, so owners of the array scan entries up to it. As
+     * indices are reused, bound is the max number of threads at once rather than the number of threads ever
+     */
+    std::size_t Bound() const { return _state->bound.load(std::memory_order_acquire); }
+
+    /**
+     * True if some thread owns the index. Entry of the free index is left by the exited thread and could be
+     * skipped by the scan
+     */
+    bool InUse(std::size_t index) const { return _state->in_use[index].load(std::memory_order_acquire); }
+
+    std::size_t Capacity() const { return _state->capacity; }
+
+private:
+    // Owned together with the pool, so that thread could release its index on exit even after pool is gone
+    struct State {
+        explicit State(std::size_t capacity) : in_use(new std::atomic<bool>[capacity]), capacity(capacity), bound(0) {
+            for (std::size_t i = 0; i < capacity; ++i) {
+                in_use[i].store(false, std::memory_order_relaxed);
+            }
+        }
+
+        std::size_t Acquire() {
+            for (std::size_t i = 0; i < capacity; ++i) {
+                bool free = false;
+                if (!in_use[i].load(std::memory_order_relaxed) &&
+                    in_use[i].compare_exchange_strong(free, true, std::memory_order_acquire)) {
+                    std::size_t current = bound.load(std::memory_order_relaxed);
+                    while (current < i + 1 &&
+                           !bound.compare_exchange_weak(current, i + 1, std::memory_order_release)) {
+                    }
+                    return i;
+                }
+            }
+            return NO_SLOT;
+        }
+
+        std::unique_ptr<std::atomic<bool>[]> in_use;
+        const std::size_t capacity;
+        std::atomic<std::size_t> bound;
+    };
+
+    struct ThreadSlot {
+        std::uint64_t id;
+        std::shared_ptr<State> state;
+        std::size_t index;
+    };
+
+    // Indices of the current thread in every pool it has used, given back on thread exit
+    struct ThreadSlots {
+        ThreadSlots() : last_id(0), last_index(NO_SLOT) {}
+        ~ThreadSlots() {
+            for (auto &slot : slots) {
+                slot.state->in_use[slot.index].store(false, std::memory_order_release);
+            }
+        }
+
+        std::vector<ThreadSlot> slots;
+        // The most recently used index
+        std::uint64_t last_id;
+        std::size_t last_index;
+    };
+
+    static std::atomic<std::uint64_t> &_last_id() {
+        static std::atomic<std::uint64_t> last_id(0);
+        return last_id;
+    }
+
+    static ThreadSlots &_thread_slots() {
+        thread_local ThreadSlots slots;
+        return slots;
+    }
+
+    std::shared_ptr<State> _state;
+
+    // Identity of the pool for the thread slots cache, never reused
+    const std::uint64_t _id;
+};
+
+} // namespace Concurrency
+} // namespace Afina
+
+#endif // AFINA_CONCURRENCY_SLOT_POOL_H
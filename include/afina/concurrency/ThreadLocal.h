@@ -1,10 +1,126 @@
 #ifndef AFINA_CONCURRENCY_THREAD_LOCAL_H
 #define AFINA_CONCURRENCY_THREAD_LOCAL_H
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
 namespace Afina {
 namespace Concurrency {
 
-template <typename T> class ThreadLocal {};
+/**
+ * # Per-thread instance of T
+ * Unlike thread_local variable, every ThreadLocal object has its own set of slots, and all of them could
+ * be visited with ForEach. Thread gets its slot on the first Get, slot is padded, so the owner writes to
+ * the cache line nobody else writes to.
+ *
+ * Slot of the exited thread is kept with its value and is handed to the next new thread, so sums over
+ * slots never go down. ForEach reads slots while owners could write them, so T should consist of atomics
+ * that the owner updates with relaxed load and store
+ */
+template <typename T> class ThreadLocal {
+public:
+    ThreadLocal() : _id(++_last_id()) {}
+
+    ThreadLocal(const ThreadLocal &) = delete;
+    ThreadLocal &operator=(const ThreadLocal &) = delete;
+
+    /**
+     * Slot of the calling thread, value initialized on the first call
+     */
+    T &Get() {
+        ThreadSlots &cache = _thread_slots();
+        if (cache.last_id == _id) {
+            return cache.last->value;
+        }
+        for (auto &slot : cache.slots) {
+            if (slot.first == _id) {
+                cache.last_id = _id;
+                cache.last = slot.second.get();
+                return slot.second->value;
+            }
+        }
+
+        std::shared_ptr<Slot> slot = _acquire();
+        cache.slots.emplace_back(_id, slot);
+        cache.last_id = _id;
+        cache.last = slot.get();
+        return slot->value;
+    }
+
+    /**
+     * Calls fn(const T &) for every slot, including ones of exited threads
+     */
+    template <typename F> void ForEach(F &&fn) const {
+        std::lock_guard<std::mutex> lock(_lock);
+        for (auto &slot : _slots) {
+            fn(static_cast<const T &>(slot->value));
+        }
+    }
+
+private:
+    static constexpr std::size_t CACHE_LINE = 64;
+
+    struct Slot {
+        Slot() : value(), in_use(true) {}
+
+        char padding_before[CACHE_LINE];
+        T value;
+        // Cleared by the owner thread on exit
+        std::atomic<bool> in_use;
+        char padding_after[CACHE_LINE];
+    };
+
+    // Slots of the current thread in every ThreadLocal it has used, owned together with the ThreadLocal
+    // itself, so that thread could release them on exit even after ThreadLocal is gone
+    struct ThreadSlots {
+        ThreadSlots() : last_id(0), last(nullptr) {}
+        ~ThreadSlots() {
+            for (auto &slot : slots) {
+                slot.second->in_use.store(false, std::memory_order_release);
+            }
+        }
+
+        std::vector<std::pair<std::uint64_t, std::shared_ptr<Slot>>> slots;
+        // The most recently used slot
+        std::uint64_t last_id;
+        Slot *last;
+    };
+
+    static std::atomic<std::uint64_t> &_last_id() {
+        static std::atomic<std::uint64_t> last_id(0);
+        return last_id;
+    }
+
+    static ThreadSlots &_thread_slots() {
+        thread_local ThreadSlots slots;
+        return slots;
+    }
+
+    // Slot left by the exited thread, or the new one
+    std::shared_ptr<Slot> _acquire() {
+        std::lock_guard<std::mutex> lock(_lock);
+        for (auto &slot : _slots) {
+            bool free = false;
+            if (!slot->in_use.load(std::memory_order_relaxed) &&
+                slot->in_use.compare_exchange_strong(free, true, std::memory_order_acquire)) {
+                return slot;
+            }
+        }
+        _slots.emplace_back(std::make_shared<Slot>());
+        return _slots.back();
+    }
+
+    // Identity of the object for the thread slots cache, never reused
+    const std::uint64_t _id;
+
+    mutable std::mutex _lock;
+    std::vector<std::shared_ptr<Slot>> _slots;
+};
 
 } // namespace Concurrency
 } // namespace Afina
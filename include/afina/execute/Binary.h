@@ -0,0 +1,146 @@
+#ifndef AFINA_EXECUTE_BINARY_H
+#define AFINA_EXECUTE_BINARY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <afina/Key.h>
+
+#include "Command.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Command of the memcached binary protocol
+ * Request is a fixed 24 bytes header followed by the body: extras, key and value, lengths of all of them
+ * are in the header. Opcode of the header selects the operation, extras carry its arguments, for example
+ * flags and expiration time of set. Protocol::BinaryParser parses header, extras and key, value arrives as
+ * the command argument.
+ *
+ * Response is the header with the same opcode and opaque, status of the operation and the body: extras,
+ * key and value of the reply. Quiet variants of the commands don't reply on the usual outcome: getq and
+ * getkq on a miss, setq and the others on success. Client pipelines them and ends batch with noop, which
+ * is always answered. Error replies carry the memcached message as the value. Command writes nothing to the
+ * output if there is no reply
+ */
+class Binary : public Command {
+public:
+    // Magic byte of the request and response
+    static constexpr uint8_t REQUEST = 0x80;
+    static constexpr uint8_t RESPONSE = 0x81;
+
+    // Offsets of the header fields, numbers are big endian
+    enum Header : std::size_t {
+        MAGIC = 0,
+        OPCODE = 1,
+        KEY_LENGTH = 2,
+        EXTRAS_LENGTH = 4,
+        DATA_TYPE = 5,
+        STATUS = 6,
+        BODY_LENGTH = 8,
+        OPAQUE = 12,
+        CAS = 16,
+        HEADER_SIZE = 24
+    };
+
+    // Supported opcodes, Q suffix stands for quiet
+    enum Opcode : uint8_t {
+        GET = 0x00,
+        SET = 0x01,
+        ADD = 0x02,
+        REPLACE = 0x03,
+        DELETE = 0x04,
+        INCREMENT = 0x05,
+        DECREMENT = 0x06,
+        QUIT = 0x07,
+        GETQ = 0x09,
+        NOOP = 0x0a,
+        GETK = 0x0c,
+        GETKQ = 0x0d,
+        APPEND = 0x0e,
+        PREPEND = 0x0f,
+        SETQ = 0x11,
+        ADDQ = 0x12,
+        REPLACEQ = 0x13,
+        DELETEQ = 0x14,
+        INCREMENTQ = 0x15,
+        DECREMENTQ = 0x16,
+        QUITQ = 0x17,
+        APPENDQ = 0x19,
+        PREPENDQ = 0x1a
+    };
+
+    // Statuses of the response
+    enum Status : uint16_t {
+        NO_ERROR = 0x00,
+        KEY_NOT_FOUND = 0x01,
+        KEY_EXISTS = 0x02,
+        INVALID_ARGUMENTS = 0x04,
+        NOT_STORED = 0x05,
+        NON_NUMERIC = 0x06,
+        UNKNOWN_COMMAND = 0x81
+    };
+
+    // Longest extras of the supported requests, the ones of incr and decr
+    static constexpr std::size_t MAX_EXTRAS = 20;
+
+    /**
+     * @param extras arguments of the request, copied by the command
+     */
+    Binary(uint8_t opcode, const Key &key, const char *extras, std::size_t extras_size, uint32_t opaque,
+           uint64_t cas);
+    ~Binary() {}
+
+    inline uint8_t opcode() const { return _opcode; }
+    inline const Key &key() const { return _key; }
+    inline uint32_t opaque() const { return _opaque; }
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+    // quit and quitq
+    bool ClosesConnection() const override { return _opcode == QUIT || _opcode == QUITQ; }
+
+    /**
+     * Reads big endian number of the given size
+     */
+    static uint64_t Load(const char *data, std::size_t size) {
+        uint64_t result = 0;
+        for (std::size_t i = 0; i < size; ++i) {
+            result = result << 8 | static_cast<unsigned char>(data[i]);
+        }
+        return result;
+    }
+
+    /**
+     * Appends big endian number of the given size
+     */
+    static void Store(std::string &out, uint64_t value, std::size_t size) {
+        for (std::size_t i = size; i > 0; --i) {
+            out.push_back(static_cast<char>(value >> (8 * (i - 1))));
+        }
+    }
+
+private:
+    // True for the quiet variants of the opcodes
+    bool _quiet() const;
+
+    // Writes response, unless the command is quiet and status is the one it doesn't report
+    void _reply(std::string &out, uint16_t status, uint64_t cas = 0, const char *extras = nullptr,
+                std::size_t extras_size = 0, bool with_key = false, const std::string *value = nullptr) const;
+
+    const uint8_t _opcode;
+    // Refers to the bytes of the parsed command, see Protocol::BinaryParser::Build
+    const Key _key;
+    char _extras[MAX_EXTRAS];
+    // Size of the extras as the request says, could be longer than the copy when request is invalid
+    const std::size_t _extras_size;
+    const uint32_t _opaque;
+    const uint64_t _cas;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_BINARY_H
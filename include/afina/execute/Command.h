@@ -19,6 +19,11 @@ public:
     virtual ~Command() {}
 
     virtual void Execute(Storage &storage, const std::string &args, std::string &out) = 0;
+
+    /**
+     * True if the connection must be closed once the reply of the command is sent
+     */
+    virtual bool ClosesConnection() const { return false; }
 };
 
 } // namespace Execute
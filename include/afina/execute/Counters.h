@@ -0,0 +1,42 @@
+#ifndef AFINA_EXECUTE_COUNTERS_H
+#define AFINA_EXECUTE_COUNTERS_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Server-wide statistics counters
+ * Every thread increments its own copy of the counters, so hot path never writes shared cache line.
+ * Copies are summed up only when statistics is requested by the "stats" command
+ */
+class Counters {
+public:
+    enum Counter {
+        // Keys requested by the retrieval commands and storage commands parsed from the clients,
+        // hits and misses are counted by the storage itself
+        CMD_GET,
+        CMD_SET,
+        // Bytes received from and sent to the clients
+        BYTES_READ,
+        BYTES_WRITTEN,
+
+        COUNT
+    };
+
+    static void Add(Counter counter, std::uint64_t value = 1);
+
+    /**
+     * Appends sums of all counters to stats
+     */
+    static void GetStats(std::vector<std::pair<std::string, std::uint64_t>> &stats);
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_COUNTERS_H
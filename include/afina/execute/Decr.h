@@ -0,0 +1,43 @@
+#ifndef AFINA_EXECUTE_DECR_H
+#define AFINA_EXECUTE_DECR_H
+
+#include <cstdint>
+#include <string>
+
+#include <afina/Key.h>
+
+#include "Command.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Decrement the number for the key
+ * Substracts given amount from the value, which must be a decimal representation of the
+ * 64-bit unsigned integer. Result never gets below 0
+ *
+ * Command must write result to the output, which could be:
+ * - new value of the item, to indicate success.
+ * - "NOT_FOUND" to indicate that the item does not exist.
+ * - "CLIENT_ERROR ..." if the value is not a number.
+ */
+class Decr : public Command {
+public:
+    Decr(const Key &key, uint64_t delta) : _key(key), _delta(delta) {}
+    ~Decr() {}
+
+    inline const Key &key() const { return _key; }
+    inline uint64_t delta() const { return _delta; }
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+private:
+    // Refers to the bytes of the parsed command, see Protocol::Parser::Build
+    const Key _key;
+    const uint64_t _delta;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_DECR_H
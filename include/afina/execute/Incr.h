@@ -0,0 +1,43 @@
+#ifndef AFINA_EXECUTE_INCR_H
+#define AFINA_EXECUTE_INCR_H
+
+#include <cstdint>
+#include <string>
+
+#include <afina/Key.h>
+
+#include "Command.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Increment the number for the key
+ * Adds given amount to the value, which must be a decimal representation of the 64-bit
+ * unsigned integer. Result wraps around on overflow
+ *
+ * Command must write result to the output, which could be:
+ * - new value of the item, to indicate success.
+ * - "NOT_FOUND" to indicate that the item does not exist.
+ * - "CLIENT_ERROR ..." if the value is not a number.
+ */
+class Incr : public Command {
+public:
+    Incr(const Key &key, uint64_t delta) : _key(key), _delta(delta) {}
+    ~Incr() {}
+
+    inline const Key &key() const { return _key; }
+    inline uint64_t delta() const { return _delta; }
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+private:
+    // Refers to the bytes of the parsed command, see Protocol::Parser::Build
+    const Key _key;
+    const uint64_t _delta;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_INCR_H
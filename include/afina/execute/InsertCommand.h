@@ -2,8 +2,11 @@
 #define AFINA_EXECUTE_INSERT_COMMAND_H
 
 #include <cstdint>
+#include <ctime>
 #include <string>
 
+#include <afina/Key.h>
+
 #include "Command.h"
 
 namespace Afina {
@@ -15,15 +18,37 @@ namespace Execute {
  */
 class InsertCommand : public Command {
 public:
-    InsertCommand(const std::string &key, uint32_t flags, int32_t expire) : _key(key), _flags(flags), _expire(expire) {}
+    InsertCommand(const Key &key, uint32_t flags, int32_t expire) : _key(key), _flags(flags), _expire(expire) {}
     ~InsertCommand() {}
 
-    inline const std::string &key() const { return _key; }
+    inline const Key &key() const { return _key; }
     inline const uint32_t flags() const { return _flags; }
     inline const int32_t expire() const { return _expire; }
 
+    /**
+     * Expiration time for the storage: memcached treats exptime up to 30 days as number of seconds from
+     * now and larger values as unix time. Returns 0 if item never expires, negative exptime means item
+     * is expired already
+     */
+    uint32_t expire_time() const { return ExpireTime(_expire); }
+
+    // See expire_time, shared with the commands which are not insert ones
+    static uint32_t ExpireTime(int64_t expire) {
+        if (expire == 0) {
+            return 0;
+        } else if (expire < 0) {
+            return 1;
+        } else if (expire <= MAX_RELATIVE_EXPIRE) {
+            return std::time(nullptr) + expire;
+        }
+        return expire;
+    }
+
 protected:
-    const std::string _key;
+    static constexpr int32_t MAX_RELATIVE_EXPIRE = 60 * 60 * 24 * 30;
+
+    // Refers to the bytes of the parsed command, see Protocol::Parser::Build
+    const Key _key;
     const uint32_t _flags;
     const int32_t _expire;
 };
@@ -0,0 +1,88 @@
+#ifndef AFINA_EXECUTE_META_COMMAND_H
+#define AFINA_EXECUTE_META_COMMAND_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <afina/Key.h>
+
+#include "Command.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Basic class for the meta commands
+ * Meta command is the command name, the key and single letter flags, some of them with a token right after
+ * the letter:
+ * <cmd> <key> <flags>*\r\n
+ *
+ * Flags select fields of the reply, so client asks for exactly what it needs. Two of them are common for
+ * all meta commands:
+ * - O<token> opaque token up to 32 bytes, returned back as is, so pipelined replies could be matched
+ *   with the requests
+ * - q quiet mode: the usual outcome isn't reported (miss of mg, success of ms and md). Client pipelines
+ *   quiet commands and ends batch with mn, which is always answered
+ *
+ * Reply is a two letter code followed by the returned flags. Command writes nothing to the output if there
+ * is no reply
+ */
+class MetaCommand : public Command {
+public:
+    // Flags without token, Protocol::Parser combines them into options
+    enum Option : uint32_t {
+        RETURN_CAS = 1 << 0,   // c
+        RETURN_FLAGS = 1 << 1, // f
+        RETURN_KEY = 1 << 2,   // k
+        RETURN_SIZE = 1 << 3,  // s
+        RETURN_VALUE = 1 << 4, // v
+        QUIET = 1 << 5,        // q
+        RETURN_TTL = 1 << 6    // t
+    };
+
+    static constexpr std::size_t MAX_OPAQUE = 32;
+
+    MetaCommand(const Key &key, uint32_t options, const char *opaque, std::size_t opaque_size)
+        : _key(key), _options(options), _opaque(opaque), _opaque_size(opaque_size) {}
+    ~MetaCommand() {}
+
+    inline const Key &key() const { return _key; }
+    inline uint32_t options() const { return _options; }
+    inline std::string opaque() const { return std::string(_opaque, _opaque_size); }
+
+protected:
+    // Appends flags returned whatever the outcome is: opaque token and key if it is asked for
+    void _append_common(std::string &out) const {
+        if (_opaque_size > 0) {
+            out.append(" O", 2).append(_opaque, _opaque_size);
+        }
+        if (_options & RETURN_KEY) {
+            out.append(" k", 2).append(_key.data(), _key.size());
+        }
+    }
+
+    // Appends space, flag letter and the decimal number
+    static void _append_flag(std::string &out, char flag, uint64_t value) {
+        char buffer[22];
+        char *pos = buffer + sizeof(buffer);
+        do {
+            *--pos = '0' + value % 10;
+            value /= 10;
+        } while (value != 0);
+        *--pos = flag;
+        *--pos = ' ';
+        out.append(pos, buffer + sizeof(buffer) - pos);
+    }
+
+    // Refers to the bytes of the parsed command, see Protocol::Parser::Build, so does the opaque token
+    const Key _key;
+    const uint32_t _options;
+    const char *const _opaque;
+    const std::size_t _opaque_size;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_META_COMMAND_H
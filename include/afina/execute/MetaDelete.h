@@ -0,0 +1,35 @@
+#ifndef AFINA_EXECUTE_META_DELETE_H
+#define AFINA_EXECUTE_META_DELETE_H
+
+#include <cstdint>
+#include <string>
+
+#include "MetaCommand.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Remove the item
+ * md <key> <flags>*\r\n
+ *
+ * Flags are the ones of MetaCommand.
+ *
+ * Command must write result to the output, which could be:
+ * - "HD <flags>*" if item is deleted
+ * - "NF <flags>*" if there is no such item
+ * Quiet mode reports neither, key is gone anyway
+ */
+class MetaDelete : public MetaCommand {
+public:
+    MetaDelete(const Key &key, uint32_t options, const char *opaque, std::size_t opaque_size)
+        : MetaCommand(key, options, opaque, opaque_size) {}
+    ~MetaDelete() {}
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_META_DELETE_H
@@ -0,0 +1,42 @@
+#ifndef AFINA_EXECUTE_META_GET_H
+#define AFINA_EXECUTE_META_GET_H
+
+#include <cstdint>
+#include <string>
+
+#include "MetaCommand.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Retrieve the fields of the item client asks for
+ * mg <key> <flags>*\r\n
+ *
+ * Flags are the ones of MetaCommand and:
+ * - v return the value
+ * - f return flags of the item
+ * - c return cas unique of the item, see Cas
+ * - s return size of the value
+ * - t return number of seconds the item has left to live, -1 if it never expires
+ *
+ * Command must write result to the output, which could be:
+ * - "VA <size> <flags>*\r\n<data>" if item is found and value is asked for
+ * - "HD <flags>*" if item is found, but value isn't asked for
+ * - "EN" if there is no such item, nothing in quiet mode
+ *
+ * Flags of the reply go in order f, c, s, t, O, k, miss returns only the last two
+ */
+class MetaGet : public MetaCommand {
+public:
+    MetaGet(const Key &key, uint32_t options, const char *opaque, std::size_t opaque_size)
+        : MetaCommand(key, options, opaque, opaque_size) {}
+    ~MetaGet() {}
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_META_GET_H
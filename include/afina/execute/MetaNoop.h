@@ -0,0 +1,29 @@
+#ifndef AFINA_EXECUTE_META_NOOP_H
+#define AFINA_EXECUTE_META_NOOP_H
+
+#include <string>
+
+#include "Command.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Barrier of the pipelined meta commands
+ * mn\r\n
+ *
+ * Does nothing and always replies "MN", so the client knows that all quiet commands sent before it are
+ * done, see MetaCommand
+ */
+class MetaNoop : public Command {
+public:
+    MetaNoop() {}
+    ~MetaNoop() {}
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_META_NOOP_H
@@ -0,0 +1,59 @@
+#ifndef AFINA_EXECUTE_META_SET_H
+#define AFINA_EXECUTE_META_SET_H
+
+#include <cstdint>
+#include <string>
+
+#include "MetaCommand.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Store the value in the way client asks for
+ * ms <key> <datalen> <flags>*\r\n
+ * <data>\r\n
+ *
+ * Flags are the ones of MetaCommand and:
+ * - c return cas unique of the stored item, see Cas
+ * - F<token> flags of the item
+ * - T<token> expiration time, see InsertCommand::expire_time
+ * - C<token> store only if cas unique of the item is still the given one, see Cas
+ * - M<token> mode: S set (default), E add, R replace, A append, P prepend. Append and prepend keep
+ *   flags and expiration time of the item
+ *
+ * Command must write result to the output, which could be:
+ * - "HD <flags>*" if value is stored, nothing in quiet mode. Cas unique goes before the common flags
+ * - "NS <flags>*" if value isn't stored because condition of the mode wasn't met
+ * - "EX <flags>*" if the item was modified since client fetched the cas unique
+ * - "NF <flags>*" if the item to compare cas unique with is not found
+ */
+class MetaSet : public MetaCommand {
+public:
+    // Modes of the command, M flag token
+    enum Mode : char { SET = 'S', ADD = 'E', REPLACE = 'R', APPEND = 'A', PREPEND = 'P' };
+
+    MetaSet(const Key &key, uint32_t options, const char *opaque, std::size_t opaque_size, uint32_t flags,
+            int32_t expire, uint64_t cas, Mode mode)
+        : MetaCommand(key, options, opaque, opaque_size), _flags(flags), _expire(expire), _cas(cas), _mode(mode) {}
+    ~MetaSet() {}
+
+    inline uint32_t flags() const { return _flags; }
+    inline int32_t expire() const { return _expire; }
+    inline uint64_t cas() const { return _cas; }
+    inline Mode mode() const { return _mode; }
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+private:
+    const uint32_t _flags;
+    const int32_t _expire;
+    // 0 if there is no C flag
+    const uint64_t _cas;
+    const Mode _mode;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_META_SET_H
@@ -20,7 +20,7 @@ Executor::~Executor() {
 }
 
 void Executor::Start() {
-    std::unique_lock<std::mutex> _lock(mutex);
+    std::unique_lock<Mutex> _lock(mutex);
     if (state == State::kRun) {
         return;
     }
@@ -36,7 +36,7 @@ void Executor::Start() {
 }
 
 void Executor::Stop(bool await) {
-    std::unique_lock<std::mutex> _lock(mutex);
+    std::unique_lock<Mutex> _lock(mutex);
     if (state == State::kStopped) {
         return;
     }
@@ -57,7 +57,7 @@ void Executor::Stop(bool await) {
 
 void ExecuteFunctions::perform(Executor *executor) {
     using State = Afina::Concurrency::Executor::State;
-    std::unique_lock<std::mutex> _lock(executor->mutex);
+    std::unique_lock<Mutex> _lock(executor->mutex);
     executor->free_threads += 1;
     bool exit_flag{false};
     while (!executor->tasks.empty() || executor->state == State::kRun) {
@@ -0,0 +1,254 @@
+#include <afina/Storage.h>
+#include <afina/execute/Binary.h>
+#include <afina/execute/InsertCommand.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace Afina {
+namespace Execute {
+
+constexpr uint8_t Binary::REQUEST;
+constexpr uint8_t Binary::RESPONSE;
+constexpr std::size_t Binary::MAX_EXTRAS;
+
+namespace {
+
+// Expiration of incr and decr telling not to create missing item
+constexpr uint32_t NO_INITIAL = 0xffffffff;
+
+// Body of the error reply, the same text memcached sends
+const char *ErrorMessage(uint16_t status) {
+    switch (status) {
+    case Binary::KEY_NOT_FOUND:
+        return "Not found";
+    case Binary::KEY_EXISTS:
+        return "Data exists for key.";
+    case Binary::INVALID_ARGUMENTS:
+        return "Invalid arguments";
+    case Binary::NOT_STORED:
+        return "Not stored.";
+    case Binary::NON_NUMERIC:
+        return "Non-numeric server-side value for incr or decr";
+    case Binary::UNKNOWN_COMMAND:
+        return "Unknown command";
+    default:
+        return "";
+    }
+}
+
+} // namespace
+
+Binary::Binary(uint8_t opcode, const Key &key, const char *extras, std::size_t extras_size, uint32_t opaque,
+               uint64_t cas)
+    : _opcode(opcode), _key(key), _extras_size(extras_size), _opaque(opaque), _cas(cas) {
+    std::memcpy(_extras, extras, std::min(extras_size, MAX_EXTRAS));
+}
+
+// memcached binary protocol, see Binary.h
+void Binary::Execute(Storage &storage, const std::string &args, std::string &out) {
+    out.clear();
+
+    switch (_opcode) {
+    case GET:
+    case GETQ:
+    case GETK:
+    case GETKQ: {
+        if (_extras_size != 0 || !args.empty()) {
+            _reply(out, INVALID_ARGUMENTS);
+            return;
+        }
+        // Value buffer is reused by the next gets of the thread
+        static thread_local std::string value;
+        uint32_t flags;
+        uint64_t cas;
+        bool with_key = _opcode == GETK || _opcode == GETKQ;
+        if (!storage.Get(_key, value, &flags, &cas)) {
+            _reply(out, KEY_NOT_FOUND, 0, nullptr, 0, with_key);
+            return;
+        }
+        char extras[4];
+        for (std::size_t i = 0; i < sizeof(extras); ++i) {
+            extras[i] = static_cast<char>(flags >> (8 * (sizeof(extras) - 1 - i)));
+        }
+        _reply(out, NO_ERROR, cas, extras, sizeof(extras), with_key, &value);
+        return;
+    }
+
+    case SET:
+    case SETQ:
+    case ADD:
+    case ADDQ:
+    case REPLACE:
+    case REPLACEQ: {
+        if (_extras_size != 8 || _key.size() == 0) {
+            _reply(out, INVALID_ARGUMENTS);
+            return;
+        }
+        uint32_t flags = Load(_extras, 4);
+        uint32_t expire = InsertCommand::ExpireTime(Load(_extras + 4, 4));
+        uint64_t cas = 0;
+        if (_cas != 0 && _opcode != ADD && _opcode != ADDQ) {
+            switch (storage.CompareAndSet(_key, args, flags, expire, _cas, &cas)) {
+            case Storage::Status::STORED:
+                _reply(out, NO_ERROR, cas);
+                break;
+            case Storage::Status::EXISTS:
+                _reply(out, KEY_EXISTS);
+                break;
+            case Storage::Status::NOT_FOUND:
+                _reply(out, KEY_NOT_FOUND);
+                break;
+            default:
+                _reply(out, NOT_STORED);
+            }
+        } else if (_opcode == SET || _opcode == SETQ) {
+            bool stored = storage.Put(_key, args, flags, expire, &cas);
+            _reply(out, stored ? NO_ERROR : NOT_STORED, cas);
+        } else if (_opcode == ADD || _opcode == ADDQ) {
+            bool stored = storage.PutIfAbsent(_key, args, flags, expire, &cas);
+            _reply(out, stored ? NO_ERROR : KEY_EXISTS, cas);
+        } else {
+            bool stored = storage.Set(_key, args, flags, expire, &cas);
+            _reply(out, stored ? NO_ERROR : KEY_NOT_FOUND, cas);
+        }
+        return;
+    }
+
+    case APPEND:
+    case APPENDQ:
+    case PREPEND:
+    case PREPENDQ: {
+        if (_extras_size != 0 || _key.size() == 0) {
+            _reply(out, INVALID_ARGUMENTS);
+            return;
+        }
+        bool stored;
+        uint64_t cas = 0;
+        if (_opcode == APPEND || _opcode == APPENDQ) {
+            stored = storage.Append(_key, args, &cas);
+        } else {
+            stored = storage.Prepend(_key, args, &cas);
+        }
+        _reply(out, stored ? NO_ERROR : NOT_STORED, cas);
+        return;
+    }
+
+    case DELETE:
+    case DELETEQ: {
+        if (_extras_size != 0 || _key.size() == 0 || !args.empty()) {
+            _reply(out, INVALID_ARGUMENTS);
+            return;
+        }
+        _reply(out, storage.Delete(_key) ? NO_ERROR : KEY_NOT_FOUND);
+        return;
+    }
+
+    case INCREMENT:
+    case INCREMENTQ:
+    case DECREMENT:
+    case DECREMENTQ: {
+        if (_extras_size != 20 || _key.size() == 0 || !args.empty()) {
+            _reply(out, INVALID_ARGUMENTS);
+            return;
+        }
+        uint64_t delta = Load(_extras, 8), initial = Load(_extras + 8, 8), value, cas = 0;
+        uint32_t expire = Load(_extras + 16, 4);
+        bool incr = _opcode == INCREMENT || _opcode == INCREMENTQ;
+        Storage::Status status =
+            incr ? storage.Incr(_key, delta, value, &cas) : storage.Decr(_key, delta, value, &cas);
+        if (status == Storage::Status::NOT_FOUND && expire != NO_INITIAL) {
+            // Missing counter is created with the initial value, delta is not applied
+            value = initial;
+            if (storage.PutIfAbsent(_key, std::to_string(initial), 0, InsertCommand::ExpireTime(expire), &cas)) {
+                status = Storage::Status::STORED;
+            } else {
+                status = incr ? storage.Incr(_key, delta, value, &cas) : storage.Decr(_key, delta, value, &cas);
+            }
+        }
+        switch (status) {
+        case Storage::Status::STORED: {
+            std::string body;
+            Store(body, value, 8);
+            _reply(out, NO_ERROR, cas, nullptr, 0, false, &body);
+            break;
+        }
+        case Storage::Status::NOT_FOUND:
+            _reply(out, KEY_NOT_FOUND);
+            break;
+        default:
+            _reply(out, NON_NUMERIC);
+        }
+        return;
+    }
+
+    case NOOP:
+        _reply(out, NO_ERROR);
+        return;
+
+    case QUIT:
+    case QUITQ:
+        // Connection is closed once the reply is sent, see ClosesConnection
+        _reply(out, NO_ERROR);
+        return;
+
+    default:
+        _reply(out, UNKNOWN_COMMAND);
+    }
+}
+
+bool Binary::_quiet() const {
+    switch (_opcode) {
+    case GETQ:
+    case GETKQ:
+    case SETQ:
+    case ADDQ:
+    case REPLACEQ:
+    case DELETEQ:
+    case INCREMENTQ:
+    case DECREMENTQ:
+    case APPENDQ:
+    case PREPENDQ:
+    case QUITQ:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void Binary::_reply(std::string &out, uint16_t status, uint64_t cas, const char *extras, std::size_t extras_size,
+                    bool with_key, const std::string *value) const {
+    if (_quiet()) {
+        bool get = _opcode == GETQ || _opcode == GETKQ;
+        if ((get && status == KEY_NOT_FOUND) || (!get && status == NO_ERROR)) {
+            return;
+        }
+    }
+    std::size_t key_size = with_key ? _key.size() : 0;
+    // Errors carry the message instead of the value, except the misses of getk telling the key
+    const char *message = status != NO_ERROR && value == nullptr && !with_key ? ErrorMessage(status) : "";
+    std::size_t message_size = std::strlen(message);
+    std::size_t value_size = value != nullptr ? value->size() : message_size;
+    out.reserve(out.size() + HEADER_SIZE + extras_size + key_size + value_size);
+    out.push_back(static_cast<char>(RESPONSE));
+    out.push_back(static_cast<char>(_opcode));
+    Store(out, key_size, 2);
+    Store(out, extras_size, 1);
+    Store(out, 0, 1);
+    Store(out, status, 2);
+    Store(out, extras_size + key_size + value_size, 4);
+    Store(out, _opaque, 4);
+    Store(out, cas, 8);
+    if (extras_size > 0) {
+        out.append(extras, extras_size);
+    }
+    out.append(_key.data(), key_size);
+    if (value != nullptr) {
+        out.append(*value);
+    } else {
+        out.append(message, message_size);
+    }
+}
+
+} // namespace Execute
+} // namespace Afina
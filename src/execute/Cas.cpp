@@ -0,0 +1,26 @@
+#include <afina/Storage.h>
+#include <afina/execute/Cas.h>
+
+namespace Afina {
+namespace Execute {
+
+// memcached protocol: "cas" is a check and set operation which means "store this data but
+// only if no one else has updated since I last fetched it."
+void Cas::Execute(Storage &storage, const std::string &args, std::string &out) {
+    switch (storage.CompareAndSet(_key, args, _flags, expire_time(), _cas)) {
+    case Storage::Status::STORED:
+        out = "STORED";
+        break;
+    case Storage::Status::EXISTS:
+        out = "EXISTS";
+        break;
+    case Storage::Status::NOT_FOUND:
+        out = "NOT_FOUND";
+        break;
+    default:
+        out = "NOT_STORED";
+    }
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -0,0 +1,46 @@
+#include <afina/execute/Counters.h>
+
+#include <atomic>
+
+#include <afina/concurrency/ThreadLocal.h>
+
+namespace Afina {
+namespace Execute {
+
+namespace {
+
+struct Values {
+    std::atomic<std::uint64_t> values[Counters::COUNT];
+};
+
+const char *const NAMES[Counters::COUNT] = {"cmd_get", "cmd_set", "bytes_read", "bytes_written"};
+
+Concurrency::ThreadLocal<Values> &counters() {
+    static Concurrency::ThreadLocal<Values> counters;
+    return counters;
+}
+
+} // namespace
+
+// See Counters.h
+void Counters::Add(Counter counter, std::uint64_t value) {
+    // Only the owner thread writes the slot, no need for atomic increment
+    std::atomic<std::uint64_t> &slot = counters().Get().values[counter];
+    slot.store(slot.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+// See Counters.h
+void Counters::GetStats(std::vector<std::pair<std::string, std::uint64_t>> &stats) {
+    std::uint64_t sums[COUNT] = {};
+    counters().ForEach([&sums](const Values &thread) {
+        for (int i = 0; i < COUNT; ++i) {
+            sums[i] += thread.values[i].load(std::memory_order_relaxed);
+        }
+    });
+    for (int i = 0; i < COUNT; ++i) {
+        stats.emplace_back(NAMES[i], sums[i]);
+    }
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -0,0 +1,23 @@
+#include <afina/Storage.h>
+#include <afina/execute/Decr.h>
+
+namespace Afina {
+namespace Execute {
+
+// memcached protocol: "decr" changes the number stored for the key in place
+void Decr::Execute(Storage &storage, const std::string &args, std::string &out) {
+    uint64_t value;
+    switch (storage.Decr(_key, _delta, value)) {
+    case Storage::Status::STORED:
+        out = std::to_string(value);
+        break;
+    case Storage::Status::NOT_FOUND:
+        out = "NOT_FOUND";
+        break;
+    default:
+        out = "CLIENT_ERROR cannot increment or decrement non-numeric value";
+    }
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -1,10 +1,7 @@
 #include <afina/Storage.h>
 #include <afina/execute/Get.h>
 
-#include <iostream>
-#include <iterator>
-#include <sstream>
-
+#include <cstdint>
 namespace Afina {
 namespace Execute {
 
@@ -12,7 +9,7 @@ namespace Execute {
 
 Each item sent by the server looks like this:
 
-VALUE <key> <flags> <bytes>\r\n
+VALUE <key> <flags> <bytes> [<cas unique>]\r\n
 <data block>\r\n
 
 After all the items have been transmitted, the server sends the string
@@ -21,23 +18,45 @@ to indicate the end of response.
 
 */
 
-void Get::Execute(Storage &storage, const std::string &args, std::string &out) {
-    std::stringstream keyStream;
-    copy(_keys.begin(), _keys.end(), std::ostream_iterator<std::string>(keyStream, " "));
-    std::cout << "Get(" << keyStream.str() << ")" << std::endl;
+namespace {
+
+// Appends space and decimal number to the reply without building temporary strings
+void AppendNumber(std::string &out, uint64_t value) {
+    char buffer[21];
+    char *pos = buffer + sizeof(buffer);
+    do {
+        *--pos = '0' + value % 10;
+        value /= 10;
+    } while (value != 0);
+    *--pos = ' ';
+    out.append(pos, buffer + sizeof(buffer) - pos);
+}
 
-    std::stringstream outStream;
+} // namespace
 
-    std::string value;
-    for (auto &key : _keys) {
-        if (!storage.Get(key, value))
-            continue;
-        outStream << "VALUE " << key << " 0 " << value.size() << "\r\n";
-        outStream << value << "\r\n";
+void Get::Execute(Storage &storage, const std::string &args, std::string &out) {
+    // Items are reused by the next gets of the thread, so are the buffers of their values
+    static thread_local std::vector<Storage::ReadItem> items;
+    items.resize(_keys.size());
+    for (std::size_t i = 0; i < _keys.size(); ++i) {
+        items[i].key = _keys[i];
     }
-    outStream << "END"; // networking layer should add the last \r\n
+    storage.GetMany(items);
 
-    out = outStream.str();
+    out.clear();
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        const Storage::ReadItem &item = items[i];
+        if (!item.found)
+            continue;
+        out.append("VALUE ", 6).append(_keys[i].data(), _keys[i].size());
+        AppendNumber(out, item.flags);
+        AppendNumber(out, item.value.size());
+        if (_with_cas) {
+            AppendNumber(out, item.cas);
+        }
+        out.append("\r\n", 2).append(item.value).append("\r\n", 2);
+    }
+    out.append("END", 3); // networking layer should add the last \r\n
 }
 
 } // namespace Execute
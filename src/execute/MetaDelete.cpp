@@ -0,0 +1,19 @@
+#include <afina/Storage.h>
+#include <afina/execute/MetaDelete.h>
+
+namespace Afina {
+namespace Execute {
+
+// memcached meta protocol, see MetaDelete.h
+void MetaDelete::Execute(Storage &storage, const std::string &args, std::string &out) {
+    bool deleted = storage.Delete(_key);
+    out.clear();
+    if (_options & QUIET) {
+        return;
+    }
+    out.append(deleted ? "HD" : "NF", 2);
+    _append_common(out);
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -0,0 +1,57 @@
+#include <afina/Storage.h>
+#include <afina/execute/MetaGet.h>
+
+#include <ctime>
+
+namespace Afina {
+namespace Execute {
+
+constexpr std::size_t MetaCommand::MAX_OPAQUE;
+
+// memcached meta protocol, see MetaGet.h
+void MetaGet::Execute(Storage &storage, const std::string &args, std::string &out) {
+    out.clear();
+
+    // Value buffer is reused by the next gets of the thread
+    static thread_local std::string value;
+    uint32_t flags, expire;
+    uint64_t cas;
+    if (!storage.Get(_key, value, &flags, &cas, &expire)) {
+        if (!(_options & QUIET)) {
+            out.append("EN", 2);
+            _append_common(out);
+        }
+        return;
+    }
+
+    if (_options & RETURN_VALUE) {
+        out.append("VA ", 3).append(std::to_string(value.size()));
+    } else {
+        out.append("HD", 2);
+    }
+    if (_options & RETURN_FLAGS) {
+        _append_flag(out, 'f', flags);
+    }
+    if (_options & RETURN_CAS) {
+        _append_flag(out, 'c', cas);
+    }
+    if (_options & RETURN_SIZE) {
+        _append_flag(out, 's', value.size());
+    }
+    if (_options & RETURN_TTL) {
+        if (expire == 0) {
+            out.append(" t-1", 4);
+        } else {
+            // Storage clock could be a bit behind, item found is alive anyway
+            uint32_t now = std::time(nullptr);
+            _append_flag(out, 't', expire > now ? expire - now : 0);
+        }
+    }
+    _append_common(out);
+    if (_options & RETURN_VALUE) {
+        out.append("\r\n", 2).append(value); // networking layer should add the last \r\n
+    }
+}
+
+} // namespace Execute
+} // namespace Afina
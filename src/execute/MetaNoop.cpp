@@ -0,0 +1,10 @@
+#include <afina/execute/MetaNoop.h>
+
+namespace Afina {
+namespace Execute {
+
+// memcached meta protocol: "mn" only tells that the commands before it are done
+void MetaNoop::Execute(Storage &storage, const std::string &args, std::string &out) { out = "MN"; }
+
+} // namespace Execute
+} // namespace Afina
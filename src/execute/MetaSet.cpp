@@ -0,0 +1,59 @@
+#include <afina/Storage.h>
+#include <afina/execute/InsertCommand.h>
+#include <afina/execute/MetaSet.h>
+
+namespace Afina {
+namespace Execute {
+
+// memcached meta protocol, see MetaSet.h
+void MetaSet::Execute(Storage &storage, const std::string &args, std::string &out) {
+    uint32_t expire = InsertCommand::ExpireTime(_expire);
+    const char *code = "NS";
+    bool stored = false;
+    uint64_t cas = 0;
+    if (_cas != 0) {
+        switch (storage.CompareAndSet(_key, args, _flags, expire, _cas, &cas)) {
+        case Storage::Status::STORED:
+            stored = true;
+            break;
+        case Storage::Status::EXISTS:
+            code = "EX";
+            break;
+        case Storage::Status::NOT_FOUND:
+            code = "NF";
+            break;
+        default:
+            break;
+        }
+    } else {
+        switch (_mode) {
+        case ADD:
+            stored = storage.PutIfAbsent(_key, args, _flags, expire, &cas);
+            break;
+        case REPLACE:
+            stored = storage.Set(_key, args, _flags, expire, &cas);
+            break;
+        case APPEND:
+            stored = storage.Append(_key, args, &cas);
+            break;
+        case PREPEND:
+            stored = storage.Prepend(_key, args, &cas);
+            break;
+        default:
+            stored = storage.Put(_key, args, _flags, expire, &cas);
+        }
+    }
+
+    out.clear();
+    if (stored && (_options & QUIET)) {
+        return;
+    }
+    out.append(stored ? "HD" : code, 2);
+    if (stored && (_options & RETURN_CAS)) {
+        _append_flag(out, 'c', cas);
+    }
+    _append_common(out);
+}
+
+} // namespace Execute
+} // namespace Afina
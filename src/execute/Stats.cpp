@@ -1,14 +1,34 @@
 #include <afina/Storage.h>
+#include <afina/execute/Counters.h>
 #include <afina/execute/Stats.h>
 
-#include <iostream>
-#include <iterator>
-#include <sstream>
+#include <cstdint>
+#include <utility>
+#include <vector>
 
 namespace Afina {
 namespace Execute {
 
-void Stats::Execute(Storage &storage, const std::string &args, std::string &out) { out.assign("END"); }
+// memcached protocol: "stats" returns "STAT <name> <value>\r\n" line per statistic, followed by "END"
+void Stats::Execute(Storage &storage, const std::string &args, std::string &out) {
+    std::vector<std::pair<std::string, uint64_t>> stats;
+    Counters::GetStats(stats);
+    storage.GetStats(stats);
+
+    out.clear();
+    for (auto &stat : stats) {
+        char buffer[20];
+        char *pos = buffer + sizeof(buffer);
+        uint64_t value = stat.second;
+        do {
+            *--pos = '0' + value % 10;
+            value /= 10;
+        } while (value != 0);
+        out.append("STAT ", 5).append(stat.first).append(" ", 1).append(pos, buffer + sizeof(buffer) - pos);
+        out.append("\r\n", 2);
+    }
+    out.append("END", 3); // networking layer should add the last \r\n
+}
 
 } // namespace Execute
 } // namespace Afina
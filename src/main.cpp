@@ -22,6 +22,7 @@
 #include "network/st_coroutine/ServerImpl.h"
 #include "network/st_nonblocking/ServerImpl.h"
 
+#include "storage/LockFreeCache.h"
 #include "storage/SimpleLRU.h"
 #include "storage/ThreadSafeSimpleLRU.h"
 #include "storage/StripedLRU.h"
@@ -53,13 +54,45 @@ public:
             storage_type = options["storage"].as<std::string>();
         }
 
+        // Storage type could be followed by the eviction policy: <type>[:<policy>]
+        using Policy = Afina::Backend::SimpleLRU::Policy;
+        Policy policy = Policy::LRU;
+        std::size_t policy_pos = storage_type.find(':');
+        if (policy_pos != std::string::npos) {
+            std::string policy_name = storage_type.substr(policy_pos + 1);
+            storage_type.resize(policy_pos);
+            if (policy_name == "lru") {
+                policy = Policy::LRU;
+            } else if (policy_name == "clock") {
+                policy = Policy::CLOCK;
+            } else if (policy_name == "slru") {
+                policy = Policy::SLRU;
+            } else if (policy_name == "2q") {
+                policy = Policy::TWO_Q;
+            } else if (policy_name == "arc") {
+                policy = Policy::ARC;
+            } else {
+                throw std::runtime_error("Unknown eviction policy");
+            }
+        }
+
+        const bool admission = options.count("tinylfu") > 0;
+        const bool inline_values = options.count("inline") > 0;
+        const std::size_t memory_limit = 16 * 1024 * 1024UL;
         if (storage_type == "st_lru") {
-            storage = std::make_shared<Afina::Backend::SimpleLRU>();
+            storage = std::make_shared<Afina::Backend::SimpleLRU>(memory_limit, policy, admission);
         } else if (storage_type == "mt_lru") {
-            storage = std::make_shared<Afina::Backend::ThreadSafeSimplLRU>();
+            storage = std::make_shared<Afina::Backend::ThreadSafeSimplLRU>(memory_limit, policy, admission, nullptr,
+                                                                           inline_values);
         } else if (storage_type == "mt_slru") {
             storage = std::shared_ptr<Afina::Backend::StripedLRU>(
-                    Afina::Backend::StripedLRU::BuildStripedLRU()); 
+                    Afina::Backend::StripedLRU::BuildStripedLRU(memory_limit, 4, policy, admission, false,
+                                                                inline_values));
+        } else if (storage_type == "mt_fcslru") {
+            storage = std::shared_ptr<Afina::Backend::StripedLRU>(
+                Afina::Backend::StripedLRU::BuildStripedLRU(memory_limit, 4, policy, admission, true, inline_values));
+        } else if (storage_type == "mt_lockfree") {
+            storage = std::make_shared<Afina::Backend::LockFreeCache>(memory_limit);
         } else {
             throw std::runtime_error("Unknown storage type");
         }
@@ -137,6 +170,8 @@ int main(int argc, char **argv) {
         // and simplify validation below
         options.add_options()("s,storage", "Type of storage service to use", cxxopts::value<std::string>());
         options.add_options()("n,network", "Type of network service to use", cxxopts::value<std::string>());
+        options.add_options()("tinylfu", "Enable W-TinyLFU admission filter of the storage");
+        options.add_options()("inline", "Serve small values of mt_lru, mt_slru and mt_fcslru without locking");
         options.add_options()("h,help", "Print usage info");
         options.parse(argc, argv);
 
@@ -20,6 +20,7 @@
 
 #include <afina/Storage.h>
 #include <afina/execute/Command.h>
+#include <afina/execute/Counters.h>
 #include <afina/logging/Service.h>
 #include <afina/concurrency/Executor.h>
 
@@ -114,7 +115,7 @@ void ServerImpl::OnRun() {
     std::size_t arg_remains;
     Protocol::Parser parser;
     std::string argument_for_command;
-    std::unique_ptr<Execute::Command> command_to_execute;
+    Execute::Command *command_to_execute = nullptr;
     Afina::Concurrency::Executor executor("executor");
     executor.Start();
     while (running.load()) {
@@ -181,12 +182,17 @@ void ServerImpl::Worker(int client_socket) {
     std::size_t arg_remains;
     Protocol::Parser parser;
     std::string argument_for_command;
-    std::unique_ptr<Execute::Command> command_to_execute;
+    Execute::Command *command_to_execute = nullptr;
     try {
         int readed_bytes = -1;
         char client_buffer[4096];
-        while ((readed_bytes = read(client_socket, client_buffer, sizeof(client_buffer))) > 0) {
+        // Set once the command closing the connection is done, the rest of the input is dropped
+        bool quit = false;
+        while (!quit && (readed_bytes = read(client_socket, client_buffer, sizeof(client_buffer))) > 0) {
             _logger->debug("Got {} bytes from socket", readed_bytes);
+            Execute::Counters::Add(Execute::Counters::BYTES_READ, readed_bytes);
+            // Input is consumed by moving the offset, so keys of the parsed command stay where they are
+            std::size_t parsed_off = 0;
             // Single block of data readed from the socket could trigger inside actions a multiple times,
             // for example:
             // - read#0: [<command1 start>]
@@ -196,12 +202,12 @@ void ServerImpl::Worker(int client_socket) {
                 // There is no command yet
                 if (!command_to_execute) {
                     std::size_t parsed = 0;
-                    if (parser.Parse(client_buffer, readed_bytes, parsed)) {
+                    if (parser.Parse(client_buffer + parsed_off, readed_bytes, parsed)) {
                         // There is no command to be launched, continue to parse input stream
                         // Here we are, current chunk finished some command, process it
                         _logger->debug("Found new command: {} in {} bytes", parser.Name(), parsed);
                         command_to_execute = parser.Build(arg_remains);
-                        if (arg_remains > 0) {
+                        if (arg_remains > 0 && !parser.Binary()) {
                             arg_remains += 2;
                         }
                     }
@@ -210,7 +216,7 @@ void ServerImpl::Worker(int client_socket) {
                     if (parsed == 0) {
                         break;
                     } else {
-                        std::memmove(client_buffer, client_buffer + parsed, readed_bytes - parsed);
+                        parsed_off += parsed;
                         readed_bytes -= parsed;
                     }
                 }
@@ -220,11 +226,11 @@ void ServerImpl::Worker(int client_socket) {
                     _logger->debug("Fill argument: {} bytes of {}", readed_bytes, arg_remains);
                     // There is some parsed command, and now we are reading argument
                     std::size_t to_read = std::min(arg_remains, std::size_t(readed_bytes));
-                    argument_for_command.append(client_buffer, to_read);
+                    argument_for_command.append(client_buffer + parsed_off, to_read);
 
-                    std::memmove(client_buffer, client_buffer + to_read, readed_bytes - to_read);
                     arg_remains -= to_read;
                     readed_bytes -= to_read;
+                    parsed_off += to_read;
                 }
 
                 // Thre is command & argument - RUN!
@@ -232,26 +238,35 @@ void ServerImpl::Worker(int client_socket) {
                     _logger->debug("Start command execution");
 
                     std::string result;
-                    if (argument_for_command.size()) {
+                    if (argument_for_command.size() && !parser.Binary()) {
                         argument_for_command.resize(argument_for_command.size() - 2);
                     }
                     command_to_execute->Execute(*pStorage, argument_for_command, result);
 
-                    // Send response
-                    result += "\r\n";
-                    if (send(client_socket, result.data(), result.size(), 0) <= 0) {
-                        throw std::runtime_error("Failed to send response");
+                    // Send response, quiet commands could have none
+                    if (!parser.Binary() && !result.empty()) {
+                        result += "\r\n";
+                    }
+                    if (!result.empty()) {
+                        if (send(client_socket, result.data(), result.size(), 0) <= 0) {
+                            throw std::runtime_error("Failed to send response");
+                        }
+                        Execute::Counters::Add(Execute::Counters::BYTES_WRITTEN, result.size());
                     }
 
                     // Prepare for the next command
-                    command_to_execute.reset();
+                    quit = command_to_execute->ClosesConnection();
+                    command_to_execute = nullptr;
                     argument_for_command.resize(0);
                     parser.Reset();
+                    if (quit) {
+                        break;
+                    }
                 }
             } // while (readed_bytes)
         }
 
-        if (readed_bytes == 0) {
+        if (quit || readed_bytes == 0) {
             _logger->debug("Connection closed");
         } else {
             throw std::runtime_error(std::string(strerror(errno)));
@@ -1,6 +1,8 @@
 #include "Connection.h"
 #include "ServerImpl.h"
 
+#include <afina/execute/Counters.h>
+
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/uio.h>
@@ -14,6 +16,7 @@ namespace STnonblock {
 void Connection::Start() { 
     _is_alive = true;
     read_off = write_off = 0;
+    command_to_execute = nullptr;
     response_only = false;
     _event.events = EPOLLIN | EPOLLRDHUP | EPOLLERR;
     responses.clear();    
@@ -40,6 +43,7 @@ void Connection::DoRead() {
         int readed_bytes = read(client_socket, client_buffer + read_off, sizeof(client_buffer) - read_off);
         if (readed_bytes > 0) {
             _logger->debug("Got {} bytes from socket, {} were before", readed_bytes, read_off);
+            Execute::Counters::Add(Execute::Counters::BYTES_READ, readed_bytes);
             readed_bytes += read_off;
             std::size_t parsed_off = 0;
             // Single block of data readed from the socket could trigger inside actions 
@@ -57,7 +61,7 @@ void Connection::DoRead() {
                         // Here we are, current chunk finished some command, process it
                         _logger->debug("Found new command: {} in {} bytes", parser.Name(), parsed);
                         command_to_execute = parser.Build(arg_remains);
-                        if (arg_remains > 0) {
+                        if (arg_remains > 0 && !parser.Binary()) {
                             arg_remains += 2;
                         }
                     } else {
@@ -98,25 +102,41 @@ void Connection::DoRead() {
                     _logger->debug("Start command execution");
 
                     std::string result;
-                    if (argument_for_command.size()) {
+                    if (argument_for_command.size() && !parser.Binary()) {
                         argument_for_command.resize(argument_for_command.size() - 2);
                     }
                     command_to_execute->Execute(*pStorage, argument_for_command, result);
+                    bool quit = command_to_execute->ClosesConnection();
 
-                    // Send response
-                    result += "\r\n";
-                    responses.push_back(result);
-                    if (responses.size() >= Connection::OUTQUE_HIGH) {
-                        _event.events &= ~EPOLLIN;
+                    // Send response, quiet commands could have none
+                    if (!parser.Binary() && !result.empty()) {
+                        result += "\r\n";
                     }
-                    if (!(_event.events & EPOLLOUT)) {
-                        _event.events |= EPOLLOUT;
+                    if (!result.empty()) {
+                        responses.push_back(result);
+                        if (responses.size() >= Connection::OUTQUE_HIGH) {
+                            _event.events &= ~EPOLLIN;
+                        }
+                        if (!(_event.events & EPOLLOUT)) {
+                            _event.events |= EPOLLOUT;
+                        }
                     }
 
                     // Prepare for the next command
-                    command_to_execute.reset();
+                    command_to_execute = nullptr;
                     argument_for_command.resize(0);
                     parser.Reset();
+
+                    if (quit) {
+                        // Rest of the input is dropped, connection is closed once the replies are sent
+                        _event.events &= ~EPOLLIN;
+                        shutdown(client_socket, SHUT_RD);
+                        response_only = true;
+                        if (responses.empty()) {
+                            _is_alive = false;
+                        }
+                        readed_bytes = 0;
+                    }
                 }
             } // while (readed_bytes > 0)
             // If we processed all input and nothing is left to store in the buffer
@@ -162,6 +182,7 @@ void Connection::DoWrite() {
 
     int written_bytes{0};
     if ((written_bytes = writev(client_socket, iovecs, to_write)) > 0) {
+        Execute::Counters::Add(Execute::Counters::BYTES_WRITTEN, written_bytes);
         _logger->debug("WRITE   {} {}", responses.size(), written_bytes);
         for (std::size_t i = 0; i < to_write; ++i) {
             if (written_bytes >= iovecs[i].iov_len) {
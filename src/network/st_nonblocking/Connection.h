@@ -56,7 +56,8 @@ private:
     std::size_t arg_remains;
     Protocol::Parser parser;
     std::string argument_for_command;
-    std::unique_ptr<Execute::Command> command_to_execute;
+    // Command is built inside the parser and belongs to it
+    Execute::Command *command_to_execute;
     
     std::deque<std::string> responses;
     std::size_t write_off;
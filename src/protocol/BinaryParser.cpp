@@ -0,0 +1,126 @@
+#include "BinaryParser.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#include <afina/Key.h>
+#include <afina/execute/Binary.h>
+#include <afina/execute/Counters.h>
+
+namespace Afina {
+namespace Protocol {
+
+using Execute::Binary;
+
+constexpr std::size_t BinaryParser::COMMAND_SIZE;
+
+BinaryParser::~BinaryParser() { _destroy_command(); }
+
+// See BinaryParser.h
+bool BinaryParser::Parse(const char *input, const size_t size, size_t &parsed) {
+    static_assert(sizeof(header) == Binary::HEADER_SIZE, "Header must fit its buffer");
+    parsed = 0;
+    if (parse_complete) {
+        return true;
+    }
+
+    if (header_size < Binary::HEADER_SIZE) {
+        parsed = std::min(Binary::HEADER_SIZE - header_size, size);
+        std::memcpy(header + header_size, input, parsed);
+        header_size += parsed;
+        if (header_size < Binary::HEADER_SIZE) {
+            return false;
+        }
+        if (static_cast<uint8_t>(header[Binary::MAGIC]) != Binary::REQUEST) {
+            throw std::runtime_error("Invalid magic byte of the binary request");
+        }
+        extras_size = static_cast<uint8_t>(header[Binary::EXTRAS_LENGTH]);
+        key_size = Binary::Load(header + Binary::KEY_LENGTH, 2);
+        std::size_t total = Binary::Load(header + Binary::BODY_LENGTH, 4);
+        if (extras_size + key_size > total) {
+            throw std::runtime_error("Body of the binary request is shorter than its extras and key");
+        }
+        value_size = total - extras_size - key_size;
+    }
+
+    // Extras and key usually come whole and are used in place
+    std::size_t need = extras_size + key_size;
+    if (scratch.empty() && size - parsed >= need) {
+        body = input + parsed;
+        parsed += need;
+    } else {
+        std::size_t count = std::min(need - scratch.size(), size - parsed);
+        scratch.append(input + parsed, count);
+        parsed += count;
+        if (scratch.size() < need) {
+            return false;
+        }
+        body = scratch.data();
+    }
+
+    if (value_size > 0 && body != scratch.data()) {
+        scratch.assign(body, need);
+        body = scratch.data();
+    }
+    parse_complete = true;
+    return true;
+}
+
+// See BinaryParser.h
+Execute::Command *BinaryParser::Build(size_t &body_size) {
+    static_assert(sizeof(Binary) <= COMMAND_SIZE, "Command must fit into the parser");
+    if (!parse_complete) {
+        return nullptr;
+    }
+
+    body_size = value_size;
+    switch (header[Binary::OPCODE]) {
+    case Binary::GET:
+    case Binary::GETQ:
+    case Binary::GETK:
+    case Binary::GETKQ:
+        Execute::Counters::Add(Execute::Counters::CMD_GET);
+        break;
+    case Binary::SET:
+    case Binary::SETQ:
+    case Binary::ADD:
+    case Binary::ADDQ:
+    case Binary::REPLACE:
+    case Binary::REPLACEQ:
+    case Binary::APPEND:
+    case Binary::APPENDQ:
+    case Binary::PREPEND:
+    case Binary::PREPENDQ:
+        Execute::Counters::Add(Execute::Counters::CMD_SET);
+        break;
+    default:
+        break;
+    }
+    _destroy_command();
+    command = new (&command_storage)
+        Binary(header[Binary::OPCODE], Key(body + extras_size, key_size), body, extras_size,
+               Binary::Load(header + Binary::OPAQUE, 4), Binary::Load(header + Binary::CAS, 8));
+    return command;
+}
+
+// See BinaryParser.h
+void BinaryParser::Reset() {
+    _destroy_command();
+    header_size = 0;
+    extras_size = key_size = value_size = 0;
+    body = nullptr;
+    scratch.clear();
+    parse_complete = false;
+}
+
+void BinaryParser::_destroy_command() {
+    if (command != nullptr) {
+        command->~Command();
+        command = nullptr;
+    }
+}
+
+} // namespace Protocol
+} // namespace Afina
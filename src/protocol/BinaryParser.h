@@ -0,0 +1,84 @@
+#ifndef AFINA_PROTOCOL_BINARY_PARSER_H
+#define AFINA_PROTOCOL_BINARY_PARSER_H
+
+#include <string>
+#include <type_traits>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Afina {
+namespace Execute {
+class Command;
+} // namespace Execute
+namespace Protocol {
+
+/**
+ * # Memcached binary protocol parser
+ * Parses out fixed header, extras and key of the request, see Execute::Binary. Value of the request is
+ * the command argument, Build reports its size, so the connection reads it as for the text commands, but
+ * without the line end. Parser is used by Parser, which hands over requests starting with the magic byte
+ */
+class BinaryParser {
+public:
+    BinaryParser() : command(nullptr) { Reset(); }
+    ~BinaryParser();
+
+    BinaryParser(const BinaryParser &) = delete;
+    BinaryParser &operator=(const BinaryParser &) = delete;
+
+    /**
+     * Push given bytes into parser input, see Parser::Parse
+     *
+     * @param input bytes to be added to the parsed input
+     * @param size number of bytes in the input buffer that could be read
+     * @param parsed output parameter tells how many bytes was consumed from the input
+     * @return true if header, extras and key of the request have been parsed out
+     */
+    bool Parse(const char *input, const size_t size, size_t &parsed);
+
+    /**
+     * Builds command in place, see Parser::Build. Key refers to the input of the Parse call which
+     * completed the request, unless it was split between calls or the value follows
+     *
+     * @param body_size output parameter, size of the value to read
+     */
+    Execute::Command *Build(size_t &body_size);
+
+    /**
+     * Reset parser so that it could be used to parse out new request
+     */
+    void Reset();
+
+private:
+    // Size of the storage commands are built in
+    static constexpr std::size_t COMMAND_SIZE = 96;
+
+    // Destroys command built in place if there is one
+    void _destroy_command();
+
+    // Header of the request, collected across Parse calls
+    char header[24];
+    std::size_t header_size;
+
+    // Sizes of the request body parts
+    std::size_t extras_size;
+    std::size_t key_size;
+    std::size_t value_size;
+
+    // Extras followed by the key, either in the input or in the scratch
+    const char *body;
+    // Extras and key split between Parse calls or followed by the value, which is read after the input
+    // buffer is reused
+    std::string scratch;
+    bool parse_complete;
+
+    // Command built in command_storage, nullptr if there is none
+    Execute::Command *command;
+    std::aligned_storage<COMMAND_SIZE>::type command_storage;
+};
+
+} // namespace Protocol
+} // namespace Afina
+
+#endif // AFINA_PROTOCOL_BINARY_PARSER_H
@@ -1,198 +1,448 @@
 #include "Parser.h"
 
-#include <iostream>
-#include <sstream>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <new>
 #include <stdexcept>
 
 #include <afina/execute/Add.h>
 #include <afina/execute/Append.h>
+#include <afina/execute/Binary.h>
+#include <afina/execute/Cas.h>
 #include <afina/execute/Command.h>
+#include <afina/execute/Counters.h>
+#include <afina/execute/Decr.h>
 #include <afina/execute/Delete.h>
 #include <afina/execute/Get.h>
+#include <afina/execute/Incr.h>
+#include <afina/execute/MetaDelete.h>
+#include <afina/execute/MetaGet.h>
+#include <afina/execute/MetaNoop.h>
+#include <afina/execute/MetaSet.h>
+#include <afina/execute/Prepend.h>
 #include <afina/execute/Set.h>
 #include <afina/execute/Stats.h>
 
 namespace Afina {
 namespace Protocol {
 
+namespace {
+
+/**
+ * Perfect hash of the command names: slot is distinct for every known command, so the name is recognized
+ * by one table lookup and one comparison. Names are at least two chars long, shorter one is unknown anyway
+ */
+constexpr std::size_t NameSlot(const char *name, std::size_t size) {
+    return (size + static_cast<unsigned char>(name[0]) + 10 * static_cast<unsigned char>(name[1])) & 31;
+}
+
+struct Name {
+    const char *name;
+    std::size_t size;
+};
+
+// Names of the commands, indexed by the command code
+constexpr Name NAMES[] = {{"set", 3},  {"add", 3},  {"append", 6}, {"prepend", 7}, {"cas", 3},
+                          {"get", 3},  {"gets", 4}, {"incr", 4},   {"decr", 4},    {"stats", 5},
+                          {"mg", 2},   {"ms", 2},   {"md", 2},     {"mn", 2}};
+
+constexpr std::size_t UNKNOWN = sizeof(NAMES) / sizeof(NAMES[0]);
+
+// Command codes indexed by the name slot, slots no name hashes to are UNKNOWN
+constexpr uint8_t SLOTS[32] = {9,       UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, 2,
+                               0,       UNKNOWN, UNKNOWN, 3,       1,       11,      UNKNOWN, UNKNOWN,
+                               4,       UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, 10,      UNKNOWN, 12,
+                               UNKNOWN, 7,       8,       13,      5,       6,       UNKNOWN, UNKNOWN};
+
+// True if every name starting from the given one is in its slot of SLOTS
+constexpr bool SlotsMatch(std::size_t code) {
+    return code == UNKNOWN || (SLOTS[NameSlot(NAMES[code].name, NAMES[code].size)] == code && SlotsMatch(code + 1));
+}
+static_assert(SlotsMatch(0), "Every command name must hash to the slot of its code");
+
+// Max size of the given types
+template <typename T> constexpr std::size_t MaxSize() { return sizeof(T); }
+template <typename T, typename U, typename... Rest> constexpr std::size_t MaxSize() {
+    return sizeof(T) > MaxSize<U, Rest...>() ? sizeof(T) : MaxSize<U, Rest...>();
+}
+
+// Skips spaces, then takes the token up to the next space or the end of the line
+bool NextToken(const char *&pos, const char *end, const char *&token, std::size_t &size) {
+    while (pos < end && *pos == ' ') {
+        pos++;
+    }
+    if (pos == end) {
+        return false;
+    }
+    const char *space = static_cast<const char *>(std::memchr(pos, ' ', end - pos));
+    token = pos;
+    pos = space != nullptr ? space : end;
+    size = pos - token;
+    return true;
+}
+
+// Parses decimal number not greater than max
+uint64_t ParseNumber(const char *token, std::size_t size, uint64_t max, const char *field) {
+    if (size == 0) {
+        throw std::runtime_error(std::string("Invalid ") + field + " field");
+    }
+    uint64_t result = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+        unsigned digit = static_cast<unsigned char>(token[i]) - '0';
+        if (digit > 9) {
+            throw std::runtime_error(std::string("Invalid ") + field + " field");
+        }
+        if (result > (max - digit) / 10) {
+            throw std::runtime_error(std::string(field) + " field overflow");
+        }
+        result = result * 10 + digit;
+    }
+    return result;
+}
+
+// Parses expiration time, negative one means item is expired already
+int32_t ParseExpire(const char *token, std::size_t size) {
+    if (size > 0 && token[0] == '-') {
+        return -int64_t(ParseNumber(token + 1, size - 1, uint64_t(INT32_MAX) + 1, "Expire time"));
+    }
+    return ParseNumber(token, size, INT32_MAX, "Expire time");
+}
+
+} // namespace
+
+constexpr std::size_t Parser::MAX_LINE;
+constexpr std::size_t Parser::COMMAND_SIZE;
+
+Parser::~Parser() { _destroy_command(); }
+
 // See Parse.h
 bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
-    size_t pos;
     parsed = 0;
+    if (parse_complete) {
+        return true;
+    }
+    if (binary || (line.empty() && size > 0 && static_cast<uint8_t>(input[0]) == Execute::Binary::REQUEST)) {
+        if (!binary) {
+            binary = true;
+            name.assign("binary");
+        }
+        parse_complete = binary_parser.Parse(input, size, parsed);
+        return parse_complete;
+    }
 
-    for (pos = 0; pos < size && !parse_complete; pos++) {
-        char c = input[pos];
-        // std::cout << "[" << pos << "] '" << c << "': state=" << int(state) << std::endl;
-
-        switch (state) {
-        case State::sName: {
-            if (c == ' ' || c == '\r') {
-                // std::cout << "parser debug: name='" << name << "'" << std::endl;
-                if (name == "set" || name == "add" || name == "append" || name == "prepend") {
-                    state = State::spKey;
-                } else if (name == "get" || name == "gets") {
-                    state = State::sgKey;
-                } else if (name == "stats") {
-                    state = State::sLF;
-                    continue;
-                } else {
-                    throw std::runtime_error("Unknown command name: " + name);
-                }
-            } else {
-                name.push_back(c);
-            }
-            break;
+    // memchr is vectorized by libc, so the line end is found 16 or 32 bytes per step
+    const char *end = static_cast<const char *>(std::memchr(input, '\n', size));
+    if (end == nullptr) {
+        if (line.size() + size > MAX_LINE) {
+            throw std::runtime_error("Command line is too long");
         }
+        line.append(input, size);
+        parsed = size;
+        return false;
+    }
 
-        case State::spKey: {
-            if (c == ' ') {
-                state = State::spFlags;
-                keys.push_back(curKey);
-                // std::cout << "parser debug: key[" << keys.size() - 1 << "]='" << curKey << "'" << std::endl;
-            } else {
-                curKey.push_back(c);
-            }
-            break;
-        }
-
-        case State::sgKey: {
-            if (c == '\r') {
-                keys.push_back(curKey);
-                // std::cout << "parser debug: total '" << keys.size() << " keys" << std::endl;
-
-                if (keys.size() == 0) {
-                    throw std::runtime_error("Client provides no key to retrive");
-                }
-
-                curKey.clear();
-                state = State::sLF;
-            } else if (c == ' ') {
-                // std::cout << "parser debug: key[" << keys.size() << "]='" << curKey << "'" << std::endl;
-                state = State::sgKey;
-                keys.push_back(curKey);
-                curKey.clear();
-            } else {
-                curKey.push_back(c);
+    parsed = end - input + 1;
+    if (line.empty()) {
+        _parse_line(input, end - input);
+        if (bytes > 0) {
+            // Value is read after the input buffer is reused, so the key and opaque token must survive it
+            line.assign(keys[0].data(), keys[0].size());
+            if (opaque_size > 0) {
+                line.append(opaque, opaque_size);
+                opaque = line.data() + keys[0].size();
             }
-            break;
-        }
-
-        case State::spFlags: {
-            if (c == ' ') {
-                negative = false;
-                state = State::spExprTimeStart;
-                // std::cout << "parser debug: flags='" << flags << "'" << std::endl;
-            } else if (c >= '0' && c <= '9') {
-                uint32_t f = (flags * 10) + (c - '0');
-                if (f < flags) {
-                    // Overflow
-                    throw std::runtime_error("Flags field overflow");
-                }
-                flags = f;
-            }
-            break;
+            keys[0] = Key(line.data(), keys[0].size(), keys[0].hash());
         }
+    } else {
+        if (line.size() + (end - input) > MAX_LINE) {
+            throw std::runtime_error("Command line is too long");
+        }
+        line.append(input, end - input);
+        _parse_line(line.data(), line.size());
+    }
+    parse_complete = true;
+    return true;
+}
 
-        case State::spExprTimeStart: {
-            if (c == '-') {
-                negative = true;
-                state = State::spExprTime;
-            } else if (c >= '0' && c <= '9') {
-                exprtime = (c - '0');
-                state = State::spExprTime;
-            }
-            break;
-        }
-
-        case State::spExprTime: {
-            if (c == ' ') {
-                state = State::spBytes;
-                // std::cout << "parser debug: ExprTime='" << exprtime << "'" << std::endl;
-            } else if (c >= '0' && c <= '9') {
-                int32_t et = exprtime;
-                if (negative) {
-                    et -= (c - '0');
-                    if (et > exprtime) {
-                        throw std::runtime_error("Expire time field overflow");
-                    }
-                } else {
-                    et += (c - '0');
-                    if (et < exprtime) {
-                        throw std::runtime_error("Expire time field overflow");
-                    }
-                }
-                exprtime = et;
-            }
-            break;
-        }
-
-        case State::spBytes: {
-            if (c == '\r') {
-                state = State::sLF;
-                // std::cout << "parser debug: bytes='" << bytes << "'" << std::endl;
-            } else if (c >= '0' && c <= '9') {
-                uint32_t b = (bytes * 10) + (c - '0');
-                if (b < bytes) {
-                    // Overflow
-                    throw std::runtime_error("Bytes field overflow");
-                }
-                bytes = b;
-            }
-            break;
+void Parser::_parse_line(const char *begin, std::size_t size) {
+    static_assert(cUnknown == UNKNOWN, "Command codes must index NAMES");
+    if (size > 0 && begin[size - 1] == '\r') {
+        size--;
+    }
+    const char *pos = begin, *end = begin + size;
+    const char *token;
+    std::size_t length;
+    if (!NextToken(pos, end, token, length)) {
+        throw std::runtime_error("Empty command line");
+    }
+    code = length >= 2 ? Code(SLOTS[NameSlot(token, length)]) : cUnknown;
+    if (code == cUnknown || NAMES[code].size != length || std::memcmp(NAMES[code].name, token, length) != 0) {
+        throw std::runtime_error("Unknown command name: " + std::string(token, length));
+    }
+    name.assign(token, length);
+
+    // Takes the next mandatory argument of the command
+    auto argument = [&](const char *what) {
+        if (!NextToken(pos, end, token, length)) {
+            throw std::runtime_error(std::string("Command ") + NAMES[code].name + " expects " + what);
         }
+    };
 
-        case State::sLF: {
-            if (c == '\n') {
-                parse_complete = true;
-            } else {
-                std::stringstream err;
-                err << "Invalid char " << (int)c << " at position " << (parsed + pos) << ", \\n expected";
-                throw std::runtime_error(err.str());
-            }
-            break;
+    switch (code) {
+    case cSet:
+    case cAdd:
+    case cAppend:
+    case cPrepend:
+    case cCas: {
+        argument("key");
+        keys.push_back(Key(token, length));
+        argument("flags");
+        flags = ParseNumber(token, length, UINT32_MAX, "Flags");
+        argument("expire time");
+        exprtime = ParseExpire(token, length);
+        argument("bytes");
+        bytes = ParseNumber(token, length, UINT32_MAX, "Bytes");
+        if (code == cCas) {
+            argument("cas");
+            cas = ParseNumber(token, length, UINT64_MAX, "Cas");
+        }
+        break;
+    }
+
+    case cGet:
+    case cGets: {
+        while (NextToken(pos, end, token, length)) {
+            keys.push_back(Key(token, length));
         }
+        if (keys.empty()) {
+            throw std::runtime_error("Client provides no key to retrive");
+        }
+        return;
+    }
+
+    case cIncr:
+    case cDecr: {
+        argument("key");
+        keys.push_back(Key(token, length));
+        argument("delta");
+        delta = ParseNumber(token, length, UINT64_MAX, "Delta");
+        break;
+    }
+
+    case cMg:
+    case cMs:
+    case cMd: {
+        argument("key");
+        keys.push_back(Key(token, length));
+        if (code == cMs) {
+            argument("bytes");
+            bytes = ParseNumber(token, length, UINT32_MAX, "Bytes");
+        }
+        while (NextToken(pos, end, token, length)) {
+            _parse_meta_flag(token, length);
+        }
+        if (cas != 0 && mode != Execute::MetaSet::SET && mode != Execute::MetaSet::REPLACE) {
+            throw std::runtime_error("Cas is only compared in set and replace modes");
+        }
+        return;
+    }
 
-        default:
-            throw std::runtime_error("Unknown state");
+    case cMn:
+    case cStats:
+    default:
+        break;
+    }
+
+    // Replies are sent anyway, so noreply is accepted and ignored as before
+    if (NextToken(pos, end, token, length)) {
+        if (length != 7 || std::memcmp(token, "noreply", 7) != 0 || NextToken(pos, end, token, length)) {
+            throw std::runtime_error("Unexpected argument: " + std::string(token, length));
         }
     }
+}
 
-    parsed += pos;
-    return parse_complete;
+void Parser::_parse_meta_flag(const char *token, std::size_t size) {
+    using Execute::MetaCommand;
+    using Execute::MetaSet;
+    const char *value = token + 1;
+    const std::size_t value_size = size - 1;
+
+    // Flags with token set the field, the others are options of the command
+    uint32_t option = 0;
+    switch (token[0]) {
+    case 'O':
+        if (value_size > MetaCommand::MAX_OPAQUE) {
+            throw std::runtime_error("Opaque token is too long");
+        }
+        opaque = value;
+        opaque_size = value_size;
+        return;
+    case 'q':
+        option = MetaCommand::QUIET;
+        break;
+    case 'k':
+        option = MetaCommand::RETURN_KEY;
+        break;
+    case 'v':
+        option = code == cMg ? MetaCommand::RETURN_VALUE : 0;
+        break;
+    case 'f':
+        option = code == cMg ? MetaCommand::RETURN_FLAGS : 0;
+        break;
+    case 'c':
+        option = code == cMg || code == cMs ? MetaCommand::RETURN_CAS : 0;
+        break;
+    case 's':
+        option = code == cMg ? MetaCommand::RETURN_SIZE : 0;
+        break;
+    case 't':
+        option = code == cMg ? MetaCommand::RETURN_TTL : 0;
+        break;
+    case 'F':
+        if (code == cMs) {
+            flags = ParseNumber(value, value_size, UINT32_MAX, "Flags");
+            return;
+        }
+        break;
+    case 'T':
+        if (code == cMs) {
+            exprtime = ParseExpire(value, value_size);
+            return;
+        }
+        break;
+    case 'C':
+        if (code == cMs) {
+            cas = ParseNumber(value, value_size, UINT64_MAX, "Cas");
+            return;
+        }
+        break;
+    case 'M':
+        if (code == cMs && value_size == 1) {
+            mode = std::toupper(static_cast<unsigned char>(value[0]));
+            if (std::memchr("SERAP", mode, 5) != nullptr) {
+                return;
+            }
+        }
+        break;
+    default:
+        break;
+    }
+    if (option == 0 || value_size != 0) {
+        throw std::runtime_error("Invalid meta flag: " + std::string(token, size));
+    }
+    options |= option;
 }
 
 // See Parse.h
-std::unique_ptr<Execute::Command> Parser::Build(size_t &body_size) const {
-    if (state != State::sLF) {
-        return std::unique_ptr<Execute::Command>(nullptr);
+Execute::Command *Parser::Build(size_t &body_size) {
+    static_assert(MaxSize<Execute::Set, Execute::Add, Execute::Append, Execute::Prepend, Execute::Cas, Execute::Incr,
+                          Execute::Decr, Execute::Get, Execute::Stats, Execute::MetaGet, Execute::MetaSet,
+                          Execute::MetaDelete, Execute::MetaNoop>() <= COMMAND_SIZE,
+                  "Every command must fit into the parser");
+    if (!parse_complete) {
+        return nullptr;
+    }
+    if (binary) {
+        return binary_parser.Build(body_size);
     }
 
     body_size = bytes;
-    if (name == "set") {
-        return std::unique_ptr<Execute::Command>(new Execute::Set(keys[0], flags, exprtime));
-    } else if (name == "add") {
-        return std::unique_ptr<Execute::Command>(new Execute::Add(keys[0], flags, exprtime));
-    } else if (name == "append") {
-        return std::unique_ptr<Execute::Command>(new Execute::Append(keys[0], flags, exprtime));
-    } else if (name == "get") {
-        return std::unique_ptr<Execute::Command>(new Execute::Get(keys));
-    } else if (name == "stats") {
-        return std::unique_ptr<Execute::Command>(new Execute::Stats());
-    } else {
+    switch (code) {
+    case cSet:
+    case cAdd:
+    case cAppend:
+    case cPrepend:
+    case cCas:
+    case cMs:
+        Execute::Counters::Add(Execute::Counters::CMD_SET);
+        break;
+    case cGet:
+    case cGets:
+    case cMg:
+        Execute::Counters::Add(Execute::Counters::CMD_GET, keys.size());
+        break;
+    default:
+        break;
+    }
+
+    _destroy_command();
+    switch (code) {
+    case cSet:
+        command = new (&command_storage) Execute::Set(keys[0], flags, exprtime);
+        break;
+    case cAdd:
+        command = new (&command_storage) Execute::Add(keys[0], flags, exprtime);
+        break;
+    case cAppend:
+        command = new (&command_storage) Execute::Append(keys[0], flags, exprtime);
+        break;
+    case cPrepend:
+        command = new (&command_storage) Execute::Prepend(keys[0], flags, exprtime);
+        break;
+    case cCas:
+        command = new (&command_storage) Execute::Cas(keys[0], flags, exprtime, cas);
+        break;
+    case cIncr:
+        command = new (&command_storage) Execute::Incr(keys[0], delta);
+        break;
+    case cDecr:
+        command = new (&command_storage) Execute::Decr(keys[0], delta);
+        break;
+    case cGet:
+        command = new (&command_storage) Execute::Get(keys);
+        break;
+    case cGets:
+        command = new (&command_storage) Execute::Get(keys, true);
+        break;
+    case cStats:
+        command = new (&command_storage) Execute::Stats();
+        break;
+    case cMg:
+        command = new (&command_storage) Execute::MetaGet(keys[0], options, opaque, opaque_size);
+        break;
+    case cMs:
+        command = new (&command_storage) Execute::MetaSet(keys[0], options, opaque, opaque_size, flags, exprtime,
+                                                          cas, Execute::MetaSet::Mode(mode));
+        break;
+    case cMd:
+        command = new (&command_storage) Execute::MetaDelete(keys[0], options, opaque, opaque_size);
+        break;
+    case cMn:
+        command = new (&command_storage) Execute::MetaNoop();
+        break;
+    default:
         throw std::runtime_error("Unsupported command");
     }
+    return command;
 }
 
 // See Parse.h
 void Parser::Reset() {
-    state = State::sName;
+    _destroy_command();
+    binary_parser.Reset();
+    binary = false;
+    code = cUnknown;
     name.clear();
     keys.clear();
-    curKey.clear();
+    line.clear();
     parse_complete = false;
     flags = 0;
     bytes = 0;
     exprtime = 0;
+    cas = 0;
+    delta = 0;
+    options = 0;
+    opaque = nullptr;
+    opaque_size = 0;
+    mode = Execute::MetaSet::SET;
+}
+
+void Parser::_destroy_command() {
+    if (command != nullptr) {
+        command->~Command();
+        command = nullptr;
+    }
 }
 
 } // namespace Protocol
@@ -1,13 +1,17 @@
 #ifndef AFINA_PROTOCOL_PARSER_H
 #define AFINA_PROTOCOL_PARSER_H
 
-#include <memory>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include <cstddef>
 #include <cstdint>
 
+#include <afina/Key.h>
+
+#include "BinaryParser.h"
+
 namespace Afina {
 namespace Execute {
 class Command;
@@ -16,16 +20,24 @@ namespace Protocol {
 
 /**
  * # Memcached protocol parser
- * Parser supports subset of memcached protocol
+ * Parser supports subset of memcached protocol, including meta commands mg, ms, md and mn, see
+ * Execute::MetaCommand. Request starting with the magic byte 0x80, which never starts a text command, is one
+ * of the binary protocol and handed over to BinaryParser: connection could speak either protocol without any
+ * setup
  */
 class Parser {
 public:
-    Parser() { Reset(); }
+    Parser() : command(nullptr) { Reset(); }
+    ~Parser();
+
+    Parser(const Parser &) = delete;
+    Parser &operator=(const Parser &) = delete;
+
     /**
      * Push given string into parser input. Method returns true if it was a command parsed out
      * from comulative input. In a such case method Build will return new command
      *
-     * @param input sttring to be added to the parsed input
+     * @param input sttring to be added to the parsed input, keys of the command refer to it, see Build
      * @param parsed output parameter tells how many bytes was consumed from the string
      * @return true if command has been parsed out
      */
@@ -45,8 +57,16 @@ public:
     /**
      * Builds new command from parsed input. In case if it wasn't enough input to prse command out
      * method return nullptr
+     *
+     * Command is built in place inside the parser and belongs to it: it is valid until the next Build or
+     * Reset, so the connection processing requests doesn't allocate commands at all.
+     *
+     * Keys and opaque token of the command are not copied: they refer to the input of the Parse call which
+     * completed the command line, so command must be executed before that input is overwritten. Keys of the
+     * line split between Parse calls and keys of the commands waiting for the value are kept by the parser
+     * itself, they are valid until Reset
      */
-    std::unique_ptr<Execute::Command> Build(size_t &body_size) const;
+    Execute::Command *Build(size_t &body_size);
 
     /**
      * Reset parse so that it could be used to parse out new command
@@ -55,21 +75,56 @@ public:
 
     inline const std::string &Name() const { return name; }
 
-private:
     /**
-     * State of the command parser. Prefixes are:
-     * - s: state for PUT and GET commands
-     * - sp: for PUT commands only
-     * - sg: for GET commands only
+     * True if the command being parsed is the binary one. Connection doesn't expect line end after the
+     * value of such command and sends nothing if command has empty reply
      */
-    enum State : uint16_t { sCR, sLF, sName, spKey, spFlags, spExprTimeStart, spExprTime, spBytes, sgKey };
+    inline bool Binary() const { return binary; }
 
-    // Current parser state
-    State state;
+private:
+    /**
+     * Commands parser knows, prefix c stands for code. Name of the command is recognized by the perfect hash,
+     * see Parser.cpp
+     */
+    enum Code : uint8_t {
+        cSet,
+        cAdd,
+        cAppend,
+        cPrepend,
+        cCas,
+        cGet,
+        cGets,
+        cIncr,
+        cDecr,
+        cStats,
+        cMg,
+        cMs,
+        cMd,
+        cMn,
+        cUnknown
+    };
+
+    // Max size of the command line, longer line is a protocol error rather than a reason to grow the buffer
+    static constexpr std::size_t MAX_LINE = 64 * 1024;
+
+    // Size of the storage commands are built in, every command must fit
+    static constexpr std::size_t COMMAND_SIZE = 96;
+
+    // Parses out complete command line, size doesn't include line end
+    void _parse_line(const char *line, std::size_t size);
+
+    // Parses out one flag of the meta command, see Execute::MetaCommand
+    void _parse_meta_flag(const char *token, std::size_t size);
+
+    // Destroys command built in place if there is one
+    void _destroy_command();
+
+    // Code of the command parsed out
+    Code code;
 
     // vrious fields of the command
     std::string name;
-    std::vector<std::string> keys;
+    std::vector<Key> keys;
 
     // <flags> is an arbitrary 16-bit unsigned integer (written out in decimal) that the server stores along with
     // the data and sends back when the item is retrieved. Clients may use this as a bit field to store data-specific
@@ -88,8 +143,34 @@ private:
     // it's followed by an empty data block).
     uint32_t bytes;
 
-    bool negative;
-    std::string curKey;
+    // <cas unique> is a unique 64-bit value of an existing entry. Clients should use the value returned from
+    // the "gets" command when issuing "cas" updates.
+    uint64_t cas;
+
+    // <value> of incr/decr is the decimal representation of a 64-bit unsigned integer to add or substract
+    uint64_t delta;
+
+    // Flags of the meta commands without token, see Execute::MetaCommand::Option
+    uint32_t options;
+
+    // Opaque token of the meta command, refers to the input as keys do
+    const char *opaque;
+    std::size_t opaque_size;
+
+    // Mode of ms, see Execute::MetaSet::Mode
+    char mode;
+
+    // Parser of the binary requests and whether current request is the binary one
+    BinaryParser binary_parser;
+    bool binary;
+
+    // Command built in command_storage, nullptr if there is none
+    Execute::Command *command;
+    std::aligned_storage<COMMAND_SIZE>::type command_storage;
+
+    // Beginning of the command line split between Parse calls, or the key of the command waiting for the
+    // value. Line which came whole is parsed in place
+    std::string line;
     bool parse_complete;
 };
 
@@ -0,0 +1,74 @@
+#ifndef AFINA_STORAGE_CACHE_NODE_H
+#define AFINA_STORAGE_CACHE_NODE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Cache item
+ * Header is followed by key and value bytes in the same allocation:
+ * [CacheNode][key bytes][value bytes ... value_capacity]
+ *
+ * Nodes are linked by ids rather than pointers, id is position in the owner node table. Links, referenced
+ * mark and segment belong to the eviction policy the node is in, see EvictionPolicy.h. Timer links belong
+ * to the expiration timer wheel, see TimerWheel.h
+ */
+struct CacheNode {
+    // Node id meaning "no node", used as null link
+    static constexpr std::uint32_t NIL = UINT32_MAX;
+    // Timer slot of the node without expiration time
+    static constexpr std::uint16_t NO_SLOT = UINT16_MAX;
+
+    // Hash of the key, so index could be rebuilt without rehashing keys
+    std::uint64_t hash;
+    std::uint32_t prev;
+    std::uint32_t next;
+    std::uint32_t key_size;
+    std::uint32_t value_size;
+    // Number of bytes reserved for the value
+    std::uint32_t value_capacity;
+    // Version of the value, changes on every modification
+    std::uint64_t cas;
+    // Opaque client word stored along with the value
+    std::uint32_t flags;
+    // Unix time the node expires at, 0 if it never expires
+    std::uint32_t expire;
+    // Links and slot of the expiration timer, see TimerWheel.h
+    std::uint32_t timer_prev;
+    std::uint32_t timer_next;
+    std::uint16_t timer_slot;
+    // Set on hit by policies tolerating concurrent readers
+    std::atomic<std::uint8_t> referenced;
+    // List of the policy node belongs to
+    std::uint8_t segment;
+    // True if node is in admission window rather than in the main policy
+    std::uint8_t window;
+
+    char *key() { return reinterpret_cast<char *>(this + 1); }
+    char *value() { return key() + key_size; }
+
+    /**
+     * Number of bytes the item takes from the cache memory limit: node allocation including allocator
+     * overhead, plus the item slots in the node table and in the index
+     */
+    static std::size_t Footprint(std::size_t key_size, std::size_t value_size) {
+        // malloc chunk is the requested size plus a word of header rounded up to 16 bytes
+        std::size_t chunk = (sizeof(CacheNode) + key_size + value_size + sizeof(std::size_t) + 15) & ~std::size_t(15);
+        if (chunk < 32) {
+            chunk = 32;
+        }
+        // Node table slot, and index slot with its control byte: index is from 7/16 to 7/8 full
+        return chunk + sizeof(CacheNode *) + 2 * (sizeof(std::uint32_t) + 1);
+    }
+
+    std::size_t Footprint() const { return Footprint(key_size, value_capacity); }
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_CACHE_NODE_H
@@ -0,0 +1,174 @@
+#ifndef AFINA_STORAGE_COMBINING_SIMPLE_LRU_H
+#define AFINA_STORAGE_COMBINING_SIMPLE_LRU_H
+
+#include <string>
+
+#include <afina/concurrency/FlatCombine.h>
+
+#include "ThreadSafeSimpleLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # SimpleLRU synchronized by flat combining
+ * Operations of concurrent callers are published to the combiner, which runs them back to back under
+ * the lock taken once per batch. The combiner lock is the only one: maintenance operations (Shed,
+ * TryReclaim, GetStats) are combined too, so the lock of ThreadSafeSimplLRU is never taken and the cache
+ * could still be a stripe of StripedLRU
+ */
+class CombiningSimpleLRU : public ThreadSafeSimplLRU {
+public:
+    CombiningSimpleLRU(size_t max_size = 1024, Policy policy = Policy::LRU, bool admission = false,
+                       std::shared_ptr<MemoryBudget> budget = nullptr, bool inline_values = false)
+        : ThreadSafeSimplLRU(max_size, policy, admission, std::move(budget), inline_values),
+          _combiner([](Operation *const *ops, std::size_t count) {
+              for (std::size_t i = 0; i < count; ++i) {
+                  ops[i]->run(ops[i]->arg);
+              }
+          }) {}
+    ~CombiningSimpleLRU() {}
+
+    // see SimpleLRU.h
+    bool Put(const Key &key, const std::string &value, uint32_t flags = 0, uint32_t expire = 0,
+             uint64_t *cas = nullptr) override {
+        bool result;
+        _execute([&]() { result = SimpleLRU::Put(key, value, flags, expire, cas); });
+        return result;
+    }
+
+    // see SimpleLRU.h
+    bool PutIfAbsent(const Key &key, const std::string &value, uint32_t flags = 0,
+                     uint32_t expire = 0, uint64_t *cas = nullptr) override {
+        bool result;
+        _execute([&]() { result = SimpleLRU::PutIfAbsent(key, value, flags, expire, cas); });
+        return result;
+    }
+
+    // see SimpleLRU.h
+    bool Set(const Key &key, const std::string &value, uint32_t flags = 0, uint32_t expire = 0,
+             uint64_t *cas = nullptr) override {
+        bool result;
+        _execute([&]() { result = SimpleLRU::Set(key, value, flags, expire, cas); });
+        return result;
+    }
+
+    // see SimpleLRU.h
+    bool Delete(const Key &key) override {
+        bool result;
+        _execute([&]() { result = SimpleLRU::Delete(key); });
+        return result;
+    }
+
+    // see SimpleLRU.h
+    bool Get(const Key &key, std::string &value, uint32_t *flags = nullptr, uint64_t *cas = nullptr,
+             uint32_t *expire = nullptr) override {
+        if (_inline_get(key, value, flags, cas, expire)) {
+            return true;
+        }
+        bool result;
+        _execute([&]() { result = SimpleLRU::Get(key, value, flags, cas, expire); });
+        return result;
+    }
+
+    // see SimpleLRU.h
+    Status CompareAndSet(const Key &key, const std::string &value, uint32_t flags, uint32_t expire,
+                         uint64_t cas, uint64_t *new_cas = nullptr) override {
+        Status result;
+        _execute([&]() { result = SimpleLRU::CompareAndSet(key, value, flags, expire, cas, new_cas); });
+        return result;
+    }
+
+    // see SimpleLRU.h
+    bool Append(const Key &key, const std::string &value, uint64_t *cas = nullptr) override {
+        bool result;
+        _execute([&]() { result = SimpleLRU::Append(key, value, cas); });
+        return result;
+    }
+
+    // see SimpleLRU.h
+    bool Prepend(const Key &key, const std::string &value, uint64_t *cas = nullptr) override {
+        bool result;
+        _execute([&]() { result = SimpleLRU::Prepend(key, value, cas); });
+        return result;
+    }
+
+    // see SimpleLRU.h
+    Status Incr(const Key &key, uint64_t delta, uint64_t &value, uint64_t *cas = nullptr) override {
+        Status result;
+        _execute([&]() { result = SimpleLRU::Incr(key, delta, value, cas); });
+        return result;
+    }
+
+    // see SimpleLRU.h
+    Status Decr(const Key &key, uint64_t delta, uint64_t &value, uint64_t *cas = nullptr) override {
+        Status result;
+        _execute([&]() { result = SimpleLRU::Decr(key, delta, value, cas); });
+        return result;
+    }
+
+    // see SimpleLRU.h, whole batch is one combined operation
+    void GetBatch(std::vector<ReadItem> &items, const uint32_t *which, std::size_t count) override {
+        std::vector<uint32_t> rest;
+        if (InlineValues()) {
+            _inline_get_batch(items, which, count, rest);
+            which = rest.data();
+            count = rest.size();
+            if (count == 0) {
+                return;
+            }
+        }
+        _execute([&]() { SimpleLRU::GetBatch(items, which, count); });
+    }
+
+    // see SimpleLRU.h, whole batch is one combined operation
+    void PutBatch(std::vector<WriteItem> &items, const uint32_t *which, std::size_t count) override {
+        _execute([&]() { SimpleLRU::PutBatch(items, which, count); });
+    }
+
+    // see ThreadSafeSimpleLRU.h
+    std::size_t TryReclaim(std::size_t required) override {
+        std::size_t result = 0;
+        auto fn = [&]() { result = SimpleLRU::Reclaim(required); };
+        Operation op = _operation(fn);
+        _combiner.TryExecute(op);
+        return result;
+    }
+
+    // see SimpleLRU.h
+    std::size_t Shed(std::size_t target, std::size_t limit, std::vector<CacheNode *> &evicted) override {
+        std::size_t result;
+        _execute([&]() { result = SimpleLRU::Shed(target, limit, evicted); });
+        return result;
+    }
+
+    // see SimpleLRU.h
+    void GetStats(std::vector<std::pair<std::string, uint64_t>> &stats) const override {
+        _execute([&]() { SimpleLRU::GetStats(stats); });
+    }
+
+private:
+    // Operation published to the combiner, lives in the caller stack until it is done
+    struct Operation {
+        void (*run)(void *arg);
+        void *arg;
+    };
+
+    // Runs fn() in the combiner, which is possibly the calling thread itself, and waits for it
+    template <typename F> void _execute(F &&fn) const {
+        Operation op = _operation(fn);
+        _combiner.Execute(op);
+    }
+
+    // Wraps fn into the operation calling it
+    template <typename Fn> static Operation _operation(Fn &fn) {
+        return Operation{[](void *arg) { (*static_cast<Fn *>(arg))(); }, &fn};
+    }
+
+    mutable Concurrency::FlatCombine<Operation> _combiner;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_COMBINING_SIMPLE_LRU_H
@@ -0,0 +1,138 @@
+#include "EpochDomain.h"
+
+#include <mutex>
+#include <set>
+#include <utility>
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+std::atomic<std::uint64_t> last_domain_id(0);
+
+// Domains alive right now, exiting thread only releases records of those
+std::mutex live_lock;
+std::set<std::uint64_t> live_domains;
+
+// Records of the current thread in every domain it has used
+struct ThreadRecords {
+    std::vector<std::pair<std::uint64_t, EpochDomain::Record *>> records;
+
+    ~ThreadRecords() {
+        std::lock_guard<std::mutex> lock(live_lock);
+        for (auto &record : records) {
+            if (live_domains.count(record.first) != 0) {
+                record.second->in_use.store(false, std::memory_order_release);
+            }
+        }
+    }
+};
+
+thread_local ThreadRecords thread_records;
+
+} // namespace
+
+EpochDomain::EpochDomain() : _epoch(0), _records(nullptr), _id(++last_domain_id) {
+    std::lock_guard<std::mutex> lock(live_lock);
+    live_domains.insert(_id);
+}
+
+EpochDomain::~EpochDomain() {
+    {
+        std::lock_guard<std::mutex> lock(live_lock);
+        live_domains.erase(_id);
+    }
+    Record *record = _records.load();
+    while (record != nullptr) {
+        for (auto &retired : record->limbo) {
+            retired.deleter(retired.ptr);
+        }
+        Record *next = record->next;
+        delete record;
+        record = next;
+    }
+}
+
+EpochDomain::Record *EpochDomain::_record() {
+    for (auto &record : thread_records.records) {
+        if (record.first == _id) {
+            return record.second;
+        }
+    }
+
+    // Take record of the exited thread or add a new one
+    Record *record = _records.load(std::memory_order_acquire);
+    for (; record != nullptr; record = record->next) {
+        bool in_use = false;
+        if (!record->in_use.load(std::memory_order_relaxed) &&
+            record->in_use.compare_exchange_strong(in_use, true, std::memory_order_acquire)) {
+            break;
+        }
+    }
+    if (record == nullptr) {
+        record = new Record();
+        record->state.store(0, std::memory_order_relaxed);
+        record->depth = 0;
+        record->in_use.store(true, std::memory_order_relaxed);
+        record->next = _records.load(std::memory_order_relaxed);
+        while (!_records.compare_exchange_weak(record->next, record, std::memory_order_release)) {
+        }
+    }
+    thread_records.records.emplace_back(_id, record);
+    return record;
+}
+
+EpochDomain::Record *EpochDomain::_enter() {
+    Record *record = _record();
+    if (record->depth++ == 0) {
+        record->state.store(_epoch.load(std::memory_order_relaxed) << 1 | 1, std::memory_order_relaxed);
+        // Announcement must be visible before any read of the protected structure
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+    return record;
+}
+
+void EpochDomain::_exit(Record *record) {
+    if (--record->depth == 0) {
+        record->state.store(0, std::memory_order_release);
+    }
+}
+
+// See EpochDomain.h
+void EpochDomain::Retire(void *ptr, void (*deleter)(void *)) {
+    Record *record = _record();
+    record->limbo.push_back(Record::Retired{_epoch.load(std::memory_order_relaxed), ptr, deleter});
+    if (record->limbo.size() >= RECLAIM_THRESHOLD) {
+        _try_advance();
+        _reclaim(record);
+    }
+}
+
+void EpochDomain::_try_advance() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::uint64_t epoch = _epoch.load(std::memory_order_relaxed);
+    for (Record *record = _records.load(std::memory_order_acquire); record != nullptr; record = record->next) {
+        std::uint64_t state = record->state.load(std::memory_order_relaxed);
+        if ((state & 1) != 0 && (state >> 1) != epoch) {
+            return;
+        }
+    }
+    _epoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_acq_rel);
+}
+
+void EpochDomain::_reclaim(Record *record) {
+    std::uint64_t epoch = _epoch.load(std::memory_order_acquire);
+    std::size_t kept = 0;
+    for (auto &retired : record->limbo) {
+        if (retired.epoch + 2 <= epoch) {
+            retired.deleter(retired.ptr);
+        } else {
+            record->limbo[kept++] = retired;
+        }
+    }
+    record->limbo.resize(kept);
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,98 @@
+#ifndef AFINA_STORAGE_EPOCH_DOMAIN_H
+#define AFINA_STORAGE_EPOCH_DOMAIN_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Epoch based memory reclamation
+ * Readers of the lock-free structure wrap every access into Guard, which announces global epoch the thread
+ * works in. Writer unlinks object from the structure and retires it instead of freeing. Global epoch moves
+ * forward once all threads inside guards have announced current one, and object retired in epoch E is freed
+ * once global epoch reaches E + 2: nobody could have a reference to it by then.
+ *
+ * Entering and leaving guard touch only thread own record, so readers never block and never wait for each
+ * other. Thread stalled inside a guard delays reclamation, but not the other threads. Threads get records
+ * on the first use, records of exited threads are reused
+ */
+class EpochDomain {
+public:
+    EpochDomain();
+    ~EpochDomain();
+
+    EpochDomain(const EpochDomain &) = delete;
+    EpochDomain &operator=(const EpochDomain &) = delete;
+
+    struct Record;
+
+    /**
+     * Keeps objects reachable by the calling thread from being freed while in scope. Guards could nest
+     */
+    class Guard {
+    public:
+        explicit Guard(EpochDomain &domain) : _domain(domain), _record(domain._enter()) {}
+        ~Guard() { _domain._exit(_record); }
+
+    private:
+        Guard(const Guard &) = delete;
+        Guard &operator=(const Guard &) = delete;
+
+        EpochDomain &_domain;
+        Record *_record;
+    };
+
+    /**
+     * Frees object with deleter once no thread could access it anymore. Object must be unlinked already
+     */
+    void Retire(void *ptr, void (*deleter)(void *));
+
+    /**
+     * Thread record, public only to let threads release their records on exit
+     */
+    struct Record {
+        struct Retired {
+            std::uint64_t epoch;
+            void *ptr;
+            void (*deleter)(void *);
+        };
+
+        // 0 if thread is outside of guards, otherwise epoch << 1 | 1
+        std::atomic<std::uint64_t> state;
+        // Number of nested guards
+        unsigned depth;
+        // Objects retired by the thread but not freed yet
+        std::vector<Retired> limbo;
+        std::atomic<bool> in_use;
+        Record *next;
+    };
+
+private:
+    // Number of retired objects after which thread tries to reclaim memory
+    static constexpr std::size_t RECLAIM_THRESHOLD = 64;
+
+    Record *_record();
+    Record *_enter();
+    void _exit(Record *record);
+
+    // Moves global epoch forward if all threads inside guards are in the current one
+    void _try_advance();
+
+    // Frees objects of the record that are safe to free
+    void _reclaim(Record *record);
+
+    std::atomic<std::uint64_t> _epoch;
+    std::atomic<Record *> _records;
+
+    // Identity of the domain for the thread records cache, never reused
+    const std::uint64_t _id;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_EPOCH_DOMAIN_H
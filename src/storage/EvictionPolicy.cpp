@@ -0,0 +1,415 @@
+#include "EvictionPolicy.h"
+
+#include <algorithm>
+
+namespace Afina {
+namespace Backend {
+
+constexpr std::uint32_t CacheNode::NIL;
+constexpr std::uint16_t CacheNode::NO_SLOT;
+
+void NodeList::PushHead(std::uint32_t id) {
+    CacheNode *node = _nodes[id];
+    node->segment = _segment;
+    node->prev = CacheNode::NIL;
+    node->next = _head;
+    if (_head != CacheNode::NIL) {
+        _nodes[_head]->prev = id;
+    } else {
+        _tail = id;
+    }
+    _head = id;
+    _size += node->Footprint();
+}
+
+void NodeList::Remove(std::uint32_t id) {
+    CacheNode *node = _nodes[id];
+    if (node->prev != CacheNode::NIL) {
+        _nodes[node->prev]->next = node->next;
+    } else {
+        _head = node->next;
+    }
+    if (node->next != CacheNode::NIL) {
+        _nodes[node->next]->prev = node->prev;
+    } else {
+        _tail = node->prev;
+    }
+    node->prev = node->next = CacheNode::NIL;
+    _size -= node->Footprint();
+}
+
+void NodeList::MoveToHead(std::uint32_t id) {
+    if (id != _head) {
+        Remove(id);
+        PushHead(id);
+    }
+}
+
+GhostList::GhostList() : _head(CacheNode::NIL), _tail(CacheNode::NIL), _size(0), _index(ghost_hash{&_ghosts}) {}
+
+void GhostList::Add(std::uint64_t hash, std::size_t footprint) {
+    std::uint32_t id;
+    if (_free_ids.empty()) {
+        id = _ghosts.size();
+        _ghosts.emplace_back();
+    } else {
+        id = _free_ids.back();
+        _free_ids.pop_back();
+    }
+    ghost &g = _ghosts[id];
+    g.hash = hash;
+    g.footprint = footprint;
+    g.prev = CacheNode::NIL;
+    g.next = _head;
+    if (_head != CacheNode::NIL) {
+        _ghosts[_head].prev = id;
+    } else {
+        _tail = id;
+    }
+    _head = id;
+    _size += footprint;
+    _index.Insert(hash, id);
+}
+
+bool GhostList::Remove(std::uint64_t hash) {
+    const std::uint32_t *pos = _index.Find(hash, [this, hash](std::uint32_t id) { return _ghosts[id].hash == hash; });
+    if (pos == nullptr) {
+        return false;
+    }
+    std::uint32_t id = *pos;
+    _index.Erase(hash, [id](std::uint32_t other) { return other == id; });
+    _unlink(id);
+    return true;
+}
+
+void GhostList::Trim(std::size_t limit) {
+    while (_size > limit) {
+        std::uint32_t id = _tail;
+        _index.Erase(_ghosts[id].hash, [id](std::uint32_t other) { return other == id; });
+        _unlink(id);
+    }
+}
+
+void GhostList::_unlink(std::uint32_t id) {
+    ghost &g = _ghosts[id];
+    if (g.prev != CacheNode::NIL) {
+        _ghosts[g.prev].next = g.next;
+    } else {
+        _head = g.next;
+    }
+    if (g.next != CacheNode::NIL) {
+        _ghosts[g.next].prev = g.prev;
+    } else {
+        _tail = g.prev;
+    }
+    _size -= g.footprint;
+    _free_ids.push_back(id);
+}
+
+namespace {
+
+// Falls back to the other list if the first one has nothing to evict
+std::uint32_t pick(const NodeList &first, const NodeList &second, std::uint32_t pinned) {
+    std::uint32_t victim = first.Pick(pinned);
+    return victim != CacheNode::NIL ? victim : second.Pick(pinned);
+}
+
+/**
+ * Elements ordered by the last access: in the head most recently used element, in the tail element
+ * that wasn't used for longest time
+ */
+class LRUPolicy : public EvictionPolicy {
+public:
+    LRUPolicy(std::vector<CacheNode *> &nodes, std::size_t capacity)
+        : EvictionPolicy(nodes, capacity), _list(nodes, 0) {}
+
+    void Insert(std::uint32_t id) override { _list.PushHead(id); }
+    void Hit(std::uint32_t id) override { _list.MoveToHead(id); }
+    void Remove(std::uint32_t id, bool evicted) override { _list.Remove(id); }
+    void Resize(std::uint32_t id, std::size_t old_footprint) override {
+        _list.Resize(old_footprint, _nodes[id]->Footprint());
+    }
+    std::uint32_t Victim(std::uint32_t pinned) override { return _list.Pick(pinned); }
+    std::size_t Size() const override { return _list.Size(); }
+
+private:
+    NodeList _list;
+};
+
+/**
+ * Elements ordered by insertion, hit only marks element. Victim search moves marked elements from
+ * the tail back to the head clearing their marks
+ */
+class ClockPolicy : public EvictionPolicy {
+public:
+    ClockPolicy(std::vector<CacheNode *> &nodes, std::size_t capacity)
+        : EvictionPolicy(nodes, capacity), _list(nodes, 0) {}
+
+    void Insert(std::uint32_t id) override {
+        _nodes[id]->referenced.store(0, std::memory_order_relaxed);
+        _list.PushHead(id);
+    }
+
+    void Hit(std::uint32_t id) override {
+        // Avoid dirtying cache line shared between readers if mark is there already
+        CacheNode *node = _nodes[id];
+        if (!node->referenced.load(std::memory_order_relaxed)) {
+            node->referenced.store(1, std::memory_order_relaxed);
+        }
+    }
+
+    void Remove(std::uint32_t id, bool evicted) override { _list.Remove(id); }
+    void Resize(std::uint32_t id, std::size_t old_footprint) override {
+        _list.Resize(old_footprint, _nodes[id]->Footprint());
+    }
+
+    std::uint32_t Victim(std::uint32_t pinned) override {
+        // Every step clears a mark, so loop stops within one pass over the list
+        while (!_list.Empty() && _nodes[_list.Tail()]->referenced.load(std::memory_order_relaxed)) {
+            std::uint32_t id = _list.Tail();
+            _nodes[id]->referenced.store(0, std::memory_order_relaxed);
+            _list.MoveToHead(id);
+        }
+        return _list.Pick(pinned);
+    }
+
+    std::size_t Size() const override { return _list.Size(); }
+    bool ConcurrentHit() const override { return true; }
+
+private:
+    NodeList _list;
+};
+
+/**
+ * Segmented LRU: new elements go to probation segment. Hit moves element to the protected segment,
+ * which takes at most 80% of capacity, protected overflow goes back to probation. Victims are taken
+ * from probation first, so one-time scans don't flush elements accessed more than once.
+ */
+class SLRUPolicy : public EvictionPolicy {
+public:
+    SLRUPolicy(std::vector<CacheNode *> &nodes, std::size_t capacity)
+        : EvictionPolicy(nodes, capacity), _probation(nodes, PROBATION), _protected(nodes, PROTECTED) {}
+
+    void Insert(std::uint32_t id) override { _probation.PushHead(id); }
+
+    void Hit(std::uint32_t id) override {
+        if (_nodes[id]->segment == PROTECTED) {
+            _protected.MoveToHead(id);
+            return;
+        }
+        _probation.Remove(id);
+        _protected.PushHead(id);
+        while (_protected.Size() > _capacity / 5 * 4 && _protected.Tail() != id) {
+            std::uint32_t tail = _protected.Tail();
+            _protected.Remove(tail);
+            _probation.PushHead(tail);
+        }
+    }
+
+    void Remove(std::uint32_t id, bool evicted) override { _list_of(id).Remove(id); }
+    void Resize(std::uint32_t id, std::size_t old_footprint) override {
+        _list_of(id).Resize(old_footprint, _nodes[id]->Footprint());
+    }
+    std::uint32_t Victim(std::uint32_t pinned) override { return pick(_probation, _protected, pinned); }
+    std::size_t Size() const override { return _probation.Size() + _protected.Size(); }
+
+private:
+    enum : std::uint8_t { PROBATION, PROTECTED };
+
+    NodeList &_list_of(std::uint32_t id) { return _nodes[id]->segment == PROTECTED ? _protected : _probation; }
+
+    NodeList _probation;
+    NodeList _protected;
+};
+
+/**
+ * Full 2Q: new elements go to FIFO A1in taking 25% of capacity, hits there are ignored. Keys evicted from
+ * A1in are remembered in A1out history of 50% of capacity. Key inserted while in A1out is considered hot
+ * and goes to LRU list Am.
+ */
+class TwoQPolicy : public EvictionPolicy {
+public:
+    TwoQPolicy(std::vector<CacheNode *> &nodes, std::size_t capacity)
+        : EvictionPolicy(nodes, capacity), _in(nodes, IN), _main(nodes, MAIN), _prepared(false), _prepared_hash(0) {}
+
+    void Prepare(std::uint64_t hash, std::size_t footprint) override {
+        // Check history first, evictions made for the key could push it out of the history
+        _prepared = _out.Remove(hash);
+        _prepared_hash = hash;
+    }
+
+    void Insert(std::uint32_t id) override {
+        std::uint64_t hash = _nodes[id]->hash;
+        bool hot = _prepared && _prepared_hash == hash;
+        _prepared = false;
+        if (hot || _out.Remove(hash)) {
+            _main.PushHead(id);
+        } else {
+            _in.PushHead(id);
+        }
+    }
+
+    void Hit(std::uint32_t id) override {
+        if (_nodes[id]->segment == MAIN) {
+            _main.MoveToHead(id);
+        }
+    }
+
+    void Remove(std::uint32_t id, bool evicted) override {
+        CacheNode *node = _nodes[id];
+        if (node->segment == MAIN) {
+            _main.Remove(id);
+            return;
+        }
+        _in.Remove(id);
+        if (evicted) {
+            _out.Add(node->hash, node->Footprint());
+            _out.Trim(_capacity / 2);
+        }
+    }
+
+    void Resize(std::uint32_t id, std::size_t old_footprint) override {
+        (_nodes[id]->segment == MAIN ? _main : _in).Resize(old_footprint, _nodes[id]->Footprint());
+    }
+
+    std::uint32_t Victim(std::uint32_t pinned) override {
+        if (_in.Size() > _capacity / 4) {
+            return pick(_in, _main, pinned);
+        }
+        return pick(_main, _in, pinned);
+    }
+
+    std::size_t Size() const override { return _in.Size() + _main.Size(); }
+
+private:
+    enum : std::uint8_t { IN, MAIN };
+
+    NodeList _in;
+    NodeList _main;
+    GhostList _out;
+    // Whether the key of the last Prepare call was in the history
+    bool _prepared;
+    std::uint64_t _prepared_hash;
+};
+
+/**
+ * ARC: T1 holds elements seen once recently, T2 elements seen at least twice. B1 and B2 are histories of
+ * the keys evicted from T1 and T2. Insert of the key from B1 means T1 is too small, so target size of T1
+ * grows, insert of the key from B2 shrinks it. Sizes are measured in bytes of the footprints.
+ */
+class ARCPolicy : public EvictionPolicy {
+public:
+    ARCPolicy(std::vector<CacheNode *> &nodes, std::size_t capacity)
+        : EvictionPolicy(nodes, capacity), _t1(nodes, T1), _t2(nodes, T2), _target(0), _prepared(false),
+          _prepared_hash(0) {}
+
+    void Prepare(std::uint64_t hash, std::size_t footprint) override {
+        // Adapt target before the evictions, as those depend on it
+        _prepared = _adapt(hash, footprint);
+        _prepared_hash = hash;
+    }
+
+    void Insert(std::uint32_t id) override {
+        CacheNode *node = _nodes[id];
+        bool seen = _prepared && _prepared_hash == node->hash;
+        _prepared = false;
+        if (seen || _adapt(node->hash, node->Footprint())) {
+            _t2.PushHead(id);
+        } else {
+            _t1.PushHead(id);
+        }
+        _trim_history();
+    }
+
+    void Hit(std::uint32_t id) override {
+        if (_nodes[id]->segment == T2) {
+            _t2.MoveToHead(id);
+        } else {
+            _t1.Remove(id);
+            _t2.PushHead(id);
+        }
+    }
+
+    void Remove(std::uint32_t id, bool evicted) override {
+        CacheNode *node = _nodes[id];
+        bool in_t1 = node->segment == T1;
+        (in_t1 ? _t1 : _t2).Remove(id);
+        if (evicted) {
+            (in_t1 ? _b1 : _b2).Add(node->hash, node->Footprint());
+            _trim_history();
+        }
+    }
+
+    void Resize(std::uint32_t id, std::size_t old_footprint) override {
+        (_nodes[id]->segment == T1 ? _t1 : _t2).Resize(old_footprint, _nodes[id]->Footprint());
+    }
+
+    std::uint32_t Victim(std::uint32_t pinned) override {
+        if (_t1.Size() > _target || _t2.Empty()) {
+            return pick(_t1, _t2, pinned);
+        }
+        return pick(_t2, _t1, pinned);
+    }
+
+    std::size_t Size() const override { return _t1.Size() + _t2.Size(); }
+
+private:
+    enum : std::uint8_t { T1, T2 };
+
+    // If key is in the history, forgets it and moves target towards the list it was evicted from.
+    // Returns true if key was in the history
+    bool _adapt(std::uint64_t hash, std::size_t footprint) {
+        std::size_t b1 = _b1.Size(), b2 = _b2.Size();
+        if (_b1.Remove(hash)) {
+            std::size_t delta = std::max(footprint, b2 / b1 * footprint);
+            _target = std::min(_capacity, _target + delta);
+            return true;
+        }
+        if (_b2.Remove(hash)) {
+            std::size_t delta = std::max(footprint, b1 / b2 * footprint);
+            _target = _target > delta ? _target - delta : 0;
+            return true;
+        }
+        return false;
+    }
+
+    // Keeps |T1| + |B1| <= c and |T1| + |T2| + |B1| + |B2| <= 2c
+    void _trim_history() {
+        _b1.Trim(_capacity > _t1.Size() ? _capacity - _t1.Size() : 0);
+        std::size_t used = _t1.Size() + _t2.Size() + _b1.Size();
+        _b2.Trim(2 * _capacity > used ? 2 * _capacity - used : 0);
+    }
+
+    NodeList _t1;
+    NodeList _t2;
+    GhostList _b1;
+    GhostList _b2;
+    // Target size of T1
+    std::size_t _target;
+    // Whether the key of the last Prepare call was in the history
+    bool _prepared;
+    std::uint64_t _prepared_hash;
+};
+
+} // namespace
+
+// See EvictionPolicy.h
+std::unique_ptr<EvictionPolicy> EvictionPolicy::Build(Kind kind, std::vector<CacheNode *> &nodes,
+                                                      std::size_t capacity) {
+    switch (kind) {
+    case Kind::CLOCK:
+        return std::unique_ptr<EvictionPolicy>(new ClockPolicy(nodes, capacity));
+    case Kind::SLRU:
+        return std::unique_ptr<EvictionPolicy>(new SLRUPolicy(nodes, capacity));
+    case Kind::TWO_Q:
+        return std::unique_ptr<EvictionPolicy>(new TwoQPolicy(nodes, capacity));
+    case Kind::ARC:
+        return std::unique_ptr<EvictionPolicy>(new ARCPolicy(nodes, capacity));
+    case Kind::LRU:
+    default:
+        return std::unique_ptr<EvictionPolicy>(new LRUPolicy(nodes, capacity));
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
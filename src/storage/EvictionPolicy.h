@@ -0,0 +1,187 @@
+#ifndef AFINA_STORAGE_EVICTION_POLICY_H
+#define AFINA_STORAGE_EVICTION_POLICY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "CacheNode.h"
+#include "HashIndex.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Intrusive list of cache nodes
+ * Nodes are linked by CacheNode#prev/next, list keeps total footprint of its nodes. Every node in the list
+ * has CacheNode#segment equal to the list segment, so policies with several lists know where node is.
+ */
+class NodeList {
+public:
+    NodeList(std::vector<CacheNode *> &nodes, std::uint8_t segment)
+        : _nodes(nodes), _segment(segment), _head(CacheNode::NIL), _tail(CacheNode::NIL), _size(0) {}
+
+    std::uint32_t Head() const { return _head; }
+    std::uint32_t Tail() const { return _tail; }
+
+    // Total footprint of the nodes
+    std::size_t Size() const { return _size; }
+    bool Empty() const { return _head == CacheNode::NIL; }
+
+    void PushHead(std::uint32_t id);
+    void Remove(std::uint32_t id);
+    void MoveToHead(std::uint32_t id);
+
+    // Accounts change of the node footprint
+    void Resize(std::size_t old_footprint, std::size_t new_footprint) { _size = _size - old_footprint + new_footprint; }
+
+    // Tail node unless it is pinned, otherwise the one before tail
+    std::uint32_t Pick(std::uint32_t pinned) const {
+        return _tail != pinned || _tail == CacheNode::NIL ? _tail : _nodes[_tail]->prev;
+    }
+
+private:
+    std::vector<CacheNode *> &_nodes;
+    const std::uint8_t _segment;
+    std::uint32_t _head;
+    std::uint32_t _tail;
+    std::size_t _size;
+};
+
+/**
+ * # History of the evicted keys
+ * FIFO of the hashes of the keys which are not in the cache anymore, together with their footprints.
+ * Used by policies that take into account whether a new key was recently evicted. Memory taken by history
+ * isn't accounted in the cache limit: it is limited by policy and is few dozens of bytes per key.
+ */
+class GhostList {
+public:
+    GhostList();
+    GhostList(const GhostList &) = delete;
+    GhostList &operator=(const GhostList &) = delete;
+
+    // Total footprint of the evicted keys
+    std::size_t Size() const { return _size; }
+
+    // Adds evicted key as the newest one
+    void Add(std::uint64_t hash, std::size_t footprint);
+
+    // Forgets the key, returns true if it was there
+    bool Remove(std::uint64_t hash);
+
+    // Forgets the oldest keys until total footprint is not above the limit
+    void Trim(std::size_t limit);
+
+private:
+    struct ghost {
+        std::uint64_t hash;
+        std::size_t footprint;
+        std::uint32_t prev;
+        std::uint32_t next;
+    };
+
+    struct ghost_hash {
+        const std::vector<ghost> *ghosts;
+        std::uint64_t operator()(std::uint32_t id) const { return (*ghosts)[id].hash; }
+    };
+
+    void _unlink(std::uint32_t id);
+
+    std::vector<ghost> _ghosts;
+    std::vector<std::uint32_t> _free_ids;
+    // Newest and oldest keys
+    std::uint32_t _head;
+    std::uint32_t _tail;
+    std::size_t _size;
+    HashIndex<std::uint32_t, ghost_hash> _index;
+};
+
+/**
+ * # Eviction policy
+ * Decides which of the cache nodes goes away once there is no space left. Cache owns the nodes, policy
+ * only orders them using the links in the node headers. All operations are O(1) (CLOCK sweep is O(1)
+ * amortized).
+ *
+ * Policies are NOT thread safe, except Hit of the policies with ConcurrentHit.
+ */
+class EvictionPolicy {
+public:
+    enum class Kind {
+        // Exact LRU: every hit moves element to the list head
+        LRU,
+        // Second chance: hit only marks element as referenced, eviction moves referenced elements
+        // from the tail back to the head instead of evicting them
+        CLOCK,
+        // Segmented LRU: new elements go to probation segment, hit moves them to protected one
+        SLRU,
+        // 2Q: new elements go to FIFO, elements evicted from it are remembered. Element which comes back
+        // soon after eviction goes to the main LRU
+        TWO_Q,
+        // Adaptive replacement cache: balances recency and frequency lists using history of the
+        // evicted keys of the both lists
+        ARC
+    };
+
+    /**
+     * @param kind which policy to build
+     * @param nodes node table of the cache
+     * @param capacity number of bytes the policy nodes are supposed to take
+     */
+    static std::unique_ptr<EvictionPolicy> Build(Kind kind, std::vector<CacheNode *> &nodes, std::size_t capacity);
+
+    virtual ~EvictionPolicy() {}
+
+    /**
+     * Key with given hash and footprint is going to be inserted, called before the evictions made to free
+     * space for it
+     */
+    virtual void Prepare(std::uint64_t hash, std::size_t footprint) {}
+
+    /**
+     * Takes new node under control of the policy
+     */
+    virtual void Insert(std::uint32_t id) = 0;
+
+    /**
+     * Records access to the node
+     */
+    virtual void Hit(std::uint32_t id) = 0;
+
+    /**
+     * Releases node, evicted is true if node goes away because of the Victim choice
+     */
+    virtual void Remove(std::uint32_t id, bool evicted) = 0;
+
+    /**
+     * Node footprint has changed
+     */
+    virtual void Resize(std::uint32_t id, std::size_t old_footprint) = 0;
+
+    /**
+     * Node which should be evicted next, never pinned one. Returns CacheNode::NIL if there is nothing
+     * to evict
+     */
+    virtual std::uint32_t Victim(std::uint32_t pinned) = 0;
+
+    /**
+     * Total footprint of the policy nodes
+     */
+    virtual std::size_t Size() const = 0;
+
+    /**
+     * True if Hit only changes atomic marks, so it could run concurrently with other Hit calls
+     */
+    virtual bool ConcurrentHit() const { return false; }
+
+protected:
+    EvictionPolicy(std::vector<CacheNode *> &nodes, std::size_t capacity) : _nodes(nodes), _capacity(capacity) {}
+
+    std::vector<CacheNode *> &_nodes;
+    const std::size_t _capacity;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_EVICTION_POLICY_H
@@ -0,0 +1,75 @@
+#include "FrequencySketch.h"
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+// Independent seeds for the rows
+const std::uint64_t ROW_SEEDS[] = {0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL, 0x9ae16a3b2f90404fULL,
+                                   0xcbf29ce484222325ULL};
+
+} // namespace
+
+FrequencySketch::FrequencySketch(std::size_t width) : _row_words(1), _additions(0) {
+    while (_row_words * 16 < width) {
+        _row_words <<= 1;
+    }
+    _table.reset(new std::atomic<std::uint64_t>[DEPTH * _row_words]);
+    for (std::size_t i = 0; i < DEPTH * _row_words; ++i) {
+        _table[i].store(0, std::memory_order_relaxed);
+    }
+    _sample_size = 10 * _row_words * 16;
+}
+
+void FrequencySketch::_position(std::uint64_t hash, int row, std::size_t &word, unsigned &shift) const {
+    std::uint64_t h = (hash ^ ROW_SEEDS[row]) * 0x9E3779B97F4A7C15ULL;
+    h ^= h >> 32;
+    word = row * _row_words + ((h >> 4) & (_row_words - 1));
+    shift = unsigned(h & 15) * 4;
+}
+
+// See FrequencySketch.h
+void FrequencySketch::Increment(std::uint64_t hash) {
+    bool added = false;
+    for (int row = 0; row < DEPTH; ++row) {
+        std::size_t word;
+        unsigned shift;
+        _position(hash, row, word, shift);
+        std::uint64_t value = _table[word].load(std::memory_order_relaxed);
+        if (((value >> shift) & MAX_COUNTER) < MAX_COUNTER) {
+            _table[word].store(value + (std::uint64_t(1) << shift), std::memory_order_relaxed);
+            added = true;
+        }
+    }
+
+    if (added && _additions.fetch_add(1, std::memory_order_relaxed) + 1 == _sample_size) {
+        _reset();
+    }
+}
+
+// See FrequencySketch.h
+unsigned FrequencySketch::Frequency(std::uint64_t hash) const {
+    unsigned result = MAX_COUNTER;
+    for (int row = 0; row < DEPTH; ++row) {
+        std::size_t word;
+        unsigned shift;
+        _position(hash, row, word, shift);
+        unsigned counter = (_table[word].load(std::memory_order_relaxed) >> shift) & MAX_COUNTER;
+        if (counter < result) {
+            result = counter;
+        }
+    }
+    return result;
+}
+
+void FrequencySketch::_reset() {
+    for (std::size_t i = 0; i < DEPTH * _row_words; ++i) {
+        std::uint64_t value = _table[i].load(std::memory_order_relaxed);
+        _table[i].store((value >> 1) & 0x7777777777777777ULL, std::memory_order_relaxed);
+    }
+    _additions.fetch_sub(_sample_size / 2, std::memory_order_relaxed);
+}
+
+} // namespace Backend
+} // namespace Afina
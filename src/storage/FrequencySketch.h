@@ -0,0 +1,60 @@
+#ifndef AFINA_STORAGE_FREQUENCY_SKETCH_H
+#define AFINA_STORAGE_FREQUENCY_SKETCH_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Count-min sketch of the access frequencies
+ * Estimates how often key was accessed recently: 4 rows of 4-bit saturating counters, estimation
+ * is minimum over the key counters. Once number of increments reaches sample size all counters are
+ * halved, so old popularity fades away.
+ *
+ * Counters are updated with relaxed atomics and increments might be lost under concurrent access, which
+ * is fine for the estimation, but sketch could be safely shared by concurrent readers of the cache
+ */
+class FrequencySketch {
+public:
+    /**
+     * @param width number of counters per row, should be close to number of elements in the cache
+     */
+    explicit FrequencySketch(std::size_t width);
+
+    /**
+     * Records one more access to the key with given hash
+     */
+    void Increment(std::uint64_t hash);
+
+    /**
+     * Estimated number of recent accesses to the key with given hash, at most 15
+     */
+    unsigned Frequency(std::uint64_t hash) const;
+
+private:
+    static constexpr int DEPTH = 4;
+    static constexpr unsigned MAX_COUNTER = 15;
+
+    // Position of the row counter for the given hash: word number and shift inside of the word
+    void _position(std::uint64_t hash, int row, std::size_t &word, unsigned &shift) const;
+
+    // Halves all counters
+    void _reset();
+
+    // DEPTH rows of words, 16 counters in each word
+    std::unique_ptr<std::atomic<std::uint64_t>[]> _table;
+    std::size_t _row_words;
+
+    // Number of increments until counters get halved
+    std::size_t _sample_size;
+    std::atomic<std::size_t> _additions;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_FREQUENCY_SKETCH_H
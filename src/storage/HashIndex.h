@@ -0,0 +1,332 @@
+#ifndef AFINA_STORAGE_HASH_INDEX_H
+#define AFINA_STORAGE_HASH_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Open addressing hash index
+ * Swiss table like hash index: every slot has a control byte, which is either EMPTY, DELETED or 7 bits of
+ * the element hash. Control bytes are grouped by 16, so lookup checks the whole group with a couple of SSE2
+ * instructions and touches slots only for the candidates whose 7 bits matches.
+ *
+ * Index stores values of type V (pointers or ids of the nodes), it doesn't own keys. Caller passes
+ * precomputed hash together with equality predicate, so key comparison is up to the storage.
+ *
+ * Table grows incrementally: once load factor gets too high, new table is allocated and every following
+ * mutation moves a few groups from the old table into the new one. Lookups check both tables meanwhile,
+ * so there is no stop-the-world rehash. Lookups never mutate index, so they could run concurrently under
+ * a shared lock.
+ *
+ * HashOf must be a callable returning hash of the stored value, it is used to move elements on grow.
+ *
+ * That is NOT thread safe implementaiton!!
+ */
+template <typename V, typename HashOf> class HashIndex {
+public:
+    explicit HashIndex(HashOf hash_of, std::size_t capacity = 16) : _hash_of(hash_of), _size(0), _migrate_pos(0) {
+        std::size_t groups = 1;
+        while (groups * GROUP_SIZE * MAX_LOAD_NUM < capacity * MAX_LOAD_DEN) {
+            groups <<= 1;
+        }
+        _table.Allocate(groups);
+    }
+
+    HashIndex(const HashIndex &) = delete;
+    HashIndex &operator=(const HashIndex &) = delete;
+
+    /**
+     * Number of elements in the index
+     */
+    std::size_t size() const { return _size; }
+
+    /**
+     * Returns pointer to the stored value matching given hash and predicate or nullptr if there is no such value
+     */
+    template <typename Eq> const V *Find(std::uint64_t hash, Eq &&eq) const {
+        std::uint64_t h = _mix(hash);
+        const V *result = _table.Find(h, eq);
+        if (result == nullptr && _old.groups != nullptr) {
+            result = _old.Find(h, eq);
+        }
+        return result;
+    }
+
+    /**
+     * Starts loading group the lookup of given hash begins with into CPU cache, so lookups of several
+     * hashes could wait for memory at once rather than one after another
+     */
+    void Prefetch(std::uint64_t hash) const {
+        std::uint64_t h = _mix(hash);
+        _table.Prefetch(h);
+        if (_old.groups != nullptr) {
+            _old.Prefetch(h);
+        }
+    }
+
+    /**
+     * Returns pointer to the first value of the group lookup begins with, whose hash bits match given hash,
+     * or nullptr if there is none. Value could belong to another key, so it is only a hint which node to
+     * prefetch before Find
+     */
+    const V *Candidate(std::uint64_t hash) const {
+        std::uint64_t h = _mix(hash);
+        const group &g = _table.groups[h & _table.mask];
+        std::uint32_t m = _match(g, _h2(h));
+        return m == 0 ? nullptr : &g.slots[__builtin_ctz(m)];
+    }
+
+    /**
+     * Inserts new value into the index. Caller must make sure that there is no equal value in the index yet
+     */
+    void Insert(std::uint64_t hash, V value) {
+        _migrate_step();
+        if (_table.used + 1 > _table.Limit()) {
+            _grow();
+        }
+        _table.Insert(_mix(hash), value);
+        _size++;
+    }
+
+    /**
+     * Removes value matching given hash and predicate from the index. Returns true if value was found
+     */
+    template <typename Eq> bool Erase(std::uint64_t hash, Eq &&eq) {
+        _migrate_step();
+        std::uint64_t h = _mix(hash);
+        if (_table.Erase(h, eq) || (_old.groups != nullptr && _old.Erase(h, eq))) {
+            _size--;
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * Removes all elements, keeps current capacity
+     */
+    void Clear() {
+        _finish_migration();
+        _table.Clear();
+        _size = 0;
+    }
+
+private:
+    static constexpr std::size_t GROUP_SIZE = 16;
+    // Maximum load factor of the table is MAX_LOAD_NUM / MAX_LOAD_DEN
+    static constexpr std::size_t MAX_LOAD_NUM = 7;
+    static constexpr std::size_t MAX_LOAD_DEN = 8;
+    // How many groups of the old table are moved into the new one on each mutation
+    static constexpr std::size_t MIGRATE_GROUPS = 2;
+
+    static constexpr std::uint8_t CTRL_EMPTY = 0x80;
+    static constexpr std::uint8_t CTRL_DELETED = 0xFE;
+
+    // Group of control bytes together with its slots, keeps slot next to its control byte in memory
+    struct group {
+        std::uint8_t ctrl[GROUP_SIZE];
+        V slots[GROUP_SIZE];
+    };
+
+    // Bit mask of the group positions matching control byte
+    static std::uint32_t _match(const group &g, std::uint8_t c) {
+#ifdef __SSE2__
+        __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(g.ctrl));
+        return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(char(c)))));
+#else
+        std::uint32_t mask = 0;
+        for (std::size_t i = 0; i < GROUP_SIZE; i++) {
+            mask |= std::uint32_t(g.ctrl[i] == c) << i;
+        }
+        return mask;
+#endif
+    }
+
+    // Bit mask of the group positions that are free: EMPTY or DELETED, both have high bit set
+    static std::uint32_t _match_free(const group &g) {
+#ifdef __SSE2__
+        __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(g.ctrl));
+        return static_cast<std::uint32_t>(_mm_movemask_epi8(ctrl));
+#else
+        std::uint32_t mask = 0;
+        for (std::size_t i = 0; i < GROUP_SIZE; i++) {
+            mask |= std::uint32_t(g.ctrl[i] >> 7) << i;
+        }
+        return mask;
+#endif
+    }
+
+    static std::uint8_t _h2(std::uint64_t h) { return std::uint8_t(h >> 57); }
+
+    // Spread hash bits, so that stripe selection by the same hash doesn't correlate with groups
+    static std::uint64_t _mix(std::uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    struct table {
+        std::unique_ptr<group[]> groups;
+        std::size_t mask;
+        // Number of FULL + DELETED slots
+        std::size_t used;
+
+        table() : mask(0), used(0) {}
+
+        std::size_t Capacity() const { return groups == nullptr ? 0 : (mask + 1) * GROUP_SIZE; }
+        std::size_t Limit() const { return Capacity() * MAX_LOAD_NUM / MAX_LOAD_DEN; }
+
+        void Allocate(std::size_t n_groups) {
+            groups.reset(new group[n_groups]);
+            mask = n_groups - 1;
+            Clear();
+        }
+
+        void Clear() {
+            for (std::size_t i = 0; i <= mask; i++) {
+                std::memset(groups[i].ctrl, CTRL_EMPTY, GROUP_SIZE);
+            }
+            used = 0;
+        }
+
+        void Release() {
+            groups.reset();
+            mask = 0;
+            used = 0;
+        }
+
+        void Prefetch(std::uint64_t h) const {
+            const char *g = reinterpret_cast<const char *>(&groups[h & mask]);
+            __builtin_prefetch(g);
+            __builtin_prefetch(g + sizeof(group) - 1);
+        }
+
+        // Triangular probing over groups visits every group once as number of groups is power of two
+        template <typename Eq> const V *Find(std::uint64_t h, Eq &eq) const {
+            std::uint8_t h2 = _h2(h);
+            std::size_t pos = h & mask;
+            for (std::size_t step = 1; step <= mask + 1; step++) {
+                const group &g = groups[pos];
+                for (std::uint32_t m = _match(g, h2); m != 0; m &= m - 1) {
+                    std::size_t i = __builtin_ctz(m);
+                    if (eq(g.slots[i])) {
+                        return &g.slots[i];
+                    }
+                }
+                if (_match(g, CTRL_EMPTY) != 0) {
+                    return nullptr;
+                }
+                pos = (pos + step) & mask;
+            }
+            return nullptr;
+        }
+
+        void Insert(std::uint64_t h, V value) {
+            std::size_t pos = h & mask;
+            for (std::size_t step = 1;; step++) {
+                group &g = groups[pos];
+                std::uint32_t m = _match_free(g);
+                if (m != 0) {
+                    std::size_t i = __builtin_ctz(m);
+                    if (g.ctrl[i] == CTRL_EMPTY) {
+                        used++;
+                    }
+                    g.ctrl[i] = _h2(h);
+                    g.slots[i] = value;
+                    return;
+                }
+                pos = (pos + step) & mask;
+            }
+        }
+
+        template <typename Eq> bool Erase(std::uint64_t h, Eq &eq) {
+            V *slot = const_cast<V *>(Find(h, eq));
+            if (slot == nullptr) {
+                return false;
+            }
+            group &g = groups[_group_of(slot)];
+            std::size_t i = slot - g.slots;
+            // Group without EMPTY slots could be part of some probe sequence, keep tombstone there
+            if (_match(g, CTRL_EMPTY) != 0) {
+                g.ctrl[i] = CTRL_EMPTY;
+                used--;
+            } else {
+                g.ctrl[i] = CTRL_DELETED;
+            }
+            return true;
+        }
+
+        std::size_t _group_of(const V *slot) const {
+            const char *base = reinterpret_cast<const char *>(groups.get());
+            return (reinterpret_cast<const char *>(slot) - base) / sizeof(group);
+        }
+    };
+
+    // Starts incremental grow: current table becomes old one and all new elements goes into the bigger one
+    void _grow() {
+        _finish_migration();
+        std::size_t n_groups = _table.mask + 1;
+        // Table full of tombstones needs cleanup rather than grow
+        if (_size + 1 > _table.Limit() / 2) {
+            n_groups <<= 1;
+        }
+        _old = std::move(_table);
+        _table = table();
+        _table.Allocate(n_groups);
+        _migrate_pos = 0;
+    }
+
+    void _migrate_step() {
+        if (_old.groups == nullptr) {
+            return;
+        }
+        for (std::size_t n = 0; n < MIGRATE_GROUPS && _migrate_pos <= _old.mask; n++, _migrate_pos++) {
+            group &g = _old.groups[_migrate_pos];
+            for (std::uint32_t m = ~_match_free(g) & 0xFFFF; m != 0; m &= m - 1) {
+                std::size_t i = __builtin_ctz(m);
+                _table.Insert(_mix(_hash_of(g.slots[i])), g.slots[i]);
+                // Lookup falls back to the old table, moved element must not be found there once it is
+                // erased from the new one. Tombstone keeps probe sequences going through the group
+                g.ctrl[i] = CTRL_DELETED;
+            }
+        }
+        if (_migrate_pos > _old.mask) {
+            _old.Release();
+        }
+    }
+
+    void _finish_migration() {
+        while (_old.groups != nullptr) {
+            _migrate_step();
+        }
+    }
+
+    HashOf _hash_of;
+
+    // Number of elements in both tables
+    std::size_t _size;
+
+    // Table new elements goes to
+    table _table;
+
+    // Table elements are migrating from, empty unless grow is in progress
+    table _old;
+
+    // Next group of the old table to be migrated
+    std::size_t _migrate_pos;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_HASH_INDEX_H
@@ -0,0 +1,143 @@
+#include "InlineTable.h"
+
+#include <cstring>
+
+#include <afina/concurrency/Futex.h>
+
+namespace Afina {
+namespace Backend {
+
+constexpr std::size_t InlineTable::INLINE_LIMIT;
+constexpr std::uint64_t InlineTable::USED;
+
+InlineTable::InlineTable(std::size_t slots) : _shift(63) {
+    std::size_t size = 2;
+    while (size * 2 <= slots) {
+        size *= 2;
+        _shift--;
+    }
+    _slots.reset(new Slot[size]());
+}
+
+// See InlineTable.h
+std::size_t InlineTable::Footprint(std::size_t slots) {
+    std::size_t size = 2;
+    while (size * 2 <= slots) {
+        size *= 2;
+    }
+    return size * sizeof(Slot);
+}
+
+// See InlineTable.h
+bool InlineTable::Get(const Key &key, std::uint32_t now, std::string &value, std::uint32_t *flags,
+                      std::uint64_t *cas, std::uint32_t *expire_at) const {
+    const std::uint64_t hash = key.hash();
+    Slot &slot = _slot(hash);
+    std::uint64_t words[WORDS];
+    for (;;) {
+        std::uint32_t seq = slot.seq.load(std::memory_order_acquire);
+        if (seq & 1) {
+            Concurrency::Futex::Relax();
+            continue;
+        }
+        for (std::size_t i = 0; i < DATA; ++i) {
+            words[i] = slot.words[i].load(std::memory_order_relaxed);
+        }
+        // Torn header could only make a false miss, cache has the item anyway
+        if (words[SIZES] == 0 || words[HASH] != hash || (words[SIZES] & 0xff) != key.size()) {
+            return false;
+        }
+        std::size_t bytes = (words[SIZES] & 0xff) + ((words[SIZES] >> 8) & 0xff);
+        std::size_t count = DATA + (bytes + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+        for (std::size_t i = DATA; i < count && i < WORDS; ++i) {
+            words[i] = slot.words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) == seq) {
+            break;
+        }
+    }
+
+    const char *data = reinterpret_cast<const char *>(words + DATA);
+    std::uint32_t expire = words[META] >> 32;
+    if (std::memcmp(data, key.data(), key.size()) != 0 || (expire != 0 && expire <= now)) {
+        return false;
+    }
+    value.assign(data + key.size(), (words[SIZES] >> 8) & 0xff);
+    if (flags != nullptr) {
+        *flags = static_cast<std::uint32_t>(words[META]);
+    }
+    if (cas != nullptr) {
+        *cas = words[CAS];
+    }
+    if (expire_at != nullptr) {
+        *expire_at = expire;
+    }
+    if (slot.touched.load(std::memory_order_relaxed) == 0) {
+        slot.touched.store(1, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+// See InlineTable.h
+void InlineTable::Store(std::uint64_t hash, const char *key, std::size_t key_size, const char *value,
+                        std::size_t value_size, std::uint32_t flags, std::uint32_t expire, std::uint64_t cas) {
+    if (key_size + value_size > INLINE_LIMIT) {
+        Erase(hash);
+        return;
+    }
+    Slot &slot = _slot(hash);
+    std::uint64_t words[WORDS] = {};
+    words[HASH] = hash;
+    words[CAS] = cas;
+    words[META] = static_cast<std::uint64_t>(expire) << 32 | flags;
+    words[SIZES] = USED | value_size << 8 | key_size;
+    char *data = reinterpret_cast<char *>(words + DATA);
+    std::memcpy(data, key, key_size);
+    std::memcpy(data + key_size, value, value_size);
+
+    if (slot.words[HASH].load(std::memory_order_relaxed) != hash) {
+        // Another key takes the slot, recency of the previous one is lost along with its copy
+        slot.touched.store(0, std::memory_order_relaxed);
+    }
+    _write(slot, words, DATA + (key_size + value_size + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t));
+}
+
+// See InlineTable.h
+void InlineTable::Erase(std::uint64_t hash) {
+    Slot &slot = _slot(hash);
+    if (slot.words[SIZES].load(std::memory_order_relaxed) == 0 ||
+        slot.words[HASH].load(std::memory_order_relaxed) != hash) {
+        return;
+    }
+    std::uint64_t words[DATA] = {};
+    _write(slot, words, DATA);
+    slot.touched.store(0, std::memory_order_relaxed);
+}
+
+// See InlineTable.h
+bool InlineTable::Touched(std::uint64_t hash) {
+    Slot &slot = _slot(hash);
+    if (slot.words[SIZES].load(std::memory_order_relaxed) == 0 ||
+        slot.words[HASH].load(std::memory_order_relaxed) != hash ||
+        slot.touched.load(std::memory_order_relaxed) == 0) {
+        return false;
+    }
+    slot.touched.store(0, std::memory_order_relaxed);
+    return true;
+}
+
+void InlineTable::_write(Slot &slot, const std::uint64_t *words, std::size_t count) {
+    std::uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+    if ((seq & 1) != 0 || !slot.seq.compare_exchange_strong(seq, seq + 1, std::memory_order_relaxed)) {
+        return;
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    for (std::size_t i = 0; i < count; ++i) {
+        slot.words[i].store(words[i], std::memory_order_relaxed);
+    }
+    slot.seq.store(seq + 2, std::memory_order_release);
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,100 @@
+#ifndef AFINA_STORAGE_INLINE_TABLE_H
+#define AFINA_STORAGE_INLINE_TABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <afina/Key.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Seqlock protected copies of the small items
+ * Direct mapped table of slots, slot holds key, value and metadata of one item inline, if they fit into
+ * INLINE_LIMIT bytes. Table is a mirror of the cache: writer stores item copy on every modification and
+ * erases it once item is gone, while holding the cache lock exclusively. Item which doesn't fit or lost
+ * its slot to another key is just not in the table, reader asks the cache then and stores the copy back
+ * holding the cache lock shared, so hot items return to the table.
+ *
+ * Readers don't lock anything: slot sequence counter is odd while writer changes the slot, reader copies
+ * slot words and retries if the counter was odd or changed during the copy. Slot is two cache lines, so
+ * hit costs about two cache misses and doesn't write to shared memory except the first hit after the
+ * item was stored, which marks slot as touched
+ */
+class InlineTable {
+public:
+    // Max total size of key and value stored inline
+    static constexpr std::size_t INLINE_LIMIT = 88;
+
+    /**
+     * @param slots number of slots, rounded down to the power of two
+     */
+    explicit InlineTable(std::size_t slots);
+
+    /**
+     * Number of bytes table takes
+     */
+    static std::size_t Footprint(std::size_t slots);
+
+    /**
+     * Copies item out of the table without locking, safe to call concurrently with Store and Erase
+     *
+     * @param now current unix time, expired item is not returned
+     * @param expire_at optional output parameter for the expiration time of the item
+     * @return false if there is no such key in the table, which doesn't mean it is not in the cache
+     */
+    bool Get(const Key &key, std::uint32_t now, std::string &value, std::uint32_t *flags, std::uint64_t *cas,
+             std::uint32_t *expire_at = nullptr) const;
+
+    /**
+     * Stores copy of the item, replacing whatever slot holds, or erases its old copy if item doesn't fit.
+     * Concurrent Store calls are allowed only while the item can't change, e.g. under the shared cache
+     * lock: writer finding slot changed by another one gives up
+     */
+    void Store(std::uint64_t hash, const char *key, std::size_t key_size, const char *value, std::size_t value_size,
+               std::uint32_t flags, std::uint32_t expire, std::uint64_t cas);
+
+    /**
+     * Erases copy of the item with given hash if there is one, caller must hold the cache lock exclusively
+     */
+    void Erase(std::uint64_t hash);
+
+    /**
+     * True if item copy was read since it was stored or since the previous call, clears the mark.
+     * Cache applies missed recency updates to the item this way before evicting it
+     */
+    bool Touched(std::uint64_t hash);
+
+private:
+    // Words of the slot content: hash, cas, flags and expire, sizes, then key and value bytes
+    enum : std::size_t { HASH, CAS, META, SIZES, DATA, WORDS = DATA + INLINE_LIMIT / sizeof(std::uint64_t) };
+
+    // SIZES word of the slot holding an item, zero means empty slot
+    static constexpr std::uint64_t USED = 1ULL << 63;
+
+    struct Slot {
+        std::atomic<std::uint32_t> seq;
+        std::atomic<std::uint8_t> touched;
+        std::atomic<std::uint64_t> words[WORDS];
+    };
+    static_assert(sizeof(Slot) == 128, "Slot must take exactly two cache lines");
+
+    Slot &_slot(std::uint64_t hash) const { return _slots[(hash * 0x9E3779B97F4A7C15ULL) >> _shift]; }
+
+    // Changes slot content, words is the new content of the first count words. Does nothing if another
+    // writer changes the slot right now
+    void _write(Slot &slot, const std::uint64_t *words, std::size_t count);
+
+    std::unique_ptr<Slot[]> _slots;
+    // Slot number is top bits of the mixed hash
+    int _shift;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_INLINE_TABLE_H
@@ -0,0 +1,483 @@
+#include "LockFreeCache.h"
+
+#include <cstring>
+#include <new>
+
+namespace Afina {
+namespace Backend {
+
+constexpr std::size_t LockFreeCache::LOCKS;
+constexpr std::size_t LockFreeCache::EVICT_BATCH;
+constexpr std::size_t LockFreeCache::MIGRATE_BATCH;
+
+LockFreeCache::Node LockFreeCache::MOVED;
+
+LockFreeCache::Table::Table(std::size_t size) : mask(size - 1), buckets(new std::atomic<Node *>[size]), next(nullptr) {
+    for (std::size_t i = 0; i < size; ++i) {
+        buckets[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+LockFreeCache::LockFreeCache(std::size_t max_size)
+    : _max_size(max_size), _table(new Table(LOCKS)), _old(nullptr), _locks(new Concurrency::Mutex[LOCKS]),
+      _migrate_hand(0), _migrated(0), _hand(0), _cur_size(0), _items(0), _cas(0), _evictions(0), _expirations(0) {}
+
+LockFreeCache::~LockFreeCache() {
+    Table *old = _old.load(std::memory_order_relaxed);
+    if (old != nullptr) {
+        _clear(old);
+        delete old;
+    }
+    Table *table = _table.load(std::memory_order_relaxed);
+    _clear(table);
+    delete table;
+}
+
+void LockFreeCache::_clear(Table *table) {
+    for (std::size_t i = 0; i <= table->mask; ++i) {
+        Node *node = table->buckets[i].load(std::memory_order_relaxed);
+        if (node == &MOVED) {
+            continue;
+        }
+        while (node != nullptr) {
+            Node *next = node->next.load(std::memory_order_relaxed);
+            _delete_node(node);
+            node = next;
+        }
+    }
+}
+
+// See LockFreeCache.h
+std::size_t LockFreeCache::ItemFootprint(std::size_t key_size, std::size_t value_size) {
+    // malloc chunk is the requested size plus a word of header rounded up to 16 bytes
+    std::size_t chunk = (sizeof(Node) + key_size + value_size + sizeof(std::size_t) + 15) & ~std::size_t(15);
+    return chunk < 32 ? 32 : chunk;
+}
+
+LockFreeCache::Node *LockFreeCache::_make_node(std::uint64_t hash, const Key &key, const char *value,
+                                               std::size_t value_size, const char *suffix, std::size_t suffix_size,
+                                               std::uint32_t flags, std::uint32_t expire) {
+    Node *node = new (::operator new(sizeof(Node) + key.size() + value_size + suffix_size)) Node;
+    node->next.store(nullptr, std::memory_order_relaxed);
+    node->hash = hash;
+    node->cas = ++_cas;
+    node->key_size = key.size();
+    node->value_size = value_size + suffix_size;
+    node->flags = flags;
+    node->expire = expire;
+    // New node survives the first pass of the clock hand
+    node->referenced.store(1, std::memory_order_relaxed);
+    std::memcpy(node->key(), key.data(), key.size());
+    std::memcpy(node->value(), value, value_size);
+    std::memcpy(node->value() + value_size, suffix, suffix_size);
+    return node;
+}
+
+LockFreeCache::Node *LockFreeCache::_copy_node(Node *node) {
+    Node *copy = new (::operator new(sizeof(Node) + node->key_size + node->value_size)) Node;
+    copy->next.store(nullptr, std::memory_order_relaxed);
+    copy->hash = node->hash;
+    copy->cas = node->cas;
+    copy->key_size = node->key_size;
+    copy->value_size = node->value_size;
+    copy->flags = node->flags;
+    copy->expire = node->expire;
+    copy->referenced.store(node->referenced.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    std::memcpy(copy->key(), node->key(), node->key_size + node->value_size);
+    return copy;
+}
+
+template <typename F> void LockFreeCache::_modify(const Key &key, F &&fn) {
+    std::uint64_t hash = key.hash();
+    // Tables are retired once outgrown, so writers keep them from being freed as readers do
+    EpochDomain::Guard guard(_epochs);
+    Node *node, *result;
+    {
+        std::lock_guard<Concurrency::Mutex> lock(_locks[hash & (LOCKS - 1)]);
+        Table *table = _current(hash);
+        std::atomic<Node *> *link = &table->buckets[hash & table->mask];
+        while ((node = link->load(std::memory_order_relaxed)) != nullptr && !node->Is(hash, key)) {
+            link = &node->next;
+        }
+        bool expired = node != nullptr && node->Expired(_clock());
+        result = fn(expired ? nullptr : node);
+        if (result == node) {
+            return;
+        }
+
+        // Readers see either old chain or the new one, never partially built node
+        Node *next = node != nullptr ? node->next.load(std::memory_order_relaxed) : nullptr;
+        if (result != nullptr) {
+            result->next.store(next, std::memory_order_relaxed);
+            link->store(result, std::memory_order_release);
+            _cur_size += result->Footprint();
+            _items++;
+        } else {
+            link->store(next, std::memory_order_release);
+        }
+        if (node != nullptr) {
+            _cur_size -= node->Footprint();
+            _items--;
+            if (expired) {
+                _expirations++;
+            }
+        }
+    }
+
+    if (node != nullptr) {
+        _epochs.Retire(node, &_delete_node);
+    }
+    if (_old.load() != nullptr) {
+        _migrate_batch();
+    } else if (_items.load(std::memory_order_relaxed) > _table.load()->mask + 1) {
+        _grow();
+    }
+    if (_cur_size.load(std::memory_order_relaxed) > _max_size) {
+        _evict();
+    }
+}
+
+LockFreeCache::Table *LockFreeCache::_current(std::uint64_t hash) {
+    // Table is published as outgrown before the new one is, and the new one is complete before the old one is
+    // cleared, see _grow and _migrate. Key bucket is locked, so it can't be moved in between the loads
+    Table *table = _table.load();
+    Table *old = _old.load();
+    if (old == nullptr) {
+        return table;
+    }
+    std::size_t bucket = hash & old->mask;
+    if (old->buckets[bucket].load(std::memory_order_relaxed) != &MOVED) {
+        _migrate(old, bucket);
+    }
+    return old->next;
+}
+
+void LockFreeCache::_migrate(Table *old, std::size_t bucket) {
+    Table *table = old->next;
+    std::uint32_t now = _clock();
+    // Doubled table splits the bucket into two: the same number and the one past the old size
+    Node *heads[2] = {nullptr, nullptr};
+    Node *chain = old->buckets[bucket].load(std::memory_order_relaxed);
+    for (Node *node = chain; node != nullptr; node = node->next.load(std::memory_order_relaxed)) {
+        if (node->Expired(now)) {
+            _cur_size -= node->Footprint();
+            _items--;
+            _expirations++;
+            continue;
+        }
+        Node *&head = heads[(node->hash & table->mask) == bucket ? 0 : 1];
+        Node *copy = _copy_node(node);
+        copy->next.store(head, std::memory_order_relaxed);
+        head = copy;
+    }
+    table->buckets[bucket].store(heads[0], std::memory_order_release);
+    table->buckets[bucket + old->mask + 1].store(heads[1], std::memory_order_release);
+    old->buckets[bucket].store(&MOVED, std::memory_order_release);
+
+    // Readers that got to the old chain before the mark finish on the old nodes
+    while (chain != nullptr) {
+        Node *next = chain->next.load(std::memory_order_relaxed);
+        _epochs.Retire(chain, &_delete_node);
+        chain = next;
+    }
+    if (_migrated.fetch_add(1) + 1 == old->mask + 1) {
+        _old.store(nullptr);
+        _epochs.Retire(old, &_delete_table);
+    }
+}
+
+void LockFreeCache::_grow() {
+    std::unique_lock<Concurrency::Mutex> lock(_grow_lock, std::try_to_lock);
+    if (!lock.owns_lock() || _old.load() != nullptr) {
+        return;
+    }
+    Table *table = _table.load();
+    if (_items.load(std::memory_order_relaxed) <= table->mask + 1) {
+        return;
+    }
+    table->next = new Table(2 * (table->mask + 1));
+    _migrate_hand.store(0);
+    _migrated.store(0);
+    _old.store(table);
+    _table.store(table->next);
+}
+
+void LockFreeCache::_migrate_batch() {
+    for (std::size_t i = 0; i < MIGRATE_BATCH; ++i) {
+        Table *old = _old.load();
+        if (old == nullptr) {
+            return;
+        }
+        std::size_t bucket = _migrate_hand.fetch_add(1, std::memory_order_relaxed);
+        if (bucket > old->mask) {
+            return;
+        }
+        std::lock_guard<Concurrency::Mutex> lock(_locks[bucket & (LOCKS - 1)]);
+        if (_old.load() == old && old->buckets[bucket].load(std::memory_order_relaxed) != &MOVED) {
+            _migrate(old, bucket);
+        }
+    }
+}
+
+void LockFreeCache::_evict() {
+    std::vector<Node *> removed;
+    // The rest is left to the next writers, so that none of them sweeps the whole table
+    for (std::size_t steps = 0; _cur_size.load(std::memory_order_relaxed) > _max_size && steps < EVICT_BATCH;
+         ++steps) {
+        std::size_t hand = _hand.fetch_add(1, std::memory_order_relaxed);
+        std::uint32_t now = _clock();
+        {
+            std::lock_guard<Concurrency::Mutex> lock(_locks[hand & (LOCKS - 1)]);
+            Table *table = _current(hand);
+            std::atomic<Node *> *link = &table->buckets[hand & table->mask];
+            Node *node;
+            while ((node = link->load(std::memory_order_relaxed)) != nullptr) {
+                bool expired = node->Expired(now);
+                if (!expired && node->referenced.exchange(0, std::memory_order_relaxed) != 0) {
+                    link = &node->next;
+                    continue;
+                }
+                link->store(node->next.load(std::memory_order_relaxed), std::memory_order_release);
+                _cur_size -= node->Footprint();
+                _items--;
+                if (expired) {
+                    _expirations++;
+                } else {
+                    _evictions++;
+                }
+                removed.push_back(node);
+            }
+        }
+        for (Node *node : removed) {
+            _epochs.Retire(node, &_delete_node);
+        }
+        removed.clear();
+    }
+}
+
+// See MapBasedGlobalLockImpl.h
+bool LockFreeCache::Put(const Key &key, const std::string &value, uint32_t flags, uint32_t expire, uint64_t *cas) {
+    if (ItemFootprint(key.size(), value.size()) > _max_size) {
+        return false;
+    }
+    bool expired = expire != 0 && expire <= _clock();
+    _modify(key, [&](Node *node) -> Node * {
+        if (expired) {
+            return _stored(nullptr, cas);
+        }
+        return _stored(_make_node(key.hash(), key, value.data(), value.size(), nullptr, 0, flags, expire), cas);
+    });
+    return true;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool LockFreeCache::PutIfAbsent(const Key &key, const std::string &value, uint32_t flags,
+                                uint32_t expire, uint64_t *cas) {
+    if (ItemFootprint(key.size(), value.size()) > _max_size) {
+        return false;
+    }
+    bool expired = expire != 0 && expire <= _clock();
+    bool result = false;
+    _modify(key, [&](Node *node) -> Node * {
+        if (node != nullptr) {
+            return node;
+        }
+        result = true;
+        return _stored(expired ? nullptr
+                               : _make_node(key.hash(), key, value.data(), value.size(), nullptr, 0, flags, expire),
+                       cas);
+    });
+    return result;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool LockFreeCache::Set(const Key &key, const std::string &value, uint32_t flags, uint32_t expire, uint64_t *cas) {
+    if (ItemFootprint(key.size(), value.size()) > _max_size) {
+        return false;
+    }
+    bool expired = expire != 0 && expire <= _clock();
+    bool result = false;
+    _modify(key, [&](Node *node) -> Node * {
+        if (node == nullptr) {
+            return nullptr;
+        }
+        result = true;
+        return _stored(expired ? nullptr
+                               : _make_node(node->hash, key, value.data(), value.size(), nullptr, 0, flags, expire),
+                       cas);
+    });
+    return result;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool LockFreeCache::Delete(const Key &key) {
+    bool result = false;
+    _modify(key, [&](Node *node) -> Node * {
+        result = node != nullptr;
+        return nullptr;
+    });
+    return result;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool LockFreeCache::Append(const Key &key, const std::string &value, uint64_t *cas) {
+    bool result = false;
+    _modify(key, [&](Node *node) -> Node * {
+        if (node == nullptr || ItemFootprint(key.size(), node->value_size + value.size()) > _max_size) {
+            return node;
+        }
+        result = true;
+        return _stored(_make_node(node->hash, key, node->value(), node->value_size, value.data(), value.size(),
+                                  node->flags, node->expire),
+                       cas);
+    });
+    return result;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool LockFreeCache::Prepend(const Key &key, const std::string &value, uint64_t *cas) {
+    bool result = false;
+    _modify(key, [&](Node *node) -> Node * {
+        if (node == nullptr || ItemFootprint(key.size(), node->value_size + value.size()) > _max_size) {
+            return node;
+        }
+        result = true;
+        return _stored(_make_node(node->hash, key, value.data(), value.size(), node->value(), node->value_size,
+                                  node->flags, node->expire),
+                       cas);
+    });
+    return result;
+}
+
+Storage::Status LockFreeCache::_add(const Key &key, std::uint64_t delta, bool substract, std::uint64_t &value,
+                                    std::uint64_t *cas) {
+    Status result = Status::NOT_FOUND;
+    _modify(key, [&](Node *node) -> Node * {
+        if (node == nullptr) {
+            return nullptr;
+        }
+        result = Status::NOT_STORED;
+        const char *digits = node->value();
+        std::uint64_t number = 0;
+        if (node->value_size == 0) {
+            return node;
+        }
+        for (std::uint32_t i = 0; i < node->value_size; ++i) {
+            if (digits[i] < '0' || digits[i] > '9' || number > (UINT64_MAX - (digits[i] - '0')) / 10) {
+                return node;
+            }
+            number = number * 10 + (digits[i] - '0');
+        }
+
+        if (substract) {
+            value = number < delta ? 0 : number - delta;
+        } else {
+            value = number + delta;
+        }
+        std::string printed = std::to_string(value);
+        result = Status::STORED;
+        return _stored(
+            _make_node(node->hash, key, printed.data(), printed.size(), nullptr, 0, node->flags, node->expire), cas);
+    });
+    return result;
+}
+
+// See MapBasedGlobalLockImpl.h
+Storage::Status LockFreeCache::Incr(const Key &key, uint64_t delta, uint64_t &value, uint64_t *cas) {
+    return _add(key, delta, false, value, cas);
+}
+
+// See MapBasedGlobalLockImpl.h
+Storage::Status LockFreeCache::Decr(const Key &key, uint64_t delta, uint64_t &value, uint64_t *cas) {
+    return _add(key, delta, true, value, cas);
+}
+
+// See MapBasedGlobalLockImpl.h
+Storage::Status LockFreeCache::CompareAndSet(const Key &key, const std::string &value, uint32_t flags,
+                                             uint32_t expire, uint64_t cas, uint64_t *new_cas) {
+    if (ItemFootprint(key.size(), value.size()) > _max_size) {
+        return Status::NOT_STORED;
+    }
+    bool expired = expire != 0 && expire <= _clock();
+    Status result = Status::NOT_FOUND;
+    _modify(key, [&](Node *node) -> Node * {
+        if (node == nullptr) {
+            return nullptr;
+        }
+        if (node->cas != cas) {
+            result = Status::EXISTS;
+            return node;
+        }
+        result = Status::STORED;
+        return _stored(expired ? nullptr
+                               : _make_node(node->hash, key, value.data(), value.size(), nullptr, 0, flags, expire),
+                       new_cas);
+    });
+    return result;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool LockFreeCache::Get(const Key &key, std::string &value, uint32_t *flags, uint64_t *cas, uint32_t *expire) {
+    std::uint64_t hash = key.hash();
+    EpochDomain::Guard guard(_epochs);
+    // Outgrown table is searched first, keys of its buckets not moved yet are only there
+    Table *table = _table.load();
+    Table *old = _old.load();
+    if (old != nullptr) {
+        table = old;
+    }
+    Node *node = table->buckets[hash & table->mask].load(std::memory_order_acquire);
+    while (node == &MOVED) {
+        table = table->next;
+        node = table->buckets[hash & table->mask].load(std::memory_order_acquire);
+    }
+    while (node != nullptr && !node->Is(hash, key)) {
+        node = node->next.load(std::memory_order_acquire);
+    }
+    if (node == nullptr || node->Expired(_clock())) {
+        _reads.Get().misses.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    _reads.Get().hits.fetch_add(1, std::memory_order_relaxed);
+    value.assign(node->value(), node->value_size);
+    if (flags != nullptr) {
+        *flags = node->flags;
+    }
+    if (cas != nullptr) {
+        *cas = node->cas;
+    }
+    if (expire != nullptr) {
+        *expire = node->expire;
+    }
+    // Don't dirty cache line of the hot node if mark is set already
+    if (node->referenced.load(std::memory_order_relaxed) == 0) {
+        node->referenced.store(1, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+// See LockFreeCache.h
+void LockFreeCache::GetStats(std::vector<std::pair<std::string, uint64_t>> &stats) const {
+    std::uint64_t hits = 0, misses = 0;
+    _reads.ForEach([&hits, &misses](const ReadCounters &cpu) {
+        hits += cpu.hits.load(std::memory_order_relaxed);
+        misses += cpu.misses.load(std::memory_order_relaxed);
+    });
+    stats.emplace_back("get_hits", hits);
+    stats.emplace_back("get_misses", misses);
+    stats.emplace_back("curr_items", _items.load(std::memory_order_relaxed));
+    stats.emplace_back("bytes", _cur_size.load(std::memory_order_relaxed));
+    stats.emplace_back("limit_maxbytes", _max_size);
+    stats.emplace_back("evictions", _evictions.load(std::memory_order_relaxed));
+    stats.emplace_back("expirations", _expirations.load(std::memory_order_relaxed));
+    EpochDomain::Guard guard(_epochs);
+    std::uint64_t power = 0;
+    for (std::size_t buckets = _table.load()->mask + 1; buckets > 1; buckets >>= 1) {
+        power++;
+    }
+    stats.emplace_back("hash_power_level", power);
+    stats.emplace_back("hash_is_expanding", _old.load() != nullptr);
+}
+
+} // namespace Backend
+} // namespace Afina
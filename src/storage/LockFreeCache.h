@@ -0,0 +1,226 @@
+#ifndef AFINA_STORAGE_LOCK_FREE_CACHE_H
+#define AFINA_STORAGE_LOCK_FREE_CACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <afina/Storage.h>
+#include <afina/concurrency/CoreLocal.h>
+#include <afina/concurrency/Mutex.h>
+
+#include "EpochDomain.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Hash table with lock-free reads
+ * Chained hash table of immutable nodes. Readers walk chains without any lock inside EpochDomain guard,
+ * so they never block and never write shared memory except the referenced mark of the found node. Writers
+ * of the same bucket are serialized by a striped lock, they build new node and swap it into the chain
+ * with single atomic store. Replaced and removed nodes are retired to the epoch domain and freed once
+ * no reader could see them.
+ *
+ * Table starts small and doubles once there are more items than buckets. Buckets of the outgrown table
+ * are moved to the new one by writers: the one of the written key first, then a few more per write. Moved
+ * bucket gets copies of its nodes in the new table and MOVED mark in the old one, readers that find the
+ * mark go on to the next table.
+ *
+ * Eviction is CLOCK over buckets: once memory limit is exceeded, writer moves shared hand over buckets
+ * clearing referenced marks and evicting nodes not read since the last pass. Expired nodes are invisible
+ * to readers and are dropped by the hand or by the next write of the key.
+ *
+ * Limit is checked after insertion and every write moves the hand by at most EVICT_BATCH buckets, so the
+ * limit could be exceeded by a few items until the next writers get the hand to the nodes not read lately
+ */
+class LockFreeCache : public Afina::Storage {
+public:
+    /**
+     * @param max_size memory limit in bytes
+     */
+    explicit LockFreeCache(std::size_t max_size = 16 * 1024 * 1024UL);
+    ~LockFreeCache();
+
+    // Implements Afina::Storage interface
+    bool Put(const Key &key, const std::string &value, uint32_t flags = 0, uint32_t expire = 0,
+             uint64_t *cas = nullptr) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const Key &key, const std::string &value, uint32_t flags = 0,
+                     uint32_t expire = 0, uint64_t *cas = nullptr) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const Key &key, const std::string &value, uint32_t flags = 0, uint32_t expire = 0,
+             uint64_t *cas = nullptr) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const Key &key) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const Key &key, const std::string &value, uint64_t *cas = nullptr) override;
+
+    // Implements Afina::Storage interface
+    bool Prepend(const Key &key, const std::string &value, uint64_t *cas = nullptr) override;
+
+    // Implements Afina::Storage interface
+    Status Incr(const Key &key, uint64_t delta, uint64_t &value, uint64_t *cas = nullptr) override;
+
+    // Implements Afina::Storage interface
+    Status Decr(const Key &key, uint64_t delta, uint64_t &value, uint64_t *cas = nullptr) override;
+
+    // Implements Afina::Storage interface, never takes locks
+    bool Get(const Key &key, std::string &value, uint32_t *flags = nullptr, uint64_t *cas = nullptr,
+             uint32_t *expire = nullptr) override;
+
+    // Implements Afina::Storage interface
+    Status CompareAndSet(const Key &key, const std::string &value, uint32_t flags, uint32_t expire,
+                         uint64_t cas, uint64_t *new_cas = nullptr) override;
+
+    // Implements Afina::Storage interface
+    void GetStats(std::vector<std::pair<std::string, uint64_t>> &stats) const override;
+
+    /**
+     * Number of bytes the item takes from the memory limit: node allocation including allocator overhead
+     */
+    static std::size_t ItemFootprint(std::size_t key_size, std::size_t value_size);
+
+private:
+    // Number of locks serializing writers, bucket uses lock of its number modulo LOCKS. Table never has
+    // fewer buckets, so the lock is the same for the key in the old table and in the new one
+    static constexpr std::size_t LOCKS = 1024;
+    // Max number of buckets the writer moves clock hand over
+    static constexpr std::size_t EVICT_BATCH = 64;
+    // Number of buckets of the outgrown table the writer moves besides the one of its key
+    static constexpr std::size_t MIGRATE_BATCH = 4;
+
+    // Immutable once published except next link and referenced mark
+    struct Node {
+        std::atomic<Node *> next;
+        std::uint64_t hash;
+        std::uint64_t cas;
+        std::uint32_t key_size;
+        std::uint32_t value_size;
+        std::uint32_t flags;
+        std::uint32_t expire;
+        std::atomic<std::uint8_t> referenced;
+
+        char *key() { return reinterpret_cast<char *>(this + 1); }
+        char *value() { return key() + key_size; }
+        bool Is(std::uint64_t h, const Key &k) {
+            return hash == h && key_size == k.size() && std::memcmp(key(), k.data(), key_size) == 0;
+        }
+        bool Expired(std::uint32_t now) const { return expire != 0 && expire <= now; }
+        std::size_t Footprint() const { return ItemFootprint(key_size, value_size); }
+    };
+
+    // Chains of nodes, the outgrown table links to the one its buckets are moved to
+    struct Table {
+        explicit Table(std::size_t size);
+
+        std::size_t mask;
+        std::unique_ptr<std::atomic<Node *>[]> buckets;
+        Table *next;
+    };
+
+    // Head of the bucket moved to the next table
+    static Node MOVED;
+
+    // New node with the value built of up to two parts
+    Node *_make_node(std::uint64_t hash, const Key &key, const char *value, std::size_t value_size,
+                     const char *suffix, std::size_t suffix_size, std::uint32_t flags, std::uint32_t expire);
+
+    // Copy of the node to link into another chain
+    Node *_copy_node(Node *node);
+
+    // Reports version of the node replacing the old one, 0 if item is removed, and passes the node through.
+    // Called from inside of _modify: once bucket is unlocked node could be evicted and freed
+    static Node *_stored(Node *node, std::uint64_t *cas) {
+        if (cas != nullptr) {
+            *cas = node != nullptr ? node->cas : 0;
+        }
+        return node;
+    }
+
+    static void _delete_node(void *node) { ::operator delete(node); }
+
+    static void _delete_table(void *table) { delete static_cast<Table *>(table); }
+
+    // Frees nodes of the table, not the table itself
+    static void _clear(Table *table);
+
+    /**
+     * Locks the key bucket and calls fn(Node *live) with the current node of the key, nullptr if there is no
+     * such key or it has expired. Function returns node to have instead: the same one to keep it, new one
+     * to replace it, or nullptr to remove it
+     */
+    template <typename F> void _modify(const Key &key, F &&fn);
+
+    // Adds or substracts delta from the decimal number value
+    Status _add(const Key &key, std::uint64_t delta, bool substract, std::uint64_t &value, std::uint64_t *cas);
+
+    /**
+     * Table the key of the hash goes to, called under the lock of the key bucket. If the table is being
+     * grown, moves the key bucket of the outgrown table first
+     */
+    Table *_current(std::uint64_t hash);
+
+    // Copies nodes of the bucket to the next table and marks it moved, called under the lock of the bucket
+    void _migrate(Table *old, std::size_t bucket);
+
+    // Starts growing the table once it has more items than buckets
+    void _grow();
+
+    // Moves next MIGRATE_BATCH buckets of the outgrown table
+    void _migrate_batch();
+
+    // Moves clock hand over at most EVICT_BATCH buckets evicting nodes until memory usage gets below the limit
+    void _evict();
+
+    std::uint32_t _clock() const { return std::time(nullptr); }
+
+    const std::size_t _max_size;
+
+    std::atomic<Table *> _table;
+    // Outgrown table while its buckets are moved to _table, nullptr otherwise
+    std::atomic<Table *> _old;
+    std::unique_ptr<Concurrency::Mutex[]> _locks;
+    // Taken by the writer starting to grow the table
+    Concurrency::Mutex _grow_lock;
+
+    // Next bucket of _old to move and number of buckets moved so far
+    std::atomic<std::size_t> _migrate_hand;
+    std::atomic<std::size_t> _migrated;
+
+    // Position of the eviction clock hand, bucket number is hand & mask of the table
+    std::atomic<std::size_t> _hand;
+
+    // Stats keep the table from being freed while reading it as well
+    mutable EpochDomain _epochs;
+
+    std::atomic<std::size_t> _cur_size;
+    std::atomic<std::size_t> _items;
+    std::atomic<std::uint64_t> _cas;
+
+    // Readers are lock-free, so their counters must not be shared cache line either
+    struct ReadCounters {
+        std::atomic<std::uint64_t> hits;
+        std::atomic<std::uint64_t> misses;
+    };
+    Concurrency::CoreLocal<ReadCounters> _reads;
+
+    std::atomic<std::uint64_t> _evictions;
+    std::atomic<std::uint64_t> _expirations;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_LOCK_FREE_CACHE_H
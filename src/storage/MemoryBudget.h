@@ -0,0 +1,85 @@
+#ifndef AFINA_STORAGE_MEMORY_BUDGET_H
+#define AFINA_STORAGE_MEMORY_BUDGET_H
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Memory limit shared by several caches
+ * Cache takes bytes from the budget before it allocates memory and gives them back once memory is freed.
+ * Accounting is atomic, so caches guarded by different locks could share one budget.
+ *
+ * Cache that can't get enough bytes could ask budget to reclaim memory from the other caches, see
+ * SetReclaimer. Owner of the caches decides how to do that
+ */
+class MemoryBudget {
+public:
+    /**
+     * Reclaims at least required bytes from caches other than requester, returns false if it couldn't
+     */
+    using Reclaimer = std::function<bool(const void *requester, std::size_t required)>;
+
+    explicit MemoryBudget(std::size_t limit) : _limit(limit), _used(0), _high_watermark(limit) {}
+
+    std::size_t Limit() const { return _limit; }
+    std::size_t Used() const { return _used.load(std::memory_order_relaxed); }
+
+    /**
+     * Takes bytes from the budget, returns false and takes nothing if that would exceed the limit
+     */
+    bool Acquire(std::size_t bytes) {
+        std::size_t used = _used.load(std::memory_order_relaxed);
+        do {
+            if (bytes > _limit - used) {
+                return false;
+            }
+        } while (!_used.compare_exchange_weak(used, used + bytes, std::memory_order_relaxed));
+        if (used <= _high_watermark && used + bytes > _high_watermark && _on_pressure) {
+            _on_pressure();
+        }
+        return true;
+    }
+
+    /**
+     * Gives bytes taken by Acquire back
+     */
+    void Release(std::size_t bytes) { _used.fetch_sub(bytes, std::memory_order_relaxed); }
+
+    /**
+     * Sets the way memory is reclaimed from the caches sharing budget. Must be set before the
+     * caches are used
+     */
+    void SetReclaimer(Reclaimer reclaimer) { _reclaimer = std::move(reclaimer); }
+
+    /**
+     * Sets function called once usage goes above the high watermark. Must be set before the caches
+     * are used
+     */
+    void SetWatermark(std::size_t high_watermark, std::function<void()> on_pressure) {
+        _high_watermark = high_watermark;
+        _on_pressure = std::move(on_pressure);
+    }
+
+    /**
+     * Asks other caches to free at least required bytes, returns false if nothing was freed
+     */
+    bool Reclaim(const void *requester, std::size_t required) const {
+        return _reclaimer && _reclaimer(requester, required);
+    }
+
+private:
+    const std::size_t _limit;
+    std::atomic<std::size_t> _used;
+    Reclaimer _reclaimer;
+    std::size_t _high_watermark;
+    std::function<void()> _on_pressure;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_MEMORY_BUDGET_H
@@ -1,57 +1,209 @@
 #include "SimpleLRU.h"
-#include <sstream>
+
+#include <algorithm>
+#include <cstring>
+#include <new>
 #include <string>
 
 
 namespace Afina {
 namespace Backend {
 
-bool SimpleLRU::_move_to_head(lru_node &node) {
-    if (&node == _lru_head.get()) {
-        return true;
+constexpr std::uint32_t SimpleLRU::NIL;
+constexpr std::size_t SimpleLRU::PREFETCH_GROUP;
+
+SimpleLRU::SimpleLRU(size_t max_size, Policy policy, bool admission, std::shared_ptr<MemoryBudget> budget,
+                     bool inline_values)
+    : _max_size(max_size), _cur_size(0), _budget(std::move(budget)), _timers(_nodes, std::time(nullptr)), _window_limit(0),
+      _lru_index(node_hash{&_nodes}), _inline_size(0), _hits(0), _misses(0), _evictions(0), _rejections(0),
+      _expirations(0), _cas(0) {
+    if (_budget == nullptr) {
+        _budget.reset(new MemoryBudget(max_size));
+    }
+    if (inline_values) {
+        std::size_t slots = max_size / 8 / InlineTable::Footprint(1);
+        if (slots >= 2 && _budget->Acquire(InlineTable::Footprint(slots))) {
+            _inline_size = InlineTable::Footprint(slots);
+            _inline.reset(new InlineTable(slots));
+        }
     }
-    if (&node == _lru_tail) { // tail != head (!)
-        _lru_tail = _lru_tail->prev;
+    if (admission) {
+        // Window takes 1% of the memory, sketch counts as many keys as smallest items fit
+        _window_limit = max_size / 100;
+        _sketch.reset(new FrequencySketch(max_size / ItemFootprint(0, 0)));
+        _window = EvictionPolicy::Build(Policy::CLOCK, _nodes, _window_limit);
     }
-    lru_node *prev_node = node.prev;
-    // cut and relink
-    std::unique_ptr<lru_node> tmp_holder(std::move(prev_node->next));
-    prev_node->next = std::move(tmp_holder->next);
-    if (prev_node->next != nullptr) {
-        prev_node->next->prev = prev_node;
+    _main = EvictionPolicy::Build(policy, _nodes, max_size - _window_limit);
+}
+
+SimpleLRU::~SimpleLRU() {
+    for (CacheNode *node : _nodes) {
+        ::operator delete(node);
     }
+    _budget->Release(_inline_size);
+}
 
-    _lru_head->prev = &node;
-    tmp_holder->next = std::move(_lru_head);
-    _lru_head = std::move(tmp_holder);
-    _lru_head->prev = nullptr;
-    return true;
+// See SimpleLRU.h
+std::size_t SimpleLRU::ItemFootprint(std::size_t key_size, std::size_t value_size) {
+    return CacheNode::Footprint(key_size, value_size);
 }
 
-bool SimpleLRU::_pop_lru_node() {
-    if (_lru_tail == nullptr) { // pop from empty list
-        return false;
+std::uint32_t SimpleLRU::_find_node(const Key &key) const {
+    const std::uint32_t *pos = _lru_index.Find(key.hash(), [this, &key](std::uint32_t id) {
+        CacheNode *node = _nodes[id];
+        return node->key_size == key.size() && std::memcmp(node->key(), key.data(), key.size()) == 0;
+    });
+    return pos == nullptr ? NIL : *pos;
+}
+
+std::uint32_t SimpleLRU::_alloc_node(const Key &key, const std::string &value) {
+    CacheNode *node = new (::operator new(sizeof(CacheNode) + key.size() + value.size())) CacheNode;
+    node->hash = key.hash();
+    node->referenced.store(0, std::memory_order_relaxed);
+    node->segment = 0;
+    node->window = 0;
+    node->prev = node->next = NIL;
+    node->expire = 0;
+    node->timer_prev = node->timer_next = NIL;
+    node->timer_slot = CacheNode::NO_SLOT;
+    node->key_size = key.size();
+    node->value_size = node->value_capacity = value.size();
+    std::memcpy(node->key(), key.data(), key.size());
+    std::memcpy(node->value(), value.data(), value.size());
+
+    std::uint32_t id;
+    if (_free_ids.empty()) {
+        id = _nodes.size();
+        _nodes.push_back(node);
+    } else {
+        id = _free_ids.back();
+        _free_ids.pop_back();
+        _nodes[id] = node;
+    }
+    _cur_size += node->Footprint();
+    return id;
+}
+
+CacheNode *SimpleLRU::_detach_node(std::uint32_t id) {
+    CacheNode *node = _nodes[id];
+    _cur_size -= node->Footprint();
+    _nodes[id] = nullptr;
+    _free_ids.push_back(id);
+    return node;
+}
+
+void SimpleLRU::_free_node(std::uint32_t id) {
+    CacheNode *node = _detach_node(id);
+    _budget->Release(node->Footprint());
+    ::operator delete(node);
+}
+
+void SimpleLRU::_publish(std::uint32_t id) {
+    if (_inline != nullptr) {
+        CacheNode *node = _nodes[id];
+        _inline->Store(node->hash, node->key(), node->key_size, node->value(), node->value_size, node->flags,
+                       node->expire, node->cas);
+    }
+}
+
+void SimpleLRU::_unlink_node(std::uint32_t id, bool evicted) {
+    if (_inline != nullptr) {
+        _inline->Erase(_nodes[id]->hash);
+    }
+    _lru_index.Erase(_nodes[id]->hash, [id](std::uint32_t other) { return other == id; });
+    _owner(id).Remove(id, evicted);
+    _timers.Cancel(id);
+}
+
+void SimpleLRU::_erase_node(std::uint32_t id, bool evicted) {
+    _unlink_node(id, evicted);
+    _free_node(id);
+}
+
+void SimpleLRU::_set_expire(std::uint32_t id, std::uint32_t expire) {
+    _timers.Cancel(id);
+    _nodes[id]->expire = expire;
+    if (expire != 0) {
+        _timers.Schedule(id);
     }
-    auto cur_pos = _lru_index.find(_lru_tail->key);
-    if (cur_pos == _lru_index.end()) { // incorrect tail
+}
+
+bool SimpleLRU::_update_node(std::uint32_t id, const std::string &value, std::uint32_t flags, std::uint32_t expire) {
+    if (!_set_val_node(id, value.data(), value.size())) {
         return false;
     }
-    lru_node &cur_elem = cur_pos->second.get();
-    _lru_index.erase(cur_pos);
-    _cur_size -= cur_elem.key.size() + cur_elem.value.size();
-    if (&cur_elem == _lru_head.get()) { // list is empty
-        _lru_head.reset(); 
-    } else {
-        _lru_tail = cur_elem.prev;
-        _lru_tail->next.reset();
+    CacheNode *node = _nodes[id];
+    node->flags = flags;
+    node->cas = ++_cas;
+    _set_expire(id, expire);
+    _publish(id);
+    return true;
+}
+
+void SimpleLRU::_expire_nodes(std::uint32_t now) {
+    _timers.Advance(now, _expired);
+    for (std::uint32_t id : _expired) {
+        _erase_node(id, false);
+        _expirations++;
+    }
+    _expired.clear();
+}
+
+std::uint32_t SimpleLRU::_policy_victim(EvictionPolicy &policy, std::uint32_t pinned) {
+    std::uint32_t victim = policy.Victim(pinned);
+    while (victim != NIL && _inline != nullptr && _inline->Touched(_nodes[victim]->hash)) {
+        if (_sketch != nullptr) {
+            _sketch->Increment(_nodes[victim]->hash);
+        }
+        policy.Hit(victim);
+        victim = policy.Victim(pinned);
+    }
+    return victim;
+}
+
+std::uint32_t SimpleLRU::_victim(std::size_t required, std::uint32_t pinned) {
+    std::uint32_t victim = _policy_victim(*_main, pinned);
+    if (_window != nullptr && _window->Size() != 0) {
+        std::uint32_t candidate = _policy_victim(*_window, pinned);
+        if (candidate == NIL) {
+            // keep main victim
+        } else if (victim == NIL) {
+            victim = candidate;
+        } else if (_window->Size() + required > _window_limit) {
+            // Window is going to overflow: its victim competes with main one for the place in the main policy
+            if (_sketch->Frequency(_nodes[candidate]->hash) > _sketch->Frequency(_nodes[victim]->hash)) {
+                _window->Remove(candidate, false);
+                _nodes[candidate]->window = 0;
+                _main->Prepare(_nodes[candidate]->hash, _nodes[candidate]->Footprint());
+                _main->Insert(candidate);
+            } else {
+                victim = candidate;
+                _rejections++;
+            }
+        }
     }
+    return victim;
+}
+
+bool SimpleLRU::_evict(std::size_t required, std::uint32_t pinned) {
+    std::uint32_t victim = _victim(required, pinned);
+    if (victim == NIL) {
+        return false;
+    }
+    _erase_node(victim, true);
+    _evictions++;
     return true;
 }
 
 
-bool SimpleLRU::_free_space(std::size_t required) {
-    while (_max_size - _cur_size < required) {
-        if (!_pop_lru_node()) {
+bool SimpleLRU::_free_space(std::size_t required, std::uint32_t pinned) {
+    while (!_budget->Acquire(required)) {
+        // Cache holding less than its share makes the others give memory back, otherwise it evicts
+        // own nodes
+        if (_cur_size < _max_size && _budget->Reclaim(this, required)) {
+            continue;
+        }
+        if (!_evict(required, pinned)) {
             return false;
         }
     }
@@ -59,128 +211,451 @@ bool SimpleLRU::_free_space(std::size_t required) {
 }
 
 
-bool SimpleLRU::_put_new_node(const std::string &key, const std::string &value) {
-    std::size_t elem_size = key.size() + value.size();
-    if (!_free_space(elem_size)) {
+bool SimpleLRU::_put_new_node(const Key &key, const std::string &value, std::uint32_t flags,
+                              std::uint32_t expire) {
+    std::size_t footprint = ItemFootprint(key.size(), value.size());
+    (_window != nullptr ? *_window : *_main).Prepare(key.hash(), footprint);
+    if (!_free_space(footprint, NIL)) {
         return false;
     }
-    std::unique_ptr<lru_node> tmp_holder(new lru_node{ key, value, nullptr, nullptr });
-    tmp_holder->next = std::move(_lru_head);
-    _lru_head = std::move(tmp_holder);
-    if (_lru_head->next != nullptr) { // list was not empty
-        _lru_head->next->prev = _lru_head.get();
-    } else {
-        _lru_tail = _lru_head.get();
+    std::uint32_t id = _alloc_node(key, value);
+    _lru_index.Insert(key.hash(), id);
+    _nodes[id]->flags = flags;
+    _nodes[id]->cas = ++_cas;
+    _set_expire(id, expire);
+    _publish(id);
+    if (_window == nullptr) {
+        _main->Insert(id);
+        return true;
     }
-    _cur_size += key.size() + value.size();
 
-    _lru_index.insert({std::cref(_lru_head->key), std::ref(*(_lru_head.get()))});
+    _nodes[id]->window = 1;
+    _window->Insert(id);
+    // Memory was free, so window overflow joins main policy without competition
+    while (_window->Size() > _window_limit) {
+        std::uint32_t tail = _window->Victim(id);
+        if (tail == NIL) {
+            break;
+        }
+        _window->Remove(tail, false);
+        _nodes[tail]->window = 0;
+        _main->Insert(tail);
+    }
     return true;
 }
 
 
-bool SimpleLRU::_set_val_node(lru_node &node, const std::string &new_value) {
-    if (node.key.size() + new_value.size() > _max_size) {
-        return false;
-    }
-    if (!_move_to_head(node)) { // so our node can not be popped out from list tail
-        return false;
-    }
-    if (new_value.size() > node.value.size()) {
-        if (!_free_space(new_value.size() - node.value.size())) {
+bool SimpleLRU::_set_val_node(std::uint32_t id, const char *data, std::size_t size) {
+    // update is an access too, also moves node away from eviction in LRU
+    _owner(id).Hit(id);
+
+    CacheNode *node = _nodes[id];
+    if (size > node->value_capacity || size < node->value_capacity / 2) {
+        // Value doesn't fit or wastes too much memory, reallocate node
+        if (!_realloc_node(id, size, 0)) {
             return false;
         }
+        node = _nodes[id];
     }
-    _cur_size += new_value.size() - node.value.size();
-    node.value = new_value;
+    std::memcpy(node->value(), data, size);
+    node->value_size = size;
     return true;
 }
 
-
-bool SimpleLRU::_erase_storage_node(lru_node &node) {
-    if (!_move_to_head(node)) {
+bool SimpleLRU::_realloc_node(std::uint32_t id, std::size_t capacity, std::size_t keep) {
+    CacheNode *node = _nodes[id];
+    std::size_t old_size = node->Footprint();
+    std::size_t new_size = ItemFootprint(node->key_size, capacity);
+    if (new_size > old_size && !_free_space(new_size - old_size, id)) {
         return false;
     }
-    _lru_head = std::move(node.next);
-    _lru_head->prev = nullptr;
-    if (_lru_head->next == nullptr) { // case single node
-        _lru_tail = nullptr;
+    node = _nodes[id];
+
+    CacheNode *new_node = new (::operator new(sizeof(CacheNode) + node->key_size + capacity)) CacheNode;
+    new_node->hash = node->hash;
+    new_node->prev = node->prev;
+    new_node->next = node->next;
+    new_node->key_size = node->key_size;
+    new_node->value_size = keep;
+    new_node->value_capacity = capacity;
+    new_node->cas = node->cas;
+    new_node->flags = node->flags;
+    new_node->expire = node->expire;
+    new_node->timer_prev = node->timer_prev;
+    new_node->timer_next = node->timer_next;
+    new_node->timer_slot = node->timer_slot;
+    new_node->referenced.store(node->referenced.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    new_node->segment = node->segment;
+    new_node->window = node->window;
+    std::memcpy(new_node->key(), node->key(), node->key_size);
+    std::memcpy(new_node->value(), node->value(), keep);
+    ::operator delete(node);
+    _nodes[id] = new_node;
+    _cur_size = _cur_size - old_size + new_size;
+    if (new_size < old_size) {
+        _budget->Release(old_size - new_size);
     }
+    _owner(id).Resize(id, old_size);
     return true;
 }
 
 // See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Put(const std::string &key, const std::string &value) { 
-    if (key.size() + value.size() > _max_size) {
+bool SimpleLRU::Put(const Key &key, const std::string &value, uint32_t flags, uint32_t expire, uint64_t *cas) {
+    if (ItemFootprint(key.size(), value.size()) > _budget->Limit()) {
         return false;
     }
-    auto cur_pos = _lru_index.find(key);
-    if (cur_pos == _lru_index.end()) {
-        return _put_new_node(key, value);
+    std::uint32_t now = _clock();
+    _expire_nodes(now);
+    if (_sketch != nullptr) {
+        _sketch->Increment(key.hash());
+    }
+    std::uint32_t id = _find_node(key);
+    if (expire != 0 && expire <= now) {
+        // Stored and expired at once
+        if (id != NIL) {
+            _erase_node(id, false);
+        }
+        if (cas != nullptr) {
+            *cas = 0;
+        }
+        return true;
+    }
+    if (id == NIL) {
+        return _stored(_put_new_node(key, value, flags, expire), cas);
     }
-    lru_node &node = cur_pos->second.get();
-    return _set_val_node(node, value);
+    return _stored(_update_node(id, value, flags, expire), cas);
 }
 
 // See MapBasedGlobalLockImpl.h
-bool SimpleLRU::PutIfAbsent(const std::string &key, const std::string &value) {
-    if (key.size() + value.size() > _max_size) {
+bool SimpleLRU::PutIfAbsent(const Key &key, const std::string &value, uint32_t flags, uint32_t expire,
+                            uint64_t *cas) {
+    if (ItemFootprint(key.size(), value.size()) > _budget->Limit()) {
         return false;
     }
-    auto cur_pos = _lru_index.find(key);
-    if (cur_pos != _lru_index.end()) {
+    std::uint32_t now = _clock();
+    _expire_nodes(now);
+    if (_sketch != nullptr) {
+        _sketch->Increment(key.hash());
+    }
+    if (_find_node(key) != NIL) {
         return false;
     }
-    return _put_new_node(key, value);
+    if (expire != 0 && expire <= now) {
+        if (cas != nullptr) {
+            *cas = 0;
+        }
+        return true;
+    }
+    return _stored(_put_new_node(key, value, flags, expire), cas);
 }
 
 // See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Set(const std::string &key, const std::string &value) {
-    if (key.size() + value.size() > _max_size) {
+bool SimpleLRU::Set(const Key &key, const std::string &value, uint32_t flags, uint32_t expire, uint64_t *cas) {
+    if (ItemFootprint(key.size(), value.size()) > _budget->Limit()) {
         return false;
     }
-    auto cur_pos = _lru_index.find(key);    
-    if (cur_pos == _lru_index.end()) {
+    std::uint32_t now = _clock();
+    _expire_nodes(now);
+    std::uint32_t id = _find_node(key);
+    if (id == NIL) {
         return false;
     }
-    return _set_val_node(cur_pos->second.get(), value);
+    if (expire != 0 && expire <= now) {
+        _erase_node(id, false);
+        if (cas != nullptr) {
+            *cas = 0;
+        }
+        return true;
+    }
+    return _stored(_update_node(id, value, flags, expire), cas);
+}
+
+// See MapBasedGlobalLockImpl.h
+Storage::Status SimpleLRU::CompareAndSet(const Key &key, const std::string &value, uint32_t flags,
+                                         uint32_t expire, uint64_t cas, uint64_t *new_cas) {
+    if (ItemFootprint(key.size(), value.size()) > _budget->Limit()) {
+        return Status::NOT_STORED;
+    }
+    std::uint32_t now = _clock();
+    _expire_nodes(now);
+    std::uint32_t id = _find_node(key);
+    if (id == NIL) {
+        return Status::NOT_FOUND;
+    }
+    if (_nodes[id]->cas != cas) {
+        return Status::EXISTS;
+    }
+    if (expire != 0 && expire <= now) {
+        _erase_node(id, false);
+        if (new_cas != nullptr) {
+            *new_cas = 0;
+        }
+        return Status::STORED;
+    }
+    return _stored(_update_node(id, value, flags, expire), new_cas) ? Status::STORED : Status::NOT_STORED;
 }
 
 // See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Delete(const std::string &key) {
-    auto cur_pos = _lru_index.find(key);
-    if (cur_pos == _lru_index.end()) {
+bool SimpleLRU::Delete(const Key &key) {
+    _expire_nodes(_clock());
+    std::uint32_t id = _find_node(key);
+    if (id == NIL) {
+        return false;
+    }
+    _erase_node(id, false);
+    return true;
+}
+
+bool SimpleLRU::_concat_node(const Key &key, const std::string &data, bool front, std::uint64_t *cas) {
+    _expire_nodes(_clock());
+    std::uint32_t id = _find_node(key);
+    if (id == NIL) {
+        return false;
+    }
+    CacheNode *node = _nodes[id];
+    std::size_t size = node->value_size + data.size();
+    if (ItemFootprint(node->key_size, size) > _budget->Limit()) {
         return false;
     }
-    lru_node &cur_node = cur_pos->second.get();
-    _lru_index.erase(cur_pos);
-    _cur_size -= cur_node.key.size() + cur_node.value.size();
-    return _erase_storage_node(cur_node);
+    _owner(id).Hit(id);
+    if (size > node->value_capacity) {
+        // Reserve room for the next updates, so value growing by small pieces is reallocated
+        // only logarithmic number of times
+        std::size_t capacity = size + size / 2;
+        if (ItemFootprint(node->key_size, capacity) > _budget->Limit()) {
+            capacity = size;
+        }
+        if (!_realloc_node(id, capacity, node->value_size)) {
+            return false;
+        }
+        node = _nodes[id];
+    }
+
+    char *value = node->value();
+    if (front) {
+        std::memmove(value + data.size(), value, node->value_size);
+        std::memcpy(value, data.data(), data.size());
+    } else {
+        std::memcpy(value + node->value_size, data.data(), data.size());
+    }
+    node->value_size = size;
+    node->cas = ++_cas;
+    _publish(id);
+    return _stored(true, cas);
+}
+
+Storage::Status SimpleLRU::_add_node(const Key &key, std::uint64_t delta, bool substract, std::uint64_t &value,
+                                     std::uint64_t *cas) {
+    _expire_nodes(_clock());
+    std::uint32_t id = _find_node(key);
+    if (id == NIL) {
+        return Status::NOT_FOUND;
+    }
+
+    CacheNode *node = _nodes[id];
+    const char *digits = node->value();
+    if (node->value_size == 0) {
+        return Status::NOT_STORED;
+    }
+    std::uint64_t number = 0;
+    for (std::uint32_t i = 0; i < node->value_size; ++i) {
+        if (digits[i] < '0' || digits[i] > '9' || number > (UINT64_MAX - (digits[i] - '0')) / 10) {
+            return Status::NOT_STORED;
+        }
+        number = number * 10 + (digits[i] - '0');
+    }
+
+    if (substract) {
+        value = number < delta ? 0 : number - delta;
+    } else {
+        value = number + delta;
+    }
+
+    // Print number backwards, it has at most 20 digits
+    char buffer[20];
+    char *end = buffer + sizeof(buffer), *begin = end;
+    number = value;
+    do {
+        *--begin = '0' + number % 10;
+        number /= 10;
+    } while (number != 0);
+    if (!_set_val_node(id, begin, end - begin)) {
+        return Status::NOT_STORED;
+    }
+    _nodes[id]->cas = ++_cas;
+    _publish(id);
+    _stored(true, cas);
+    return Status::STORED;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool SimpleLRU::Append(const Key &key, const std::string &value, uint64_t *cas) {
+    return _concat_node(key, value, false, cas);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool SimpleLRU::Prepend(const Key &key, const std::string &value, uint64_t *cas) {
+    return _concat_node(key, value, true, cas);
+}
+
+// See MapBasedGlobalLockImpl.h
+Storage::Status SimpleLRU::Incr(const Key &key, uint64_t delta, uint64_t &value, uint64_t *cas) {
+    return _add_node(key, delta, false, value, cas);
 }
 
 // See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Get(const std::string &key, std::string &value) {
-    auto cur_pos = _lru_index.find(key);
-    if (cur_pos == _lru_index.end()) {
+Storage::Status SimpleLRU::Decr(const Key &key, uint64_t delta, uint64_t &value, uint64_t *cas) {
+    return _add_node(key, delta, true, value, cas);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool SimpleLRU::Get(const Key &key, std::string &value, uint32_t *flags, uint64_t *cas, uint32_t *expire) {
+    if (_sketch != nullptr) {
+        _sketch->Increment(key.hash());
+    }
+    std::uint32_t id = _find_node(key);
+    // Expired node could be still there until the next write
+    if (id == NIL || (_nodes[id]->expire != 0 && _nodes[id]->expire <= _clock())) {
+        _misses.fetch_add(1, std::memory_order_relaxed);
         return false;
     }
-    lru_node &cur_node = cur_pos->second.get();
-    value = cur_node.value;
-    return _move_to_head(cur_node);
+    _hits.fetch_add(1, std::memory_order_relaxed);
+    CacheNode *node = _nodes[id];
+    value.assign(node->value(), node->value_size);
+    if (flags != nullptr) {
+        *flags = node->flags;
+    }
+    if (cas != nullptr) {
+        *cas = node->cas;
+    }
+    if (expire != nullptr) {
+        *expire = node->expire;
+    }
+    _owner(id).Hit(id);
+    if (_inline != nullptr && node->key_size + node->value_size <= InlineTable::INLINE_LIMIT) {
+        // Item lost its copy to another key, readers holding the lock shared could store it back
+        _publish(id);
+    }
+    return true;
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::_inline_get(const Key &key, std::string &value, uint32_t *flags, uint64_t *cas,
+                            uint32_t *expire) {
+    if (_inline == nullptr || !_inline->Get(key, _clock(), value, flags, cas, expire)) {
+        return false;
+    }
+    _inline_hits.Get().fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+// See SimpleLRU.h
+void SimpleLRU::_inline_get_batch(std::vector<ReadItem> &items, const std::uint32_t *which, std::size_t count,
+                                  std::vector<std::uint32_t> &rest) {
+    for (std::size_t i = 0; i < count; ++i) {
+        std::uint32_t pos = which == nullptr ? i : which[i];
+        ReadItem &item = items[pos];
+        item.found = _inline_get(item.key, item.value, &item.flags, &item.cas);
+        if (!item.found) {
+            rest.push_back(pos);
+        }
+    }
+}
+
+// See SimpleLRU.h
+void SimpleLRU::GetBatch(std::vector<ReadItem> &items, const std::uint32_t *which, std::size_t count) {
+    for (std::size_t start = 0; start < count; start += PREFETCH_GROUP) {
+        std::size_t size = std::min(PREFETCH_GROUP, count - start);
+        ReadItem *group[PREFETCH_GROUP];
+        for (std::size_t i = 0; i < size; ++i) {
+            group[i] = &items[which == nullptr ? start + i : which[start + i]];
+            _lru_index.Prefetch(group[i]->key.hash());
+        }
+
+        // Each pass touches memory prefetched by the previous one: index groups, node table, nodes
+        std::uint32_t candidates[PREFETCH_GROUP];
+        for (std::size_t i = 0; i < size; ++i) {
+            const std::uint32_t *candidate = _lru_index.Candidate(group[i]->key.hash());
+            candidates[i] = candidate == nullptr ? NIL : *candidate;
+            if (candidates[i] != NIL) {
+                __builtin_prefetch(&_nodes[candidates[i]]);
+            }
+        }
+        for (std::size_t i = 0; i < size; ++i) {
+            if (candidates[i] != NIL) {
+                // Header and key take the first cache line, value usually starts in the next one
+                const char *node = reinterpret_cast<const char *>(_nodes[candidates[i]]);
+                __builtin_prefetch(node);
+                __builtin_prefetch(node + 64);
+            }
+        }
+
+        // Call own implementation, overrides could take locks which are taken for the whole batch already
+        for (std::size_t i = 0; i < size; ++i) {
+            ReadItem &item = *group[i];
+            item.found = SimpleLRU::Get(item.key, item.value, &item.flags, &item.cas);
+        }
+    }
 }
 
-/*
-void SimpleLRU::OutStorage() {
-    std::cout << "FORWARD:" << std::endl;
-    for (lru_node *tmp = _lru_head.get(); tmp != nullptr; tmp = tmp->next.get()) {
-        std::cout << tmp->key << ": " << tmp->value << std::endl;
+// See SimpleLRU.h
+void SimpleLRU::PutBatch(std::vector<WriteItem> &items, const std::uint32_t *which, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        WriteItem &item = items[which == nullptr ? i : which[i]];
+        item.stored = SimpleLRU::Put(item.key, *item.value, item.flags, item.expire);
     }
-    std::cout << "BACKWARD:" << std::endl;
-    for (lru_node *tmp = _lru_tail; tmp != nullptr; tmp = tmp->prev) {
-        std::cout << tmp->key << ": " << tmp->value << std::endl;
+}
+
+// See SimpleLRU.h
+std::size_t SimpleLRU::Reclaim(std::size_t required) {
+    std::size_t before = _cur_size;
+    _expire_nodes(_clock());
+    while (before - _cur_size < required && _evict(0, NIL)) {
     }
+    return before - _cur_size;
+}
+
+// See SimpleLRU.h
+std::size_t SimpleLRU::Shed(std::size_t target, std::size_t limit, std::vector<CacheNode *> &evicted) {
+    _expire_nodes(_clock());
+    std::size_t count = 0;
+    while (_cur_size > target && count < limit) {
+        std::uint32_t victim = _victim(0, NIL);
+        if (victim == NIL) {
+            break;
+        }
+        _unlink_node(victim, true);
+        evicted.push_back(_detach_node(victim));
+        _evictions++;
+        count++;
+    }
+    return count;
+}
+
+// See SimpleLRU.h
+void SimpleLRU::Release(std::vector<CacheNode *> &evicted) {
+    std::size_t freed = 0;
+    for (CacheNode *node : evicted) {
+        freed += node->Footprint();
+        ::operator delete(node);
+    }
+    evicted.clear();
+    _budget->Release(freed);
+}
+
+// See SimpleLRU.h
+void SimpleLRU::GetStats(std::vector<std::pair<std::string, uint64_t>> &stats) const {
+    std::uint64_t hits = _hits.load(std::memory_order_relaxed);
+    _inline_hits.ForEach([&hits](const std::atomic<std::uint64_t> &cpu) { hits += cpu.load(std::memory_order_relaxed); });
+    stats.emplace_back("get_hits", hits);
+    stats.emplace_back("get_misses", _misses.load(std::memory_order_relaxed));
+    stats.emplace_back("curr_items", _lru_index.size());
+    stats.emplace_back("bytes", _cur_size.load(std::memory_order_relaxed));
+    stats.emplace_back("limit_maxbytes", _max_size);
+    stats.emplace_back("evictions", _evictions);
+    stats.emplace_back("admission_rejections", _rejections);
+    stats.emplace_back("expirations", _expirations);
 }
-*/
 
 
 } // namespace Backend
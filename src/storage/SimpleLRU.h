@@ -1,92 +1,306 @@
 #ifndef AFINA_STORAGE_SIMPLE_LRU_H
 #define AFINA_STORAGE_SIMPLE_LRU_H
 
-#include <map>
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <functional>
 #include <memory>
-#include <mutex>
 #include <string>
+#include <vector>
 
 #include <afina/Storage.h>
+#include <afina/concurrency/CoreLocal.h>
+
+#include "CacheNode.h"
+#include "EvictionPolicy.h"
+#include "FrequencySketch.h"
+#include "HashIndex.h"
+#include "InlineTable.h"
+#include "MemoryBudget.h"
+#include "TimerWheel.h"
 
 
 namespace Afina {
 namespace Backend {
 
 /**
- * # Map based implementation
+ * # Hash index based implementation
  * That is NOT thread safe implementaiton!!
  */
 class SimpleLRU : public Afina::Storage {
+public:
+    /**
+     * Which element goes away once there is no space left, see EvictionPolicy::Kind
+     */
+    using Policy = EvictionPolicy::Kind;
+
 private:
-    // LRU cache node
-    using lru_node = struct lru_node {
-        const std::string key;
-        std::string value;
-        lru_node *prev;
-        std::unique_ptr<lru_node> next;
-        /*~lru_node() {
-            std::cout << "DESTRUCT  " << key << std::endl;
-        }*/
+    // Node id meaning "no node", used as null link
+    static constexpr std::uint32_t NIL = CacheNode::NIL;
+
+    // Number of GetBatch lookups whose memory accesses are interleaved
+    static constexpr std::size_t PREFETCH_GROUP = 16;
+
+    struct node_hash {
+        const std::vector<CacheNode *> *nodes;
+        std::uint64_t operator()(std::uint32_t id) const { return (*nodes)[id]->hash; }
     };
 
-    // Maximum number of bytes could be stored in this cache.
-    // i.e all (keys+values) must be less the _max_size
+    // Number of bytes this cache is expected to hold, policies are sized by it. Actual limit is the
+    // memory budget: cache could hold more while budget is shared and other caches don't use it
     std::size_t _max_size;
-    // Current cache load.
-    std::size_t _cur_size;
+    // Current cache load, i.e sum of all items footprints (see ItemFootprint). Could be read without lock
+    std::atomic<std::size_t> _cur_size;
+
+    // Memory limit cache takes bytes from before allocation, could be shared by several caches
+    std::shared_ptr<MemoryBudget> _budget;
+
+    // All nodes by id, free ids are nullptr. Owns all nodes
+    std::vector<CacheNode *> _nodes;
+    std::vector<std::uint32_t> _free_ids;
+
+    // Orders nodes for eviction
+    std::unique_ptr<EvictionPolicy> _main;
 
-    // Main storage of lru_nodes, elements in this list ordered descending by "freshness": in the head
-    // element that wasn't used for longest time.
-    //
-    // List owns all nodes
-    std::unique_ptr<lru_node> _lru_head;
-    lru_node *_lru_tail;
+    // Expiration timers of the nodes with expire time. Every write moves wheel to the current time and
+    // reclaims expired nodes, Get just doesn't see expired nodes which are still there
+    TimerWheel _timers;
+    std::vector<std::uint32_t> _expired;
 
-    // Index of nodes from list above, allows fast random access to elements by lru_node#key
-    std::map<std::reference_wrapper<const std::string>, 
-             std::reference_wrapper<lru_node>,
-             std::less<const std::string>> _lru_index;
+    // W-TinyLFU admission: new elements get into small CLOCK window first. Once window is about to
+    // overflow, window victim competes with main victim, the one with higher estimated access frequency
+    // stays in the main policy. So scans of the one-time keys pass through window without flushing main
+    // policy. Sketch and window are nullptr if admission is disabled
+    std::unique_ptr<FrequencySketch> _sketch;
+    std::unique_ptr<EvictionPolicy> _window;
+    std::size_t _window_limit;
+
+    // Index of all nodes, allows fast random access to elements by CacheNode#key
+    HashIndex<std::uint32_t, node_hash> _lru_index;
+
+    // Copies of the small items readers could take without lock, nullptr if disabled. Table memory is
+    // taken from the budget once for the cache lifetime
+    std::unique_ptr<InlineTable> _inline;
+    std::size_t _inline_size;
+    // Hits served by the table, counted per CPU as table readers don't share any other cache line
+    Concurrency::CoreLocal<std::atomic<std::uint64_t>> _inline_hits;
+
+    // Statistics, hits and misses could be changed by concurrent readers
+    std::atomic<std::uint64_t> _hits;
+    std::atomic<std::uint64_t> _misses;
+    std::uint64_t _evictions;
+    std::uint64_t _rejections;
+    std::uint64_t _expirations;
+
+    // Last version given to the modified node
+    std::uint64_t _cas;
 
 public:
-    SimpleLRU(size_t max_size = 1024) : _max_size(max_size), _cur_size(0), 
-                                        _lru_head(nullptr), _lru_tail(nullptr) {}
+    /**
+     * @param max_size memory limit in bytes, or share of the budget this cache is expected to hold
+     * @param policy eviction policy
+     * @param admission enables W-TinyLFU admission filter
+     * @param budget memory budget shared with other caches, nullptr means own budget of max_size bytes
+     * @param inline_values keeps seqlock protected copies of the small items, see InlineTable. Takes
+     * up to 1/8 of max_size
+     */
+    SimpleLRU(size_t max_size = 1024, Policy policy = Policy::LRU, bool admission = false,
+              std::shared_ptr<MemoryBudget> budget = nullptr, bool inline_values = false);
 
-    ~SimpleLRU() {
-        _lru_index.clear();
-        while (_lru_head.get() != nullptr) {
-            _lru_head = std::move(_lru_head->next); // TODO: Here is stack overflow
-        }
-    }
+    ~SimpleLRU();
+
+    /**
+     * Number of bytes the item takes from the cache memory limit: node allocation including allocator
+     * overhead, plus the item slots in the node table and in the index
+     */
+    static std::size_t ItemFootprint(std::size_t key_size, std::size_t value_size);
 
     // Implements Afina::Storage interface
-    bool Put(const std::string &key, const std::string &value) override;
+    bool Put(const Key &key, const std::string &value, uint32_t flags = 0, uint32_t expire = 0,
+             uint64_t *cas = nullptr) override;
 
     // Implements Afina::Storage interface
-    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+    bool PutIfAbsent(const Key &key, const std::string &value, uint32_t flags = 0,
+                     uint32_t expire = 0, uint64_t *cas = nullptr) override;
 
     // Implements Afina::Storage interface
-    bool Set(const std::string &key, const std::string &value) override;
+    bool Set(const Key &key, const std::string &value, uint32_t flags = 0, uint32_t expire = 0,
+             uint64_t *cas = nullptr) override;
 
     // Implements Afina::Storage interface
-    bool Delete(const std::string &key) override;
+    bool Delete(const Key &key) override;
 
     // Implements Afina::Storage interface
-    bool Get(const std::string &key, std::string &value) override;
-  
+    bool Append(const Key &key, const std::string &value, uint64_t *cas = nullptr) override;
+
+    // Implements Afina::Storage interface
+    bool Prepend(const Key &key, const std::string &value, uint64_t *cas = nullptr) override;
+
+    // Implements Afina::Storage interface
+    Status Incr(const Key &key, uint64_t delta, uint64_t &value, uint64_t *cas = nullptr) override;
+
+    // Implements Afina::Storage interface
+    Status Decr(const Key &key, uint64_t delta, uint64_t &value, uint64_t *cas = nullptr) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const Key &key, std::string &value, uint32_t *flags = nullptr, uint64_t *cas = nullptr,
+             uint32_t *expire = nullptr) override;
+
+    // Implements Afina::Storage interface
+    Status CompareAndSet(const Key &key, const std::string &value, uint32_t flags, uint32_t expire,
+                         uint64_t cas, uint64_t *new_cas = nullptr) override;
+
+    // Implements Afina::Storage interface
+    void GetMany(std::vector<ReadItem> &items) override { GetBatch(items, nullptr, items.size()); }
+
+    // Implements Afina::Storage interface
+    void PutMany(std::vector<WriteItem> &items) override { PutBatch(items, nullptr, items.size()); }
+
+    /**
+     * GetMany over the selected items. Lookups go in groups of PREFETCH_GROUP: index groups of all keys of
+     * the group are prefetched first, then the candidate nodes, and only then keys are resolved. So cache
+     * misses of the group overlap instead of being paid one after another
+     *
+     * @param items keys to look up and output parameters for the results
+     * @param which indexes of the items to process, nullptr means the first count items
+     * @param count number of items to process
+     */
+    virtual void GetBatch(std::vector<ReadItem> &items, const std::uint32_t *which, std::size_t count);
+
+    /**
+     * PutMany over the selected items, see GetBatch
+     */
+    virtual void PutBatch(std::vector<WriteItem> &items, const std::uint32_t *which, std::size_t count);
+
+    // Implements Afina::Storage interface
+    void GetStats(std::vector<std::pair<std::string, uint64_t>> &stats) const override;
+
+    /**
+     * Number of bytes cache holds now, see ItemFootprint
+     */
+    std::size_t Used() const { return _cur_size.load(std::memory_order_relaxed); }
+
+    /**
+     * Frees memory for the other caches sharing the budget: drops expired nodes and evicts others until
+     * at least required bytes are freed or cache is empty
+     *
+     * @return number of bytes freed
+     */
+    std::size_t Reclaim(std::size_t required);
+
+    /**
+     * Evicts nodes until cache holds at most target bytes, but no more than limit nodes at once. Evicted
+     * nodes are detached from the cache, their memory is still taken from the budget until Release
+     *
+     * @param target number of bytes cache should hold
+     * @param limit max number of nodes to evict
+     * @param evicted output parameter nodes are appended to
+     * @return number of nodes evicted
+     */
+    virtual std::size_t Shed(std::size_t target, std::size_t limit, std::vector<CacheNode *> &evicted);
+
+    /**
+     * Frees nodes evicted by Shed and gives their memory back to the budget. Doesn't touch the cache,
+     * so it is safe to call without any lock
+     */
+    void Release(std::vector<CacheNode *> &evicted);
+
+    /**
+     * True if Get doesn't modify cache structure except atomic marks, so concurrent Get calls
+     * are safe as long as there are no concurrent writers
+     */
+    bool ConcurrentGet() const { return _main->ConcurrentHit() && (_window == nullptr || _window->ConcurrentHit()); }
+
+    /**
+     * True if cache keeps copies of the small items which Get could take without lock
+     */
+    bool InlineValues() const { return _inline != nullptr; }
+
+protected:
+    // Current unix time in seconds
+    virtual std::uint32_t _clock() const { return std::time(nullptr); }
+
+    // Get served by the inline table, safe to call without any lock. False means item should be looked
+    // up in the cache
+    bool _inline_get(const Key &key, std::string &value, uint32_t *flags, uint64_t *cas,
+                     uint32_t *expire = nullptr);
+
+    // Serves items of the batch found in the inline table, indexes of the others are put into rest
+    void _inline_get_batch(std::vector<ReadItem> &items, const std::uint32_t *which, std::size_t count,
+                           std::vector<std::uint32_t> &rest);
+
 private:
-    //void OutStorage();
+    // Lookup node id by key, returns NIL if there is no such key
+    std::uint32_t _find_node(const Key &key) const;
+
+    // Allocates node with the given content, doesn't link it anywhere
+    std::uint32_t _alloc_node(const Key &key, const std::string &value);
+
+    // Removes node from the node table without freeing its memory
+    CacheNode *_detach_node(std::uint32_t id);
+
+    // Returns node memory back, node must be released by its policy
+    void _free_node(std::uint32_t id);
+
+    // Removes node from the index, policy and timers
+    void _unlink_node(std::uint32_t id, bool evicted);
+
+    // Stores node copy into inline table if it is enabled, must be called on every node modification.
+    // Node of the Get hit could be stored under the shared lock too, see InlineTable::Store
+    void _publish(std::uint32_t id);
+
+    // Policy node belongs to
+    EvictionPolicy &_owner(std::uint32_t id) { return _nodes[id]->window ? *_window : *_main; }
+
+    // Takes required number of bytes from the budget, evicts nodes if there is not enough. Never
+    // evicts pinned node
+    bool _free_space(std::size_t required, std::uint32_t pinned);
+
+    bool _put_new_node(const Key &key, const std::string &value, std::uint32_t flags, std::uint32_t expire);
+
+    bool _set_val_node(std::uint32_t id, const char *data, std::size_t size);
+
+    // Moves node into a new allocation with the given value capacity, the first keep bytes of the value
+    // are copied. Returns false if there is no memory for the new node
+    bool _realloc_node(std::uint32_t id, std::size_t capacity, std::size_t keep);
+
+    // Adds data to the end or to the beginning of the existing node value in place, if capacity allows
+    bool _concat_node(const Key &key, const std::string &data, bool front, std::uint64_t *cas);
+
+    // Passes result of the store through, reporting version of the stored item if caller asked for it:
+    // the item stored last has the latest version
+    bool _stored(bool stored, std::uint64_t *cas) const {
+        if (stored && cas != nullptr) {
+            *cas = _cas;
+        }
+        return stored;
+    }
+
+    // Adds or substracts delta from the decimal number in the existing node value
+    Status _add_node(const Key &key, std::uint64_t delta, bool substract, std::uint64_t &value, std::uint64_t *cas);
+
+    void _erase_node(std::uint32_t id, bool evicted);
 
-    bool _move_to_head(lru_node &node);
+    void _set_expire(std::uint32_t id, std::uint32_t expire);
 
-    bool _free_space(std::size_t required);
+    // Replaces value and metadata of the existing node, gives it a new version
+    bool _update_node(std::uint32_t id, const std::string &value, std::uint32_t flags, std::uint32_t expire);
 
-    bool _put_new_node(const std::string &key, const std::string &value);
+    // Moves timers to the given time and erases expired nodes
+    void _expire_nodes(std::uint32_t now);
 
-    bool _set_val_node(lru_node &node, const std::string &new_value);
+    // Victim of the given policy. Reads served by inline table don't reach policy, so they are applied
+    // to the candidate as a hit before it is chosen
+    std::uint32_t _policy_victim(EvictionPolicy &policy, std::uint32_t pinned);
 
-    bool _erase_storage_node(lru_node &node);
+    // Chooses node to evict other than pinned, returns NIL if there is nothing to evict. Window victim
+    // could be moved to the main policy instead, see _window
+    std::uint32_t _victim(std::size_t required, std::uint32_t pinned);
 
-    bool _pop_lru_node();
+    // Evicts one node other than pinned to free some of required bytes, returns false if there is
+    // nothing to evict
+    bool _evict(std::size_t required, std::uint32_t pinned);
 };
 
 } // namespace Backend
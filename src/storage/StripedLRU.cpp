@@ -1,42 +1,223 @@
 #include "StripedLRU.h"
+#include <algorithm>
 #include <stdexcept>
+#include <utility>
 
 
 
 namespace Afina {
 namespace Backend {
 std::unique_ptr<StripedLRU>
-StripedLRU::BuildStripedLRU(std::size_t memory_limit, std::size_t stripe_count) {
-    std::size_t stripe_size = memory_limit / stripe_count;
-    if (stripe_size < MIN_STRIPE_SIZE) {
-        throw std::runtime_error("Too low stripe size");
+StripedLRU::BuildStripedLRU(std::size_t memory_limit, std::size_t stripe_count, SimpleLRU::Policy policy,
+                            bool admission, bool combining, bool inline_values) {
+    if (memory_limit < MIN_MEMORY_LIMIT) {
+        throw std::runtime_error("Too low memory limit");
     }
-    return std::unique_ptr<StripedLRU>(new StripedLRU(stripe_size, stripe_count));
+    if (stripe_count == 0 || stripe_count > memory_limit / SimpleLRU::ItemFootprint(0, 0)) {
+        throw std::runtime_error("Invalid stripe count");
+    }
+    return std::unique_ptr<StripedLRU>(new StripedLRU(memory_limit, stripe_count, policy, admission, combining,
+                                                                inline_values));
+}
+
+constexpr std::chrono::milliseconds StripedLRU::MAINTAIN_PERIOD;
+
+// Implements Afina::Storage interface
+void StripedLRU::Start() {
+    std::lock_guard<Concurrency::Mutex> lock(_maintainer_mutex);
+    if (_running) {
+        return;
+    }
+    _running = true;
+    _maintainer = std::thread(&StripedLRU::_maintain, this);
+}
+
+// Implements Afina::Storage interface
+void StripedLRU::Stop() {
+    std::lock_guard<Concurrency::Mutex> lock(_maintainer_mutex);
+    _running = false;
+    _pressure.Set();
+    if (_maintainer.joinable()) {
+        _maintainer.join();
+    }
+}
+
+void StripedLRU::_maintain() {
+    const std::size_t high = _budget->Limit() / 100 * HIGH_WATERMARK;
+    const std::size_t low = _budget->Limit() / 100 * LOW_WATERMARK;
+    std::vector<CacheNode *> evicted;
+
+    // Set if stripes had nothing to evict, then maintainer waits for the next period even above watermark
+    bool stalled = false;
+    while (_running) {
+        if (stalled || _budget->Used() <= high) {
+            _pressure.WaitFor(MAINTAIN_PERIOD);
+        }
+        _pressure.Reset();
+        if (!_running) {
+            break;
+        }
+        stalled = false;
+
+        // Stripe holding the most memory pays, batch by batch so writers of the stripe don't wait long
+        for (std::size_t used = _budget->Used(); used > low; used = _budget->Used()) {
+            ThreadSafeSimplLRU *largest = _stripes[0].get();
+            for (auto &stripe : _stripes) {
+                if (stripe->Used() > largest->Used()) {
+                    largest = stripe.get();
+                }
+            }
+            std::size_t excess = used - low;
+            std::size_t target = largest->Used() > excess ? largest->Used() - excess : 0;
+            if (largest->Shed(target, EVICT_BATCH, evicted) == 0) {
+                stalled = true;
+                break;
+            }
+            largest->Release(evicted);
+        }
+    }
+}
+
+bool StripedLRU::_reclaim(const void *requester, std::size_t required) {
+    // Requester holds its own lock, so stripes are only locked if they are free right now: waiting could
+    // deadlock with the stripe reclaiming memory from the requester
+    // Sizes change under the other writers, so they are sorted as seen once: comparing live values could
+    // make the order inconsistent, which std::sort doesn't survive
+    std::vector<std::pair<std::size_t, ThreadSafeSimplLRU *>> by_size;
+    by_size.reserve(_stripes_cnt);
+    for (auto &stripe : _stripes) {
+        if (stripe.get() != requester) {
+            by_size.emplace_back(stripe->Used(), stripe.get());
+        }
+    }
+    std::sort(by_size.begin(), by_size.end(),
+              [](const std::pair<std::size_t, ThreadSafeSimplLRU *> &a,
+                 const std::pair<std::size_t, ThreadSafeSimplLRU *> &b) { return a.first > b.first; });
+
+    std::size_t freed = 0;
+    for (auto &stripe : by_size) {
+        if (freed >= required) {
+            break;
+        }
+        freed += stripe.second->TryReclaim(required - freed);
+    }
+    return freed != 0;
+}
+
+// Implements Afina::Storage interface
+bool StripedLRU::Put(const Key &key, const std::string &value, uint32_t flags, uint32_t expire, uint64_t *cas) {
+    return _stripes[key.hash() % _stripes_cnt]->Put(key, value, flags, expire, cas);
+}
+
+// Implements Afina::Storage interface
+bool StripedLRU::PutIfAbsent(const Key &key, const std::string &value, uint32_t flags, uint32_t expire,
+                             uint64_t *cas) {
+    return _stripes[key.hash() % _stripes_cnt]->PutIfAbsent(key, value, flags, expire, cas);
 }
 
 // Implements Afina::Storage interface
-bool StripedLRU::Put(const std::string &key, const std::string &value) {
-    return _stripes[_hash_stripes(key) % _stripes_cnt]->Put(key, value);
+bool StripedLRU::Set(const Key &key, const std::string &value, uint32_t flags, uint32_t expire, uint64_t *cas) {
+    return _stripes[key.hash() % _stripes_cnt]->Set(key, value, flags, expire, cas);
 }
 
 // Implements Afina::Storage interface
-bool StripedLRU::PutIfAbsent(const std::string &key, const std::string &value) {
-    return _stripes[_hash_stripes(key) % _stripes_cnt]->PutIfAbsent(key, value);
+bool StripedLRU::Delete(const Key &key) {
+   return _stripes[key.hash() % _stripes_cnt]->Delete(key);
 }
 
 // Implements Afina::Storage interface
-bool StripedLRU::Set(const std::string &key, const std::string &value) {
-    return _stripes[_hash_stripes(key) % _stripes_cnt]->Set(key, value);
+bool StripedLRU::Get(const Key &key, std::string &value, uint32_t *flags, uint64_t *cas, uint32_t *expire) {
+   return _stripes[key.hash() % _stripes_cnt]->Get(key, value, flags, cas, expire);
+}
+
+// Implements Afina::Storage interface, check and update happen under the lock of the key stripe
+Storage::Status StripedLRU::CompareAndSet(const Key &key, const std::string &value, uint32_t flags,
+                                          uint32_t expire, uint64_t cas, uint64_t *new_cas) {
+    return _stripes[key.hash() % _stripes_cnt]->CompareAndSet(key, value, flags, expire, cas, new_cas);
+}
+
+// Implements Afina::Storage interface
+bool StripedLRU::Append(const Key &key, const std::string &value, uint64_t *cas) {
+    return _stripes[key.hash() % _stripes_cnt]->Append(key, value, cas);
+}
+
+// Implements Afina::Storage interface
+bool StripedLRU::Prepend(const Key &key, const std::string &value, uint64_t *cas) {
+    return _stripes[key.hash() % _stripes_cnt]->Prepend(key, value, cas);
+}
+
+// Implements Afina::Storage interface
+Storage::Status StripedLRU::Incr(const Key &key, uint64_t delta, uint64_t &value, uint64_t *cas) {
+    return _stripes[key.hash() % _stripes_cnt]->Incr(key, delta, value, cas);
+}
+
+// Implements Afina::Storage interface
+Storage::Status StripedLRU::Decr(const Key &key, uint64_t delta, uint64_t &value, uint64_t *cas) {
+    return _stripes[key.hash() % _stripes_cnt]->Decr(key, delta, value, cas);
+}
+
+template <typename Item>
+void StripedLRU::_group(const std::vector<Item> &items, std::vector<uint32_t> &order,
+                        std::vector<std::size_t> &start) const {
+    // Counting sort by stripe number
+    std::vector<uint32_t> stripe(items.size());
+    start.assign(_stripes_cnt + 1, 0);
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        stripe[i] = items[i].key.hash() % _stripes_cnt;
+        start[stripe[i] + 1]++;
+    }
+    for (std::size_t s = 0; s < _stripes_cnt; ++s) {
+        start[s + 1] += start[s];
+    }
+    order.resize(items.size());
+    std::vector<std::size_t> pos(start.begin(), start.end() - 1);
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        order[pos[stripe[i]]++] = i;
+    }
 }
 
 // Implements Afina::Storage interface
-bool StripedLRU::Delete(const std::string &key) {
-   return _stripes[_hash_stripes(key) % _stripes_cnt]->Delete(key);
+void StripedLRU::GetMany(std::vector<ReadItem> &items) {
+    std::vector<uint32_t> order;
+    std::vector<std::size_t> start;
+    _group(items, order, start);
+    for (std::size_t s = 0; s < _stripes_cnt; ++s) {
+        if (start[s] != start[s + 1]) {
+            _stripes[s]->GetBatch(items, &order[start[s]], start[s + 1] - start[s]);
+        }
+    }
 }
 
 // Implements Afina::Storage interface
-bool StripedLRU::Get(const std::string &key, std::string &value) {
-   return _stripes[_hash_stripes(key) % _stripes_cnt]->Get(key, value);
+void StripedLRU::PutMany(std::vector<WriteItem> &items) {
+    // Items of the same key stay in the original order, so the last one wins
+    std::vector<uint32_t> order;
+    std::vector<std::size_t> start;
+    _group(items, order, start);
+    for (std::size_t s = 0; s < _stripes_cnt; ++s) {
+        if (start[s] != start[s + 1]) {
+            _stripes[s]->PutBatch(items, &order[start[s]], start[s + 1] - start[s]);
+        }
+    }
+}
+
+// Implements Afina::Storage interface
+void StripedLRU::GetStats(std::vector<std::pair<std::string, uint64_t>> &stats) const {
+    std::size_t first = stats.size();
+    _stripes[0]->GetStats(stats);
+    std::vector<std::pair<std::string, uint64_t>> stripe_stats;
+    for (std::size_t i = 1; i < _stripes_cnt; ++i) {
+        stripe_stats.clear();
+        _stripes[i]->GetStats(stripe_stats);
+        for (std::size_t j = 0; j < stripe_stats.size(); ++j) {
+            stats[first + j].second += stripe_stats[j].second;
+        }
+    }
+    for (std::size_t j = first; j < stats.size(); ++j) {
+        if (stats[j].first == "limit_maxbytes") {
+            stats[j].second = _budget->Limit();
+        }
+    }
 }
     
 } // namespace Backend
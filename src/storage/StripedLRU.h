@@ -1,55 +1,153 @@
 #ifndef AFINA_STORAGE_STRIPED_LRU_H
 #define AFINA_STORAGE_STRIPED_LRU_H
 
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <mutex>
 #include <functional>
+#include <thread>
 #include <string>
 #include <vector>
 
 #include <afina/Storage.h>
+#include <afina/concurrency/Event.h>
+#include <afina/concurrency/Mutex.h>
+
+#include "CombiningSimpleLRU.h"
 #include "ThreadSafeSimpleLRU.h"
 
 
 namespace Afina {
 namespace Backend {
 
-constexpr std::size_t MIN_STRIPE_SIZE = 1024 * 1024UL;
+constexpr std::size_t MIN_MEMORY_LIMIT = 1024 * 1024UL;
 
+/**
+ * # Cache split into independently locked stripes
+ * Stripes share one memory budget, so skewed key distribution doesn't leave memory unused: stripe could
+ * take more than memory_limit / stripe_count while others don't need it. Stripe which holds less than
+ * that share and can't get memory makes the largest stripes evict.
+ *
+ * Once started, background maintainer keeps free headroom in the budget: when usage gets above the high
+ * watermark it evicts batches of nodes from the largest stripes until usage is below the low watermark.
+ * Evicted nodes are freed outside of the stripe lock, so foreground writers almost never evict.
+ *
+ * With combining enabled stripes are CombiningSimpleLRU: operations of threads contending for the stripe
+ * are run by one combiner thread in a batch instead of passing the lock around. With inline values
+ * stripes keep copies of the small items readers take without locking, see InlineTable
+ */
 class StripedLRU : public Afina::Storage {
 private:
-    StripedLRU(std::size_t stripe_size, std::size_t n_stripes) : _stripes_cnt{n_stripes} {
+    StripedLRU(std::size_t memory_limit, std::size_t n_stripes, SimpleLRU::Policy policy, bool admission,
+               bool combining, bool inline_values)
+        : _budget(new MemoryBudget(memory_limit)), _stripes_cnt{n_stripes}, _running(false) {
+        _budget->SetReclaimer(
+            [this](const void *requester, std::size_t required) { return _reclaim(requester, required); });
+        _budget->SetWatermark(memory_limit / 100 * HIGH_WATERMARK, [this]() { _pressure.Set(); });
         _stripes.reserve(n_stripes);
         for (std::size_t i = 0; i < n_stripes; ++i) {
-            _stripes.emplace_back(new ThreadSafeSimplLRU(stripe_size));
+            if (combining) {
+                _stripes.emplace_back(new CombiningSimpleLRU(memory_limit / n_stripes, policy, admission, _budget,
+                                                            inline_values));
+            } else {
+                _stripes.emplace_back(new ThreadSafeSimplLRU(memory_limit / n_stripes, policy, admission, _budget,
+                                                            inline_values));
+            }
         }
     }
 
 public:
     static std::unique_ptr<StripedLRU> 
     BuildStripedLRU(std::size_t memory_limit = 16 * 1024 * 1024UL, 
-                    std::size_t stripe_count = 4);
+                    std::size_t stripe_count = 4,
+                    SimpleLRU::Policy policy = SimpleLRU::Policy::LRU,
+                    bool admission = false,
+                    bool combining = false,
+                    bool inline_values = false);
+
+    ~StripedLRU() { Stop(); }
+
+    // Implements Afina::Storage interface, starts background maintainer
+    void Start() override;
+
+    // Implements Afina::Storage interface, stops background maintainer
+    void Stop() override;
+
+    // Implements Afina::Storage interface
+    bool Put(const Key &key, const std::string &value, uint32_t flags = 0, uint32_t expire = 0,
+             uint64_t *cas = nullptr) override;
 
-    ~StripedLRU() {}
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const Key &key, const std::string &value, uint32_t flags = 0,
+                     uint32_t expire = 0, uint64_t *cas = nullptr) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const Key &key, const std::string &value, uint32_t flags = 0, uint32_t expire = 0,
+             uint64_t *cas = nullptr) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const Key &key) override;
 
     // Implements Afina::Storage interface
-    bool Put(const std::string &key, const std::string &value) override;
+    bool Get(const Key &key, std::string &value, uint32_t *flags = nullptr, uint64_t *cas = nullptr,
+             uint32_t *expire = nullptr) override;
 
     // Implements Afina::Storage interface
-    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+    Status CompareAndSet(const Key &key, const std::string &value, uint32_t flags, uint32_t expire,
+                         uint64_t cas, uint64_t *new_cas = nullptr) override;
 
     // Implements Afina::Storage interface
-    bool Set(const std::string &key, const std::string &value) override;
+    bool Append(const Key &key, const std::string &value, uint64_t *cas = nullptr) override;
 
     // Implements Afina::Storage interface
-    bool Delete(const std::string &key) override;
+    bool Prepend(const Key &key, const std::string &value, uint64_t *cas = nullptr) override;
 
     // Implements Afina::Storage interface
-    bool Get(const std::string &key, std::string &value) override;
+    Status Incr(const Key &key, uint64_t delta, uint64_t &value, uint64_t *cas = nullptr) override;
+
+    // Implements Afina::Storage interface
+    Status Decr(const Key &key, uint64_t delta, uint64_t &value, uint64_t *cas = nullptr) override;
+
+    // Implements Afina::Storage interface, every touched stripe is locked once
+    void GetMany(std::vector<ReadItem> &items) override;
+
+    // Implements Afina::Storage interface, every touched stripe is locked once
+    void PutMany(std::vector<WriteItem> &items) override;
+
+    // Implements Afina::Storage interface, sums up statistics of all stripes
+    void GetStats(std::vector<std::pair<std::string, uint64_t>> &stats) const override;
     
 private:
+    // Groups item indexes by stripe: indexes of the stripe i items are order[start[i]..start[i + 1])
+    template <typename Item>
+    void _group(const std::vector<Item> &items, std::vector<uint32_t> &order, std::vector<std::size_t> &start) const;
+
+    // Percents of the memory limit maintainer keeps usage between
+    static constexpr std::size_t HIGH_WATERMARK = 95;
+    static constexpr std::size_t LOW_WATERMARK = 90;
+    // Max number of nodes evicted under one lock acquisition
+    static constexpr std::size_t EVICT_BATCH = 64;
+    // Period maintainer checks usage even if nobody woke it up
+    static constexpr std::chrono::milliseconds MAINTAIN_PERIOD{100};
+
+    // Body of the background maintainer thread
+    void _maintain();
+
+    // Reclaimer of the budget: largest stripes other than requester evict, see MemoryBudget
+    bool _reclaim(const void *requester, std::size_t required);
+
+    std::shared_ptr<MemoryBudget> _budget;
     std::vector<std::unique_ptr<ThreadSafeSimplLRU>> _stripes;
-    std::hash<std::string> _hash_stripes;
     std::size_t _stripes_cnt;
+
+    std::thread _maintainer;
+    // Serializes Start and Stop
+    Concurrency::Mutex _maintainer_mutex;
+    // Set once budget usage crosses the high watermark, and on stop. Writer crossing the watermark doesn't
+    // take any lock and only makes syscall if the maintainer sleeps
+    Concurrency::Event _pressure;
+    std::atomic<bool> _running;
 };
 
 } // namespace Backend
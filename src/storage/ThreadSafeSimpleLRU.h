@@ -2,11 +2,11 @@
 #define AFINA_STORAGE_THREAD_SAFE_SIMPLE_LRU_H
 
 #include <cstdlib>
-#include <iterator>
-#include <map>
 #include <mutex>
 #include <string>
 
+#include <afina/concurrency/SharedMutex.h>
+
 #include "SimpleLRU.h"
 
 namespace Afina {
@@ -14,46 +14,141 @@ namespace Backend {
 
 /**
  * # SimpleLRU thread safe version
- *
- *
+ * Writers take the lock exclusively. Readers share it if the eviction policy allows concurrent Get,
+ * see SimpleLRU::ConcurrentGet. With inline values readers take small items from the seqlock protected
+ * table without any lock, see InlineTable
  */
 class ThreadSafeSimplLRU : public SimpleLRU {
 public:
-    ThreadSafeSimplLRU(size_t max_size = 1024) : SimpleLRU(max_size) {}
+    ThreadSafeSimplLRU(size_t max_size = 1024, Policy policy = Policy::LRU, bool admission = false,
+                       std::shared_ptr<MemoryBudget> budget = nullptr, bool inline_values = false)
+        : SimpleLRU(max_size, policy, admission, std::move(budget), inline_values) {}
     ~ThreadSafeSimplLRU() {}
 
+    /**
+     * SimpleLRU::Reclaim if the lock is free right now, otherwise does nothing and returns 0. Caller
+     * could hold the lock of another cache this way without risk of deadlock
+     */
+    virtual std::size_t TryReclaim(std::size_t required) {
+        std::unique_lock<Concurrency::SharedMutex> lock(thread_safe, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            return 0;
+        }
+        return SimpleLRU::Reclaim(required);
+    }
+
     // see SimpleLRU.h
-    bool Put(const std::string &key, const std::string &value) override {
-        std::lock_guard<std::mutex> lock(thread_safe);
-        return SimpleLRU::Put(key, value);
+    bool Put(const Key &key, const std::string &value, uint32_t flags = 0, uint32_t expire = 0,
+             uint64_t *cas = nullptr) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(thread_safe);
+        return SimpleLRU::Put(key, value, flags, expire, cas);
     }
 
     // see SimpleLRU.h
-    bool PutIfAbsent(const std::string &key, const std::string &value) override {
-        std::lock_guard<std::mutex> lock(thread_safe);
-        return SimpleLRU::PutIfAbsent(key, value);
+    bool PutIfAbsent(const Key &key, const std::string &value, uint32_t flags = 0,
+                     uint32_t expire = 0, uint64_t *cas = nullptr) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(thread_safe);
+        return SimpleLRU::PutIfAbsent(key, value, flags, expire, cas);
     }
 
     // see SimpleLRU.h
-    bool Set(const std::string &key, const std::string &value) override {
-        std::lock_guard<std::mutex> lock(thread_safe);
-        return SimpleLRU::Set(key, value);
+    bool Set(const Key &key, const std::string &value, uint32_t flags = 0, uint32_t expire = 0,
+             uint64_t *cas = nullptr) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(thread_safe);
+        return SimpleLRU::Set(key, value, flags, expire, cas);
     }
 
     // see SimpleLRU.h
-    bool Delete(const std::string &key) override {
-        std::lock_guard<std::mutex> lock(thread_safe);
+    bool Delete(const Key &key) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(thread_safe);
         return SimpleLRU::Delete(key);
     }
 
     // see SimpleLRU.h
-    bool Get(const std::string &key, std::string &value) override {
-        std::lock_guard<std::mutex> lock(thread_safe);
-        return SimpleLRU::Get(key, value);
+    bool Get(const Key &key, std::string &value, uint32_t *flags = nullptr, uint64_t *cas = nullptr,
+             uint32_t *expire = nullptr) override {
+        if (_inline_get(key, value, flags, cas, expire)) {
+            return true;
+        }
+        if (ConcurrentGet()) {
+            Concurrency::SharedLockGuard<Concurrency::SharedMutex> lock(thread_safe);
+            return SimpleLRU::Get(key, value, flags, cas, expire);
+        }
+        std::lock_guard<Concurrency::SharedMutex> lock(thread_safe);
+        return SimpleLRU::Get(key, value, flags, cas, expire);
+    }
+
+    // see SimpleLRU.h
+    Status CompareAndSet(const Key &key, const std::string &value, uint32_t flags, uint32_t expire,
+                         uint64_t cas, uint64_t *new_cas = nullptr) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(thread_safe);
+        return SimpleLRU::CompareAndSet(key, value, flags, expire, cas, new_cas);
+    }
+
+    // see SimpleLRU.h
+    bool Append(const Key &key, const std::string &value, uint64_t *cas = nullptr) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(thread_safe);
+        return SimpleLRU::Append(key, value, cas);
+    }
+
+    // see SimpleLRU.h
+    bool Prepend(const Key &key, const std::string &value, uint64_t *cas = nullptr) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(thread_safe);
+        return SimpleLRU::Prepend(key, value, cas);
+    }
+
+    // see SimpleLRU.h
+    Status Incr(const Key &key, uint64_t delta, uint64_t &value, uint64_t *cas = nullptr) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(thread_safe);
+        return SimpleLRU::Incr(key, delta, value, cas);
+    }
+
+    // see SimpleLRU.h
+    Status Decr(const Key &key, uint64_t delta, uint64_t &value, uint64_t *cas = nullptr) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(thread_safe);
+        return SimpleLRU::Decr(key, delta, value, cas);
+    }
+
+    // see SimpleLRU.h
+    std::size_t Shed(std::size_t target, std::size_t limit, std::vector<CacheNode *> &evicted) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(thread_safe);
+        return SimpleLRU::Shed(target, limit, evicted);
+    }
+
+    // see SimpleLRU.h, whole batch is done under the lock taken once
+    void GetBatch(std::vector<ReadItem> &items, const uint32_t *which, std::size_t count) override {
+        std::vector<uint32_t> rest;
+        if (InlineValues()) {
+            _inline_get_batch(items, which, count, rest);
+            which = rest.data();
+            count = rest.size();
+            if (count == 0) {
+                return;
+            }
+        }
+        if (ConcurrentGet()) {
+            Concurrency::SharedLockGuard<Concurrency::SharedMutex> lock(thread_safe);
+            SimpleLRU::GetBatch(items, which, count);
+            return;
+        }
+        std::lock_guard<Concurrency::SharedMutex> lock(thread_safe);
+        SimpleLRU::GetBatch(items, which, count);
+    }
+
+    // see SimpleLRU.h, whole batch is done under the lock taken once
+    void PutBatch(std::vector<WriteItem> &items, const uint32_t *which, std::size_t count) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(thread_safe);
+        SimpleLRU::PutBatch(items, which, count);
+    }
+
+    // see SimpleLRU.h
+    void GetStats(std::vector<std::pair<std::string, uint64_t>> &stats) const override {
+        Concurrency::SharedLockGuard<Concurrency::SharedMutex> lock(thread_safe);
+        SimpleLRU::GetStats(stats);
     }
 
-private:
-    std::mutex thread_safe;
+protected:
+    mutable Concurrency::SharedMutex thread_safe;
 };
 
 } // namespace Backend
@@ -0,0 +1,139 @@
+#include "TimerWheel.h"
+
+namespace Afina {
+namespace Backend {
+
+constexpr std::uint16_t TimerWheel::OVERFLOW_SLOT;
+
+TimerWheel::TimerWheel(std::vector<CacheNode *> &nodes, std::uint32_t now) : _nodes(nodes), _now(now), _size(0) {
+    for (auto &head : _slots) {
+        head = CacheNode::NIL;
+    }
+    for (auto &size : _level_size) {
+        size = 0;
+    }
+}
+
+std::uint16_t TimerWheel::_slot_of(std::uint32_t expire) const {
+    if (expire <= _now) {
+        // Already expired, fires on the next tick
+        return (_now + 1) & (SLOTS - 1);
+    }
+    // Level is defined by the highest bit that differs from the current time: timer could be found
+    // in the slot once all lower levels have wrapped around
+    std::uint32_t diff = expire ^ _now;
+    for (unsigned level = 0; level < LEVELS; ++level) {
+        if ((diff >> (SLOT_BITS * (level + 1))) == 0) {
+            return level * SLOTS + ((expire >> (SLOT_BITS * level)) & (SLOTS - 1));
+        }
+    }
+    return OVERFLOW_SLOT;
+}
+
+void TimerWheel::_link(std::uint16_t slot, std::uint32_t id) {
+    CacheNode *node = _nodes[id];
+    node->timer_slot = slot;
+    node->timer_prev = CacheNode::NIL;
+    node->timer_next = _slots[slot];
+    if (_slots[slot] != CacheNode::NIL) {
+        _nodes[_slots[slot]]->timer_prev = id;
+    }
+    _slots[slot] = id;
+    _level_size[slot / SLOTS]++;
+}
+
+std::uint32_t TimerWheel::_take(std::uint16_t slot) {
+    std::uint32_t head = _slots[slot];
+    _slots[slot] = CacheNode::NIL;
+    return head;
+}
+
+// See TimerWheel.h
+void TimerWheel::Schedule(std::uint32_t id) {
+    _link(_slot_of(_nodes[id]->expire), id);
+    _size++;
+}
+
+// See TimerWheel.h
+void TimerWheel::Cancel(std::uint32_t id) {
+    CacheNode *node = _nodes[id];
+    if (node->timer_slot == CacheNode::NO_SLOT) {
+        return;
+    }
+    if (node->timer_prev != CacheNode::NIL) {
+        _nodes[node->timer_prev]->timer_next = node->timer_next;
+    } else {
+        _slots[node->timer_slot] = node->timer_next;
+    }
+    if (node->timer_next != CacheNode::NIL) {
+        _nodes[node->timer_next]->timer_prev = node->timer_prev;
+    }
+    _level_size[node->timer_slot / SLOTS]--;
+    node->timer_slot = CacheNode::NO_SLOT;
+    node->timer_prev = node->timer_next = CacheNode::NIL;
+    _size--;
+}
+
+void TimerWheel::_cascade(std::uint16_t slot) {
+    std::uint32_t id = _take(slot);
+    while (id != CacheNode::NIL) {
+        std::uint32_t next = _nodes[id]->timer_next;
+        _level_size[slot / SLOTS]--;
+        // Timer of the current tick goes to the slot that is about to fire
+        std::uint32_t expire = _nodes[id]->expire;
+        _link(expire <= _now ? (_now & (SLOTS - 1)) : _slot_of(expire), id);
+        id = next;
+    }
+}
+
+// See TimerWheel.h
+void TimerWheel::Advance(std::uint32_t now, std::vector<std::uint32_t> &expired) {
+    while (_now < now) {
+        if (_size == 0) {
+            // Nothing to fire, slot positions are defined by absolute time
+            _now = now;
+            break;
+        }
+        // Lower wheels are empty: skip right to the tick before the next cascade of the first non-empty one
+        unsigned empty = 0;
+        while (empty < LEVELS && _level_size[empty] == 0) {
+            empty++;
+        }
+        if (empty > 0) {
+            std::uint32_t skip = _now | ((1u << (SLOT_BITS * empty)) - 1);
+            if (skip >= now) {
+                _now = now;
+                break;
+            }
+            _now = skip;
+        }
+
+        std::uint32_t tick = _now + 1;
+        _now = tick;
+        // Once lower wheels wrap around, next slot of the upper one comes down. Upper wheels go first,
+        // so their timers get into the lower slots which are cascaded right after
+        if ((tick & ((1u << (SLOT_BITS * LEVELS)) - 1)) == 0) {
+            _cascade(OVERFLOW_SLOT);
+        }
+        for (unsigned level = LEVELS - 1; level > 0; --level) {
+            if ((tick & ((1u << (SLOT_BITS * level)) - 1)) == 0) {
+                _cascade(level * SLOTS + ((tick >> (SLOT_BITS * level)) & (SLOTS - 1)));
+            }
+        }
+
+        std::uint32_t id = _take(tick & (SLOTS - 1));
+        while (id != CacheNode::NIL) {
+            CacheNode *node = _nodes[id];
+            std::uint32_t next = node->timer_next;
+            node->timer_slot = CacheNode::NO_SLOT;
+            node->timer_prev = node->timer_next = CacheNode::NIL;
+            expired.push_back(id);
+            _level_size[0]--;
+            _size--;
+            id = next;
+        }
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
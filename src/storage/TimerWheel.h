@@ -0,0 +1,87 @@
+#ifndef AFINA_STORAGE_TIMER_WHEEL_H
+#define AFINA_STORAGE_TIMER_WHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "CacheNode.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Hierarchical timer wheel of the node expiration times
+ * Nodes with CacheNode#expire are linked into slots by CacheNode#timer_prev/timer_next. There are LEVELS
+ * wheels of SLOTS slots, wheel of level L covers 64^(L+1) seconds ahead with 64^L seconds per slot. Timers
+ * further than that wait in the overflow list.
+ *
+ * Every tick fires one slot of the lowest wheel, once per 64 ticks slot of the next wheel is cascaded into
+ * the lower ones and so on. So cost per tick is constant plus the number of timers fired or cascaded, and
+ * every timer is cascaded at most LEVELS times. Ticks of the empty lower wheels are skipped at once, so
+ * advance after a long idle period is cheap too. Schedule and Cancel are O(1).
+ *
+ * That is NOT thread safe implementaiton!!
+ */
+class TimerWheel {
+public:
+    /**
+     * @param nodes node table of the cache
+     * @param now current unix time in seconds
+     */
+    TimerWheel(std::vector<CacheNode *> &nodes, std::uint32_t now);
+
+    /**
+     * Number of scheduled timers
+     */
+    std::size_t Size() const { return _size; }
+
+    /**
+     * Schedules node expiration at CacheNode#expire, which must not be 0. Node must not be scheduled yet
+     */
+    void Schedule(std::uint32_t id);
+
+    /**
+     * Cancels node expiration if it is scheduled
+     */
+    void Cancel(std::uint32_t id);
+
+    /**
+     * Moves wheel time up to now, appends ids of the nodes that have expired by then. Expired nodes are
+     * not scheduled anymore
+     */
+    void Advance(std::uint32_t now, std::vector<std::uint32_t> &expired);
+
+private:
+    static constexpr unsigned SLOT_BITS = 6;
+    static constexpr unsigned SLOTS = 1 << SLOT_BITS;
+    static constexpr unsigned LEVELS = 4;
+    static constexpr std::uint16_t OVERFLOW_SLOT = LEVELS * SLOTS;
+
+    // Slot for the node expiration relative to current wheel time
+    std::uint16_t _slot_of(std::uint32_t expire) const;
+
+    void _link(std::uint16_t slot, std::uint32_t id);
+
+    // Detaches whole slot, returns its first node
+    std::uint32_t _take(std::uint16_t slot);
+
+    // Reschedules all nodes of the slot according to current wheel time
+    void _cascade(std::uint16_t slot);
+
+    std::vector<CacheNode *> &_nodes;
+
+    // Heads of the slot lists, the last one is overflow list
+    std::uint32_t _slots[LEVELS * SLOTS + 1];
+    // Number of timers in every wheel and in overflow list
+    std::size_t _level_size[LEVELS + 1];
+
+    // All timers up to this time have fired
+    std::uint32_t _now;
+    std::size_t _size;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_TIMER_WHEEL_H
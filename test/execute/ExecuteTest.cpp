@@ -0,0 +1,354 @@
+#include <gtest/gtest.h>
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <afina/execute/Add.h>
+#include <afina/execute/Append.h>
+#include <afina/execute/Binary.h>
+#include <afina/execute/Cas.h>
+#include <afina/execute/Counters.h>
+#include <afina/execute/Decr.h>
+#include <afina/execute/Get.h>
+#include <afina/execute/Incr.h>
+#include <afina/execute/MetaDelete.h>
+#include <afina/execute/MetaGet.h>
+#include <afina/execute/MetaNoop.h>
+#include <afina/execute/MetaSet.h>
+#include <afina/execute/Prepend.h>
+#include <afina/execute/Set.h>
+#include <afina/execute/Stats.h>
+
+#include "storage/SimpleLRU.h"
+#include "storage/StripedLRU.h"
+
+using namespace Afina;
+
+// Flags of the value are returned by get as they were set
+TEST(ExecuteTest, GetReturnsFlags) {
+    Backend::SimpleLRU storage(1024 * 1024);
+    std::string out;
+
+    Execute::Set("foo", 42, 0).Execute(storage, "fooval", out);
+    ASSERT_EQ("STORED", out);
+    Execute::Add("bar", 4294967295u, 0).Execute(storage, "barval", out);
+    ASSERT_EQ("STORED", out);
+
+    Execute::Get({"foo", "none", "bar"}).Execute(storage, "", out);
+    ASSERT_EQ("VALUE foo 42 6\r\nfooval\r\nVALUE bar 4294967295 6\r\nbarval\r\nEND", out);
+
+    // append keeps flags of the existing value
+    Execute::Append("foo", 7, 0).Execute(storage, "!", out);
+    ASSERT_EQ("STORED", out);
+    Execute::Get({"foo"}).Execute(storage, "", out);
+    ASSERT_EQ("VALUE foo 42 7\r\nfooval!\r\nEND", out);
+}
+
+// Value fetched with gets could be updated by cas only once
+TEST(ExecuteTest, GetsCas) {
+    Backend::SimpleLRU storage(1024 * 1024);
+    std::string out;
+
+    Execute::Set("foo", 1, 0).Execute(storage, "fooval", out);
+    Execute::Get({"foo"}, true).Execute(storage, "", out);
+    ASSERT_EQ(0, out.find("VALUE foo 1 6 "));
+    uint64_t cas = std::stoull(out.substr(14));
+
+    Execute::Cas("foo", 2, 0, cas).Execute(storage, "newval", out);
+    ASSERT_EQ("STORED", out);
+    Execute::Cas("foo", 3, 0, cas).Execute(storage, "oldval", out);
+    ASSERT_EQ("EXISTS", out);
+    Execute::Cas("bar", 3, 0, cas).Execute(storage, "barval", out);
+    ASSERT_EQ("NOT_FOUND", out);
+
+    Execute::Get({"foo"}).Execute(storage, "", out);
+    ASSERT_EQ("VALUE foo 2 6\r\nnewval\r\nEND", out);
+}
+
+// Multi-get over stripes keeps the order of the requested keys
+TEST(ExecuteTest, GetManyStripes) {
+    auto storage = Backend::StripedLRU::BuildStripedLRU(16 * 1024 * 1024UL, 4);
+    std::string out, expected;
+    std::vector<std::string> keys;
+
+    for (int i = 0; i < 20; ++i) {
+        std::string key = "key" + std::to_string(i);
+        Execute::Set(key, i, 0).Execute(*storage, "v" + std::to_string(i), out);
+        keys.push_back(key);
+        if (i % 3 != 0) {
+            expected += "VALUE " + key + " " + std::to_string(i) + " " + std::to_string(1 + std::to_string(i).size()) +
+                        "\r\nv" + std::to_string(i) + "\r\n";
+        }
+    }
+    for (int i = 0; i < 20; i += 3) {
+        storage->Delete("key" + std::to_string(i));
+    }
+
+    Execute::Get(std::vector<Key>(keys.begin(), keys.end())).Execute(*storage, "", out);
+    ASSERT_EQ(expected + "END", out);
+}
+
+// Counter and list updates done in place
+TEST(ExecuteTest, UpdateInPlace) {
+    Backend::SimpleLRU storage(1024 * 1024);
+    std::string out;
+
+    Execute::Incr("num", 1).Execute(storage, "", out);
+    ASSERT_EQ("NOT_FOUND", out);
+    Execute::Set("num", 3, 0).Execute(storage, "99", out);
+    Execute::Incr("num", 1).Execute(storage, "", out);
+    ASSERT_EQ("100", out);
+    Execute::Decr("num", 1000).Execute(storage, "", out);
+    ASSERT_EQ("0", out);
+
+    Execute::Prepend("num", 0, 0).Execute(storage, "x", out);
+    ASSERT_EQ("STORED", out);
+    Execute::Append("num", 0, 0).Execute(storage, "y", out);
+    ASSERT_EQ("STORED", out);
+    Execute::Get({"num"}).Execute(storage, "", out);
+    ASSERT_EQ("VALUE num 3 3\r\nx0y\r\nEND", out);
+
+    Execute::Incr("num", 1).Execute(storage, "", out);
+    ASSERT_EQ("CLIENT_ERROR cannot increment or decrement non-numeric value", out);
+    Execute::Prepend("none", 0, 0).Execute(storage, "x", out);
+    ASSERT_EQ("NOT_STORED", out);
+}
+
+// Binary commands reply with status and opaque, quiet ones only when there is something to tell
+TEST(ExecuteTest, BinaryCommands) {
+    using Execute::Binary;
+    Backend::SimpleLRU storage(1024 * 1024);
+    std::string out, extras;
+    auto status = [&out]() { return Binary::Load(&out[Binary::STATUS], 2); };
+
+    Binary::Store(extras, 42, 4);
+    Binary::Store(extras, 0, 4);
+    Binary(Binary::SETQ, "foo", extras.data(), extras.size(), 1, 0).Execute(storage, "fooval", out);
+    ASSERT_TRUE(out.empty());
+    Binary(Binary::ADD, "foo", extras.data(), extras.size(), 2, 0).Execute(storage, "other", out);
+    ASSERT_EQ(Binary::RESPONSE, uint8_t(out[Binary::MAGIC]));
+    ASSERT_EQ(Binary::KEY_EXISTS, status());
+    ASSERT_EQ(2, Binary::Load(&out[Binary::OPAQUE], 4));
+    // errors carry the memcached message
+    ASSERT_EQ("Data exists for key.", out.substr(Binary::HEADER_SIZE));
+    ASSERT_EQ(out.size() - Binary::HEADER_SIZE, Binary::Load(&out[Binary::BODY_LENGTH], 4));
+
+    Binary(Binary::GETK, "foo", nullptr, 0, 3, 0).Execute(storage, "", out);
+    ASSERT_EQ(Binary::NO_ERROR, status());
+    ASSERT_EQ(4, uint8_t(out[Binary::EXTRAS_LENGTH]));
+    ASSERT_EQ(3, Binary::Load(&out[Binary::KEY_LENGTH], 2));
+    ASSERT_EQ(4 + 3 + 6, Binary::Load(&out[Binary::BODY_LENGTH], 4));
+    ASSERT_EQ(42, Binary::Load(&out[Binary::HEADER_SIZE], 4));
+    ASSERT_EQ("foofooval", out.substr(Binary::HEADER_SIZE + 4));
+    uint64_t cas = Binary::Load(&out[Binary::CAS], 8);
+    ASSERT_NE(0, cas);
+
+    Binary(Binary::GETQ, "none", nullptr, 0, 4, 0).Execute(storage, "", out);
+    ASSERT_TRUE(out.empty());
+    Binary(Binary::GET, "none", nullptr, 0, 4, 0).Execute(storage, "", out);
+    ASSERT_EQ(Binary::KEY_NOT_FOUND, status());
+    ASSERT_EQ("Not found", out.substr(Binary::HEADER_SIZE));
+    Binary(Binary::GETK, "none", nullptr, 0, 4, 0).Execute(storage, "", out);
+    ASSERT_EQ(Binary::KEY_NOT_FOUND, status());
+    ASSERT_EQ("none", out.substr(Binary::HEADER_SIZE));
+
+    // set with cas succeeds only once, reply has the new cas
+    Binary(Binary::SET, "foo", extras.data(), extras.size(), 5, cas).Execute(storage, "newval", out);
+    ASSERT_EQ(Binary::NO_ERROR, status());
+    uint64_t new_cas = Binary::Load(&out[Binary::CAS], 8);
+    ASSERT_NE(0, new_cas);
+    ASSERT_NE(cas, new_cas);
+    Binary(Binary::SET, "foo", extras.data(), extras.size(), 6, cas).Execute(storage, "oldval", out);
+    ASSERT_EQ(Binary::KEY_EXISTS, status());
+    ASSERT_EQ(0, Binary::Load(&out[Binary::CAS], 8));
+    Binary(Binary::GET, "foo", nullptr, 0, 6, 0).Execute(storage, "", out);
+    ASSERT_EQ(new_cas, Binary::Load(&out[Binary::CAS], 8));
+
+    // every store reports the cas of the stored item
+    Binary(Binary::ADD, "bar", extras.data(), extras.size(), 6, 0).Execute(storage, "barval", out);
+    ASSERT_EQ(Binary::NO_ERROR, status());
+    cas = Binary::Load(&out[Binary::CAS], 8);
+    ASSERT_NE(0, cas);
+    Binary(Binary::REPLACE, "bar", extras.data(), extras.size(), 6, 0).Execute(storage, "other", out);
+    ASSERT_EQ(Binary::NO_ERROR, status());
+    new_cas = Binary::Load(&out[Binary::CAS], 8);
+    ASSERT_NE(cas, new_cas);
+    Binary(Binary::APPEND, "bar", nullptr, 0, 6, 0).Execute(storage, "!", out);
+    ASSERT_EQ(Binary::NO_ERROR, status());
+    cas = Binary::Load(&out[Binary::CAS], 8);
+    ASSERT_NE(new_cas, cas);
+    Binary(Binary::GET, "bar", nullptr, 0, 6, 0).Execute(storage, "", out);
+    ASSERT_EQ(cas, Binary::Load(&out[Binary::CAS], 8));
+
+    // missing counter is created with the initial value
+    std::string counter;
+    Binary::Store(counter, 5, 8);
+    Binary::Store(counter, 10, 8);
+    Binary::Store(counter, 0, 4);
+    Binary(Binary::INCREMENT, "num", counter.data(), counter.size(), 7, 0).Execute(storage, "", out);
+    ASSERT_EQ(Binary::NO_ERROR, status());
+    ASSERT_EQ(10, Binary::Load(&out[Binary::HEADER_SIZE], 8));
+    cas = Binary::Load(&out[Binary::CAS], 8);
+    ASSERT_NE(0, cas);
+    Binary(Binary::INCREMENT, "num", counter.data(), counter.size(), 8, 0).Execute(storage, "", out);
+    ASSERT_EQ(15, Binary::Load(&out[Binary::HEADER_SIZE], 8));
+    // reply has the cas of the updated counter
+    new_cas = Binary::Load(&out[Binary::CAS], 8);
+    ASSERT_NE(cas, new_cas);
+    Binary(Binary::GET, "num", nullptr, 0, 8, 0).Execute(storage, "", out);
+    ASSERT_EQ(new_cas, Binary::Load(&out[Binary::CAS], 8));
+    Binary(Binary::DECREMENT, "foo", counter.data(), counter.size(), 8, 0).Execute(storage, "", out);
+    ASSERT_EQ(Binary::NON_NUMERIC, status());
+    ASSERT_EQ("Non-numeric server-side value for incr or decr", out.substr(Binary::HEADER_SIZE));
+
+    Binary(Binary::DELETEQ, "foo", nullptr, 0, 9, 0).Execute(storage, "", out);
+    ASSERT_TRUE(out.empty());
+    Binary(Binary::DELETEQ, "foo", nullptr, 0, 10, 0).Execute(storage, "", out);
+    ASSERT_EQ(Binary::KEY_NOT_FOUND, status());
+
+    Binary(Binary::SET, "foo", nullptr, 0, 11, 0).Execute(storage, "", out);
+    ASSERT_EQ(Binary::INVALID_ARGUMENTS, status());
+    ASSERT_EQ("Invalid arguments", out.substr(Binary::HEADER_SIZE));
+    Binary(0x42, "foo", nullptr, 0, 12, 0).Execute(storage, "", out);
+    ASSERT_EQ(Binary::UNKNOWN_COMMAND, status());
+    ASSERT_EQ("Unknown command", out.substr(Binary::HEADER_SIZE));
+    Binary(Binary::NOOP, "", nullptr, 0, 13, 0).Execute(storage, "", out);
+    ASSERT_EQ(Binary::HEADER_SIZE, out.size());
+    ASSERT_EQ(Binary::NO_ERROR, status());
+
+    // quit is answered, quitq is not, both close the connection
+    Binary quit(Binary::QUIT, "", nullptr, 0, 14, 0);
+    quit.Execute(storage, "", out);
+    ASSERT_EQ(Binary::HEADER_SIZE, out.size());
+    ASSERT_EQ(Binary::NO_ERROR, status());
+    ASSERT_TRUE(quit.ClosesConnection());
+    Binary quitq(Binary::QUITQ, "", nullptr, 0, 15, 0);
+    quitq.Execute(storage, "", out);
+    ASSERT_TRUE(out.empty());
+    ASSERT_TRUE(quitq.ClosesConnection());
+    ASSERT_FALSE(Binary(Binary::NOOP, "", nullptr, 0, 16, 0).ClosesConnection());
+}
+
+// Meta commands reply with the fields asked for, quiet ones only with the unusual outcome
+TEST(ExecuteTest, MetaCommands) {
+    Backend::SimpleLRU storage(1024 * 1024);
+    std::string out;
+    using Execute::MetaCommand;
+    using Execute::MetaSet;
+
+    MetaSet("foo", 0, "1", 1, 5, 0, 0, MetaSet::SET).Execute(storage, "fooval", out);
+    ASSERT_EQ("HD O1", out);
+    MetaSet("foo", MetaCommand::QUIET, nullptr, 0, 5, 0, 0, MetaSet::ADD).Execute(storage, "other", out);
+    ASSERT_EQ("NS", out);
+    MetaSet("foo", MetaCommand::QUIET, nullptr, 0, 0, 0, 0, MetaSet::APPEND).Execute(storage, "!", out);
+    ASSERT_EQ("", out);
+    MetaSet("bar", MetaCommand::RETURN_KEY, nullptr, 0, 0, 0, 0, MetaSet::REPLACE).Execute(storage, "x", out);
+    ASSERT_EQ("NS kbar", out);
+
+    Execute::MetaGet("foo", MetaCommand::RETURN_VALUE | MetaCommand::RETURN_FLAGS | MetaCommand::RETURN_SIZE |
+                                MetaCommand::RETURN_KEY,
+                     "op", 2)
+        .Execute(storage, "", out);
+    ASSERT_EQ("VA 7 f5 s7 Oop kfoo\r\nfooval!", out);
+    Execute::MetaGet("foo", MetaCommand::RETURN_CAS, nullptr, 0).Execute(storage, "", out);
+    ASSERT_EQ(0, out.find("HD c"));
+    uint64_t cas = std::stoull(out.substr(4));
+
+    MetaSet("foo", 0, nullptr, 0, 0, 0, cas + 1, MetaSet::SET).Execute(storage, "stale", out);
+    ASSERT_EQ("EX", out);
+    MetaSet("baz", 0, nullptr, 0, 0, 0, cas, MetaSet::SET).Execute(storage, "stale", out);
+    ASSERT_EQ("NF", out);
+    MetaSet("foo", MetaCommand::QUIET, nullptr, 0, 0, 0, cas, MetaSet::SET).Execute(storage, "new", out);
+    ASSERT_EQ("", out);
+
+    Execute::MetaGet("none", MetaCommand::RETURN_VALUE, "2", 1).Execute(storage, "", out);
+    ASSERT_EQ("EN O2", out);
+    Execute::MetaGet("none", MetaCommand::QUIET, "2", 1).Execute(storage, "", out);
+    ASSERT_EQ("", out);
+
+    Execute::MetaDelete("foo", 0, nullptr, 0).Execute(storage, "", out);
+    ASSERT_EQ("HD", out);
+    Execute::MetaDelete("foo", 0, "3", 1).Execute(storage, "", out);
+    ASSERT_EQ("NF O3", out);
+    Execute::MetaDelete("foo", MetaCommand::QUIET, nullptr, 0).Execute(storage, "", out);
+    ASSERT_EQ("", out);
+    Execute::MetaNoop().Execute(storage, "", out);
+    ASSERT_EQ("MN", out);
+}
+
+// Verify ms returns cas unique of the stored item and mg returns time to live
+TEST(ExecuteTest, MetaCasAndTtl) {
+    Backend::SimpleLRU storage(1024 * 1024);
+    std::string out;
+    using Execute::MetaCommand;
+    using Execute::MetaSet;
+
+    MetaSet("foo", MetaCommand::RETURN_CAS | MetaCommand::RETURN_KEY, nullptr, 0, 0, 0, 0, MetaSet::SET)
+        .Execute(storage, "fooval", out);
+    ASSERT_EQ(0, out.find("HD c"));
+    uint64_t cas = std::stoull(out.substr(4));
+    ASSERT_EQ(" kfoo", out.substr(out.find(' ', 4)));
+    Execute::MetaGet("foo", MetaCommand::RETURN_CAS | MetaCommand::RETURN_TTL, nullptr, 0).Execute(storage, "", out);
+    ASSERT_EQ("HD c" + std::to_string(cas) + " t-1", out);
+
+    MetaSet("foo", MetaCommand::RETURN_CAS, nullptr, 0, 0, 100, cas, MetaSet::SET).Execute(storage, "new", out);
+    ASSERT_EQ(0, out.find("HD c"));
+    uint64_t new_cas = std::stoull(out.substr(4));
+    ASSERT_NE(cas, new_cas);
+    Execute::MetaGet("foo", MetaCommand::RETURN_CAS | MetaCommand::RETURN_TTL, nullptr, 0).Execute(storage, "", out);
+    ASSERT_EQ(0, out.find("HD c" + std::to_string(new_cas) + " t"));
+    int ttl = std::stoi(out.substr(out.find(" t") + 2));
+    ASSERT_LE(99, ttl);
+    ASSERT_GE(100, ttl);
+
+    MetaSet("foo", MetaCommand::RETURN_CAS, nullptr, 0, 0, 0, 0, MetaSet::APPEND).Execute(storage, "!", out);
+    ASSERT_EQ(0, out.find("HD c"));
+    cas = std::stoull(out.substr(4));
+    Execute::MetaGet("foo", MetaCommand::RETURN_CAS, nullptr, 0).Execute(storage, "", out);
+    ASSERT_EQ("HD c" + std::to_string(cas), out);
+
+    // Nothing is stored, so there is no cas to return
+    MetaSet("foo", MetaCommand::RETURN_CAS, nullptr, 0, 0, 0, 0, MetaSet::ADD).Execute(storage, "x", out);
+    ASSERT_EQ("NS", out);
+    MetaSet("foo", MetaCommand::RETURN_CAS | MetaCommand::QUIET, nullptr, 0, 0, 0, 0, MetaSet::SET)
+        .Execute(storage, "x", out);
+    ASSERT_EQ("", out);
+}
+
+// Server counters of all threads are summed up by stats
+TEST(ExecuteTest, StatsCounters) {
+    Backend::SimpleLRU storage(1024 * 1024);
+    std::string out;
+    auto counters = [&storage, &out]() {
+        Execute::Stats().Execute(storage, "", out);
+        std::map<std::string, uint64_t> result;
+        std::istringstream lines(out);
+        std::string stat, name;
+        uint64_t value;
+        while (lines >> stat >> name >> value) {
+            result[name] = value;
+        }
+        return result;
+    };
+
+    auto before = counters();
+    Execute::Set("foo", 0, 0).Execute(storage, "fooval", out);
+    std::thread reader([&storage]() {
+        std::string out;
+        Execute::Get({"foo", "none", "bar"}).Execute(storage, "", out);
+        Execute::Counters::Add(Execute::Counters::BYTES_READ, 10);
+    });
+    reader.join();
+    Execute::Get({"foo"}).Execute(storage, "", out);
+
+    auto after = counters();
+    EXPECT_EQ(before["get_hits"] + 2, after["get_hits"]);
+    EXPECT_EQ(before["get_misses"] + 2, after["get_misses"]);
+    EXPECT_EQ(before["bytes_read"] + 10, after["bytes_read"]);
+    // Hits and misses are counted by the storage only
+    EXPECT_EQ(std::string::npos, out.find("get_hits", out.find("get_hits") + 1));
+    EXPECT_EQ(1u, after["curr_items"]);
+}
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+
+#include <afina/execute/Binary.h>
+
+#include <protocol/Parser.h>
+
+using namespace Afina;
+using Execute::Binary;
+
+namespace {
+
+// Binary request with given opcode, extras, key and value
+std::string Request(uint8_t opcode, const std::string &extras, const std::string &key, const std::string &value,
+                    uint32_t opaque = 0, uint64_t cas = 0) {
+    std::string request;
+    request.push_back(static_cast<char>(Binary::REQUEST));
+    request.push_back(static_cast<char>(opcode));
+    Binary::Store(request, key.size(), 2);
+    Binary::Store(request, extras.size(), 1);
+    Binary::Store(request, 0, 3);
+    Binary::Store(request, extras.size() + key.size() + value.size(), 4);
+    Binary::Store(request, opaque, 4);
+    Binary::Store(request, cas, 8);
+    return request + extras + key + value;
+}
+
+} // namespace
+
+// Verify binary request is recognized by the magic byte and value is left to the connection
+TEST(BinaryParserTest, SetRequest) {
+    Protocol::Parser parser;
+
+    std::string extras;
+    Binary::Store(extras, 7, 4);
+    Binary::Store(extras, 0, 4);
+    const std::string input = Request(Binary::SET, extras, "foo", "fooval", 42);
+
+    size_t consumed = 0;
+    ASSERT_TRUE(parser.Parse(input, consumed));
+    ASSERT_EQ(Binary::HEADER_SIZE + 8 + 3, consumed);
+    ASSERT_TRUE(parser.Binary());
+
+    size_t value_size;
+    Binary *cmd = dynamic_cast<Binary *>(parser.Build(value_size));
+    ASSERT_FALSE(cmd == nullptr);
+    ASSERT_EQ(6, value_size);
+    ASSERT_EQ(Binary::SET, cmd->opcode());
+    ASSERT_EQ("foo", cmd->key().str());
+    ASSERT_EQ(42, cmd->opaque());
+
+    parser.Reset();
+    ASSERT_FALSE(parser.Binary());
+    ASSERT_TRUE(parser.Parse("get foo\r\n", consumed));
+    ASSERT_FALSE(parser.Binary());
+}
+
+// Verify request split between reads at every position is parsed the same way
+TEST(BinaryParserTest, SplitRequest) {
+    const std::string input = Request(Binary::GETKQ, "", "some_key", "", 7);
+    for (std::size_t split = 1; split < input.size(); ++split) {
+        Protocol::Parser parser;
+
+        size_t consumed = 0;
+        ASSERT_FALSE(parser.Parse(input.substr(0, split), consumed));
+        ASSERT_EQ(split, consumed);
+        std::string rest = input.substr(split) + "next";
+        ASSERT_TRUE(parser.Parse(rest, consumed));
+        ASSERT_EQ(input.size() - split, consumed);
+
+        size_t value_size;
+        Binary *cmd = dynamic_cast<Binary *>(parser.Build(value_size));
+        ASSERT_FALSE(cmd == nullptr);
+        ASSERT_EQ(0, value_size);
+        ASSERT_EQ(Binary::GETKQ, cmd->opcode());
+        ASSERT_EQ("some_key", cmd->key().str());
+        ASSERT_EQ(Hash("some_key"), cmd->key().hash());
+        ASSERT_EQ(7, cmd->opaque());
+    }
+}
+
+// Verify key of the request which is followed by the value outlives the input
+TEST(BinaryParserTest, KeyOutlivesInput) {
+    Protocol::Parser parser;
+
+    std::string input = Request(Binary::APPEND, "", "foo", "tail");
+    size_t consumed = 0, value_size;
+    ASSERT_TRUE(parser.Parse(input, consumed));
+    Binary *cmd = dynamic_cast<Binary *>(parser.Build(value_size));
+    std::memset(&input[0], 0, input.size());
+    ASSERT_EQ(4, value_size);
+    ASSERT_EQ("foo", cmd->key().str());
+}
+
+// Verify malformed header is rejected
+TEST(BinaryParserTest, Errors) {
+    Protocol::Parser parser;
+
+    std::string input = Request(Binary::GET, "", "foo", "");
+    input[Binary::BODY_LENGTH + 3] = 2;
+    size_t consumed = 0;
+    ASSERT_THROW(parser.Parse(input, consumed), std::runtime_error);
+}
@@ -1,10 +1,23 @@
 #include <gtest/gtest.h>
 
+#include <cstring>
+#include <map>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <afina/execute/Add.h>
+#include <afina/execute/Cas.h>
+#include <afina/execute/Counters.h>
+#include <afina/execute/Decr.h>
 #include <afina/execute/Get.h>
+#include <afina/execute/Incr.h>
+#include <afina/execute/MetaDelete.h>
+#include <afina/execute/MetaGet.h>
+#include <afina/execute/MetaNoop.h>
+#include <afina/execute/MetaSet.h>
+#include <afina/execute/Prepend.h>
 #include <afina/execute/Set.h>
 #include <afina/execute/Stats.h>
 
@@ -27,12 +40,12 @@ TEST(MemcachedParserTest, SimpleSet) {
     ASSERT_EQ("set", parser.Name());
 
     size_t value_size;
-    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    Execute::Command *cmd = parser.Build(value_size);
     ASSERT_FALSE(cmd == nullptr);
     ASSERT_EQ(6, value_size);
 
-    Execute::Set *tmp = reinterpret_cast<Execute::Set *>(cmd.get());
-    ASSERT_EQ("foo", tmp->key());
+    Execute::Set *tmp = reinterpret_cast<Execute::Set *>(cmd);
+    ASSERT_EQ("foo", tmp->key().str());
     ASSERT_EQ(0, tmp->flags());
     ASSERT_EQ(0, tmp->expire());
 }
@@ -48,37 +61,153 @@ TEST(MemcachedParserTest, SimpleAdd) {
     ASSERT_EQ("add", parser.Name());
 
     size_t value_size;
-    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    Execute::Command *cmd = parser.Build(value_size);
     ASSERT_FALSE(cmd == nullptr);
     ASSERT_EQ(60, value_size);
 
-    Execute::Add *tmp = reinterpret_cast<Execute::Add *>(cmd.get());
-    ASSERT_EQ("bar", tmp->key());
+    Execute::Add *tmp = reinterpret_cast<Execute::Add *>(cmd);
+    ASSERT_EQ("bar", tmp->key().str());
     ASSERT_EQ(10, tmp->flags());
     ASSERT_EQ(-1, tmp->expire());
 }
 
+// Verify multi-digit expiration time
+TEST(MemcachedParserTest, SetExpire) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    ASSERT_TRUE(parser.Parse("set foo 0 3600 6\r\nfooval\r\n", consumed));
+
+    size_t value_size;
+    Execute::Command *cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+
+    Execute::Set *tmp = reinterpret_cast<Execute::Set *>(cmd);
+    ASSERT_EQ(3600, tmp->expire());
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("set foo 0 -120 6\r\nfooval\r\n", consumed));
+    cmd = parser.Build(value_size);
+    tmp = reinterpret_cast<Execute::Set *>(cmd);
+    ASSERT_EQ(-120, tmp->expire());
+
+    parser.Reset();
+    ASSERT_THROW(parser.Parse("set foo 0 99999999999 6\r\nfooval\r\n", consumed), std::runtime_error);
+}
+
+// Verify cas command carries version of the value
+TEST(MemcachedParserTest, SimpleCas) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    bool cmd_avail = parser.Parse("cas foo 3 0 6 18446744073709551615\r\nfooval\r\n", consumed);
+    ASSERT_TRUE(cmd_avail);
+    ASSERT_EQ(36, consumed);
+    ASSERT_EQ("cas", parser.Name());
+
+    size_t value_size;
+    Execute::Command *cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    ASSERT_EQ(6, value_size);
+
+    Execute::Cas *tmp = reinterpret_cast<Execute::Cas *>(cmd);
+    ASSERT_EQ("foo", tmp->key().str());
+    ASSERT_EQ(3, tmp->flags());
+    ASSERT_EQ(18446744073709551615ULL, tmp->cas());
+
+    parser.Reset();
+    ASSERT_THROW(parser.Parse("cas foo 3 0 6 18446744073709551616\r\n", consumed), std::runtime_error);
+}
+
+// Verify gets command asks for versions
+TEST(MemcachedParserTest, SimpleGets) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    ASSERT_TRUE(parser.Parse("gets foo bar\r\n", consumed));
+
+    size_t value_size;
+    Execute::Command *cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+
+    Execute::Get *tmp = reinterpret_cast<Execute::Get *>(cmd);
+    ASSERT_EQ(2, tmp->keys().size());
+    ASSERT_TRUE(tmp->with_cas());
+}
+
 // Verify simple get command passed in a single string
+TEST(MemcachedParserTest, SimplePrepend) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    bool cmd_avail = parser.Parse("prepend foo 0 0 3\r\nabc\r\n", consumed);
+    ASSERT_TRUE(cmd_avail);
+    ASSERT_EQ(19, consumed);
+    ASSERT_EQ("prepend", parser.Name());
+
+    size_t value_size;
+    Execute::Command *cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    ASSERT_EQ(3, value_size);
+
+    Execute::Prepend *tmp = dynamic_cast<Execute::Prepend *>(cmd);
+    ASSERT_FALSE(tmp == nullptr);
+    ASSERT_EQ("foo", tmp->key().str());
+}
+
+TEST(MemcachedParserTest, IncrDecr) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    const std::string input = "incr counter 18446744073709551615\r\n";
+    bool cmd_avail = parser.Parse(input, consumed);
+    ASSERT_TRUE(cmd_avail);
+    ASSERT_EQ(35, consumed);
+    ASSERT_EQ("incr", parser.Name());
+
+    size_t value_size;
+    Execute::Command *cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    ASSERT_EQ(0, value_size);
+
+    Execute::Incr *incr = dynamic_cast<Execute::Incr *>(cmd);
+    ASSERT_FALSE(incr == nullptr);
+    ASSERT_EQ("counter", incr->key().str());
+    ASSERT_EQ(UINT64_MAX, incr->delta());
+
+    parser.Reset();
+    cmd_avail = parser.Parse("decr counter 5\r\n", consumed);
+    ASSERT_TRUE(cmd_avail);
+    cmd = parser.Build(value_size);
+    Execute::Decr *decr = dynamic_cast<Execute::Decr *>(cmd);
+    ASSERT_FALSE(decr == nullptr);
+    ASSERT_EQ(5, decr->delta());
+
+    parser.Reset();
+    ASSERT_THROW(parser.Parse("incr counter 18446744073709551616\r\n", consumed), std::runtime_error);
+}
+
 TEST(MemcachedParserTest, SimpleGet) {
     Protocol::Parser parser;
 
     size_t consumed = 0;
-    bool cmd_avail = parser.Parse("get ke key2 super_long_key\r\n", consumed);
+    const std::string input = "get ke key2 super_long_key\r\n";
+    bool cmd_avail = parser.Parse(input, consumed);
     ASSERT_TRUE(cmd_avail);
     ASSERT_EQ(28, consumed);
     ASSERT_EQ("get", parser.Name());
 
     size_t value_size;
-    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    Execute::Command *cmd = parser.Build(value_size);
     ASSERT_FALSE(cmd == nullptr);
     ASSERT_EQ(0, value_size);
 
-    Execute::Get *tmp = reinterpret_cast<Execute::Get *>(cmd.get());
-    std::vector<std::string> keys = tmp->keys();
+    Execute::Get *tmp = reinterpret_cast<Execute::Get *>(cmd);
+    const std::vector<Key> &keys = tmp->keys();
     ASSERT_EQ(3, keys.size());
-    ASSERT_EQ("ke", keys[0]);
-    ASSERT_EQ("key2", keys[1]);
-    ASSERT_EQ("super_long_key", keys[2]);
+    ASSERT_EQ("ke", keys[0].str());
+    ASSERT_EQ("key2", keys[1].str());
+    ASSERT_EQ("super_long_key", keys[2].str());
 }
 
 TEST(MemcachedParserTest, Stats) {
@@ -91,10 +220,250 @@ TEST(MemcachedParserTest, Stats) {
     ASSERT_EQ("stats", parser.Name());
 
     size_t value_size;
-    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    Execute::Command *cmd = parser.Build(value_size);
     ASSERT_FALSE(cmd == nullptr);
     ASSERT_EQ(0, value_size);
 
-    Execute::Stats *tmp = reinterpret_cast<Execute::Stats *>(cmd.get());
+    Execute::Stats *tmp = reinterpret_cast<Execute::Stats *>(cmd);
     ASSERT_FALSE(tmp == nullptr);
 }
+
+// Retrieval commands count requested keys, storage commands count themselves
+TEST(MemcachedParserTest, CommandCounters) {
+    auto counters = []() {
+        std::vector<std::pair<std::string, uint64_t>> stats;
+        Execute::Counters::GetStats(stats);
+        return std::map<std::string, uint64_t>(stats.begin(), stats.end());
+    };
+    auto before = counters();
+
+    for (const char *input : {"get a b c\r\n", "set a 0 0 1\r\nx\r\n", "mg a v\r\n", "incr a 1\r\n"}) {
+        Protocol::Parser parser;
+        size_t consumed = 0, value_size;
+        ASSERT_TRUE(parser.Parse(input, consumed));
+        ASSERT_FALSE(parser.Build(value_size) == nullptr);
+    }
+
+    auto after = counters();
+    EXPECT_EQ(before["cmd_get"] + 4, after["cmd_get"]);
+    EXPECT_EQ(before["cmd_set"] + 1, after["cmd_set"]);
+}
+
+// Verify command line split between reads at every position is parsed the same way
+TEST(MemcachedParserTest, SplitLine) {
+    const std::string input = "cas foo 3 -5 6 42\r\nfooval\r\n";
+    const std::size_t line = input.find('\n') + 1;
+    for (std::size_t split = 0; split < line; ++split) {
+        Protocol::Parser parser;
+
+        size_t consumed = 0;
+        ASSERT_FALSE(parser.Parse(input.substr(0, split), consumed));
+        ASSERT_EQ(split, consumed);
+        ASSERT_TRUE(parser.Parse(input.substr(split), consumed));
+        ASSERT_EQ(line - split, consumed);
+
+        size_t value_size;
+        Execute::Command *cmd = parser.Build(value_size);
+        ASSERT_FALSE(cmd == nullptr);
+        ASSERT_EQ(6, value_size);
+
+        Execute::Cas *tmp = dynamic_cast<Execute::Cas *>(cmd);
+        ASSERT_FALSE(tmp == nullptr);
+        ASSERT_EQ("foo", tmp->key().str());
+        ASSERT_EQ(-5, tmp->expire());
+        ASSERT_EQ(42, tmp->cas());
+    }
+}
+
+// Verify command line is not complete without the line end
+TEST(MemcachedParserTest, IncompleteLine) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    ASSERT_FALSE(parser.Parse("get foo", consumed));
+    ASSERT_EQ(7, consumed);
+
+    size_t value_size;
+    ASSERT_TRUE(parser.Build(value_size) == nullptr);
+
+    ASSERT_FALSE(parser.Parse(std::string(100, 'x'), consumed));
+    ASSERT_TRUE(parser.Parse("\r\nget bar\r\n", consumed));
+    ASSERT_EQ(2, consumed);
+
+    Execute::Command *cmd = parser.Build(value_size);
+    Execute::Get *tmp = dynamic_cast<Execute::Get *>(cmd);
+    ASSERT_FALSE(tmp == nullptr);
+    ASSERT_EQ(1, tmp->keys().size());
+    ASSERT_EQ("foo" + std::string(100, 'x'), tmp->keys()[0].str());
+
+    parser.Reset();
+    ASSERT_THROW(parser.Parse(std::string(100 * 1024, 'x'), consumed), std::runtime_error);
+}
+
+// Verify tokens could be separated by several spaces and noreply is accepted
+TEST(MemcachedParserTest, Spaces) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    const std::string input = "  get   foo  bar   \r\n";
+    ASSERT_TRUE(parser.Parse(input, consumed));
+
+    size_t value_size;
+    Execute::Command *cmd = parser.Build(value_size);
+    Execute::Get *get = dynamic_cast<Execute::Get *>(cmd);
+    ASSERT_FALSE(get == nullptr);
+    ASSERT_EQ(2, get->keys().size());
+    ASSERT_EQ("bar", get->keys()[1].str());
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("set  foo 1  0  3 noreply\r\n", consumed));
+    cmd = parser.Build(value_size);
+    ASSERT_EQ(3, value_size);
+    Execute::Set *set = dynamic_cast<Execute::Set *>(cmd);
+    ASSERT_FALSE(set == nullptr);
+    ASSERT_EQ(1, set->flags());
+}
+
+// Verify names which are not commands and malformed arguments are rejected
+TEST(MemcachedParserTest, Errors) {
+    const char *lines[] = {"\r\n",
+                           "g foo\r\n",
+                           "gat foo\r\n",
+                           "sets foo 0 0 1\r\n",
+                           "tsa foo\r\n",
+                           "get\r\n",
+                           "set foo 0 0\r\n",
+                           "set foo 0 0 1x\r\n",
+                           "set foo 0 - 1\r\n",
+                           "set foo 4294967296 0 1\r\n",
+                           "incr foo 1 2\r\n",
+                           "stats items\r\n",
+                           "mg\r\n",
+                           "mg foo x\r\n",
+                           "mg foo vv\r\n",
+                           "mg foo F1\r\n",
+                           "mg foo O0123456789abcdef0123456789abcdef0\r\n",
+                           "ms foo\r\n",
+                           "ms foo 1 MX\r\n",
+                           "ms foo 1 C5 MA\r\n",
+                           "ms foo 1 t\r\n",
+                           "mg foo t1\r\n",
+                           "md foo v\r\n",
+                           "md foo c\r\n",
+                           "mn foo\r\n"};
+    for (const char *line : lines) {
+        Protocol::Parser parser;
+
+        size_t consumed = 0;
+        ASSERT_THROW(parser.Parse(line, consumed), std::runtime_error) << line;
+    }
+}
+
+// Verify keys refer to the input unless they must outlive it
+TEST(MemcachedParserTest, KeysAreViews) {
+    Protocol::Parser parser;
+
+    char input[] = "get foo bar\r\nset baz 0 0 3\r\n";
+    size_t consumed = 0;
+    ASSERT_TRUE(parser.Parse(input, sizeof(input) - 1, consumed));
+
+    size_t value_size;
+    Execute::Command *cmd = parser.Build(value_size);
+    Execute::Get *get = dynamic_cast<Execute::Get *>(cmd);
+    ASSERT_FALSE(get == nullptr);
+    ASSERT_EQ(input + 4, get->keys()[0].data());
+    ASSERT_EQ(input + 8, get->keys()[1].data());
+    ASSERT_EQ(Hash("bar"), get->keys()[1].hash());
+
+    // value of set arrives with the next reads, which overwrite the buffer
+    parser.Reset();
+    size_t offset = consumed;
+    ASSERT_TRUE(parser.Parse(input + offset, sizeof(input) - 1 - offset, consumed));
+    cmd = parser.Build(value_size);
+    std::memset(input, 'x', sizeof(input) - 1);
+    Execute::Set *set = dynamic_cast<Execute::Set *>(cmd);
+    ASSERT_FALSE(set == nullptr);
+    ASSERT_EQ("baz", set->key().str());
+    ASSERT_EQ(Hash("baz"), set->key().hash());
+}
+
+// Verify commands are built in place and replaced by the next ones
+TEST(MemcachedParserTest, CommandsBuiltInPlace) {
+    Protocol::Parser parser;
+
+    const std::string input = "set foo 0 0 3\r\nget foo\r\n";
+    size_t consumed = 0, value_size;
+    ASSERT_TRUE(parser.Parse(input, consumed));
+    Execute::Command *set = parser.Build(value_size);
+    ASSERT_FALSE(dynamic_cast<Execute::Set *>(set) == nullptr);
+
+    parser.Reset();
+    size_t offset = consumed;
+    ASSERT_TRUE(parser.Parse(input.data() + offset, input.size() - offset, consumed));
+    Execute::Command *get = parser.Build(value_size);
+    ASSERT_FALSE(dynamic_cast<Execute::Get *>(get) == nullptr);
+    ASSERT_EQ(set, get);
+}
+
+// Verify meta commands with their flags
+TEST(MemcachedParserTest, MetaCommands) {
+    Protocol::Parser parser;
+
+    const std::string input = "mg foo v f c s t k q Oab\r\nms bar 6 F7 T-1 C42 Mr c q\r\nbarval\r\nmd baz q\r\nmn\r\n";
+    size_t consumed = 0, value_size, offset = 0;
+    ASSERT_TRUE(parser.Parse(input, consumed));
+    ASSERT_EQ("mg", parser.Name());
+    Execute::MetaGet *get = dynamic_cast<Execute::MetaGet *>(parser.Build(value_size));
+    ASSERT_FALSE(get == nullptr);
+    ASSERT_EQ(0, value_size);
+    ASSERT_EQ("foo", get->key().str());
+    ASSERT_EQ(Execute::MetaCommand::RETURN_VALUE | Execute::MetaCommand::RETURN_FLAGS |
+                  Execute::MetaCommand::RETURN_CAS | Execute::MetaCommand::RETURN_SIZE |
+                  Execute::MetaCommand::RETURN_TTL | Execute::MetaCommand::RETURN_KEY | Execute::MetaCommand::QUIET,
+              get->options());
+    ASSERT_EQ("ab", get->opaque());
+
+    parser.Reset();
+    offset += consumed;
+    ASSERT_TRUE(parser.Parse(input.data() + offset, input.size() - offset, consumed));
+    Execute::MetaSet *set = dynamic_cast<Execute::MetaSet *>(parser.Build(value_size));
+    ASSERT_FALSE(set == nullptr);
+    ASSERT_EQ(6, value_size);
+    ASSERT_EQ("bar", set->key().str());
+    ASSERT_EQ(Execute::MetaCommand::RETURN_CAS | Execute::MetaCommand::QUIET, set->options());
+    ASSERT_EQ(7, set->flags());
+    ASSERT_EQ(-1, set->expire());
+    ASSERT_EQ(42, set->cas());
+    ASSERT_EQ(Execute::MetaSet::REPLACE, set->mode());
+
+    parser.Reset();
+    offset += consumed + value_size + 2;
+    ASSERT_TRUE(parser.Parse(input.data() + offset, input.size() - offset, consumed));
+    Execute::MetaDelete *del = dynamic_cast<Execute::MetaDelete *>(parser.Build(value_size));
+    ASSERT_FALSE(del == nullptr);
+    ASSERT_EQ("baz", del->key().str());
+    ASSERT_EQ(Execute::MetaCommand::QUIET, del->options());
+    ASSERT_EQ("", del->opaque());
+
+    parser.Reset();
+    offset += consumed;
+    ASSERT_TRUE(parser.Parse(input.data() + offset, input.size() - offset, consumed));
+    ASSERT_FALSE(dynamic_cast<Execute::MetaNoop *>(parser.Build(value_size)) == nullptr);
+    ASSERT_EQ(input.size(), offset + consumed);
+}
+
+// Verify key and opaque token of ms survive the input reused for the value
+TEST(MemcachedParserTest, MetaSetOutlivesInput) {
+    Protocol::Parser parser;
+
+    char input[] = "ms foo 3 Oxyz\r\n";
+    size_t consumed = 0, value_size;
+    ASSERT_TRUE(parser.Parse(input, sizeof(input) - 1, consumed));
+    Execute::MetaSet *set = dynamic_cast<Execute::MetaSet *>(parser.Build(value_size));
+    std::memset(input, 'x', sizeof(input) - 1);
+    ASSERT_FALSE(set == nullptr);
+    ASSERT_EQ("foo", set->key().str());
+    ASSERT_EQ(Hash("foo"), set->key().hash());
+    ASSERT_EQ("xyz", set->opaque());
+    ASSERT_EQ(Execute::MetaSet::SET, set->mode());
+}
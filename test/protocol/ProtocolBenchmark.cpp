@@ -0,0 +1,123 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <afina/execute/Command.h>
+
+#include "protocol/Parser.h"
+#include "storage/SimpleLRU.h"
+
+using namespace Afina;
+
+// Protocol benchmarks, prints throughput of the command processing and heap allocations it makes
+//
+// make runProtocolBenchmark && ./test/protocol/runProtocolBenchmark
+
+namespace {
+
+std::atomic<std::size_t> allocations{0};
+
+} // namespace
+
+void *operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+void report(std::ostream &out, const std::string &name, std::size_t ops, std::size_t allocs,
+            bench_clock::time_point start) {
+    double seconds = std::chrono::duration<double>(bench_clock::now() - start).count();
+    out << std::left << std::setw(40) << name << std::right << std::setw(12) << std::fixed << std::setprecision(1)
+        << (ops / seconds / 1e6) << " Mops/s" << std::setw(12) << std::setprecision(2) << (double(allocs) / ops)
+        << " allocs/op" << std::endl;
+}
+
+// Pipelined requests as they come from the socket
+std::string make_input(std::size_t count) {
+    std::string input;
+    for (std::size_t i = 0; i < count; ++i) {
+        std::string key = "key:" + std::to_string(i % 1000);
+        switch (i % 4) {
+        case 0:
+            input += "set " + key + " 0 0 10\r\n0123456789\r\n";
+            break;
+        case 1:
+            input += "get " + key + " key:1 key:none\r\n";
+            break;
+        default:
+            input += "get " + key + "\r\n";
+        }
+    }
+    return input;
+}
+
+// Processes the input the way connections do, returns number of commands
+std::size_t process(Protocol::Parser &parser, Storage &storage, const std::string &input, bool execute,
+                    std::string &argument, std::string &result) {
+    std::size_t commands = 0;
+    const char *data = input.data();
+    std::size_t left = input.size();
+    while (left > 0) {
+        std::size_t parsed = 0;
+        parser.Parse(data, left, parsed);
+        data += parsed;
+        left -= parsed;
+
+        std::size_t arg_remains;
+        Execute::Command *command = parser.Build(arg_remains);
+        if (arg_remains > 0) {
+            argument.assign(data, arg_remains);
+            data += arg_remains + 2;
+            left -= arg_remains + 2;
+        }
+        if (execute) {
+            command->Execute(storage, argument, result);
+        }
+        argument.resize(0);
+        parser.Reset();
+        commands++;
+    }
+    return commands;
+}
+
+void bench_commands(std::ostream &out, std::size_t count, bool execute) {
+    Backend::SimpleLRU storage(64 * 1024 * 1024);
+    Protocol::Parser parser;
+    std::string input = make_input(count), argument, result;
+
+    // Warm up buffers of the parser and storage, steady state is measured
+    process(parser, storage, input, true, argument, result);
+
+    std::size_t allocs = allocations.load();
+    auto start = bench_clock::now();
+    std::size_t commands = process(parser, storage, input, execute, argument, result);
+    report(out, execute ? "Parse, Build and Execute" : "Parse and Build", commands, allocations.load() - allocs, start);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::size_t count = 1000000;
+    if (argc > 1) {
+        count = std::stoul(argv[1]);
+    }
+
+    std::cout << "Commands: " << count << std::endl;
+    bench_commands(std::cout, count, false);
+    bench_commands(std::cout, count, true);
+    return 0;
+}
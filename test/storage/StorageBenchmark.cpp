@@ -0,0 +1,403 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+
+#include <afina/concurrency/Mutex.h>
+#include <afina/concurrency/SharedMutex.h>
+
+#include "storage/HashIndex.h"
+#include "storage/LockFreeCache.h"
+#include "storage/SimpleLRU.h"
+#include "storage/StripedLRU.h"
+
+using namespace Afina::Backend;
+
+// Storage benchmarks, prints throughput of the different index/storage implementations
+//
+// make runStorageBenchmark && ./test/storage/runStorageBenchmark
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+void report(const std::string &name, std::size_t ops, bench_clock::time_point start) {
+    double seconds = std::chrono::duration<double>(bench_clock::now() - start).count();
+    std::cout << std::left << std::setw(40) << name << std::right << std::setw(12) << std::fixed
+              << std::setprecision(1) << (ops / seconds / 1e6) << " Mops/s" << std::endl;
+}
+
+std::vector<std::string> make_keys(std::size_t count) {
+    std::vector<std::string> keys;
+    keys.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        std::string key = "key:" + std::to_string(i);
+        key.resize(20, '_');
+        keys.push_back(key);
+    }
+    return keys;
+}
+
+// Zipf distributed key numbers: key i is requested with probability proportional to 1 / (i + 1)^s
+class zipf_distribution {
+public:
+    zipf_distribution(std::size_t n, double s) : _cdf(n) {
+        double sum = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            sum += 1.0 / std::pow(i + 1, s);
+            _cdf[i] = sum;
+        }
+        for (auto &c : _cdf) {
+            c /= sum;
+        }
+    }
+
+    template <typename Rnd> std::size_t operator()(Rnd &rnd) {
+        double p = std::uniform_real_distribution<double>(0, 1)(rnd);
+        return std::lower_bound(_cdf.begin(), _cdf.end(), p) - _cdf.begin();
+    }
+
+private:
+    std::vector<double> _cdf;
+};
+
+std::vector<std::size_t> zipf_order(std::size_t keys, std::size_t count, double s, std::uint64_t seed) {
+    std::mt19937_64 rnd(seed);
+    zipf_distribution zipf(keys, s);
+    // Shuffle ranks, so that popular keys are not the first inserted ones
+    std::vector<std::size_t> rank(keys);
+    for (std::size_t i = 0; i < keys; ++i) {
+        rank[i] = i;
+    }
+    std::shuffle(rank.begin(), rank.end(), rnd);
+
+    std::vector<std::size_t> order(count);
+    for (auto &i : order) {
+        i = rank[zipf(rnd)];
+    }
+    return order;
+}
+
+// Cache-aside workload: get, and put on miss. Returns hit ratio
+double hit_ratio(Afina::Storage &storage, const std::vector<std::string> &keys, const std::vector<std::size_t> &order) {
+    std::string value(50, 'v');
+    std::size_t hits = 0;
+    for (auto i : order) {
+        if (storage.Get(keys[i], value)) {
+            hits++;
+        } else {
+            storage.Put(keys[i], value);
+        }
+    }
+    return double(hits) / order.size();
+}
+
+const std::vector<std::pair<SimpleLRU::Policy, std::string>> POLICIES = {
+    {SimpleLRU::Policy::LRU, "lru"},   {SimpleLRU::Policy::CLOCK, "clock"}, {SimpleLRU::Policy::SLRU, "slru"},
+    {SimpleLRU::Policy::TWO_Q, "2q"}, {SimpleLRU::Policy::ARC, "arc"}};
+
+void bench_policies(const std::vector<std::string> &keys) {
+    std::vector<std::size_t> order = zipf_order(keys.size(), 4 * keys.size(), 0.9, 7);
+    // Cache holds 10% of keys
+    std::size_t limit = keys.size() / 10 * SimpleLRU::ItemFootprint(keys[0].size(), 50);
+    for (auto &policy : POLICIES) {
+        SimpleLRU storage(limit, policy.first);
+        auto start = bench_clock::now();
+        double ratio = hit_ratio(storage, keys, order);
+        report("SimpleLRU:" + policy.second + " zipf get/put", order.size(), start);
+        std::cout << "    hit ratio " << std::setprecision(3) << ratio << std::endl;
+    }
+}
+
+// Zipf workload interleaved with one-time scans, hit ratio of the policies with and without admission filter
+void bench_admission(const std::vector<std::string> &keys) {
+    std::size_t hot_keys = keys.size() / 2;
+    std::vector<std::size_t> order = zipf_order(hot_keys, 4 * keys.size(), 0.9, 11);
+    // Every 8th request is a part of scan over the other half of the keys
+    for (std::size_t i = 0, scan = hot_keys; i < order.size(); i += 8) {
+        order[i] = scan;
+        scan = scan + 1 < keys.size() ? scan + 1 : hot_keys;
+    }
+    std::size_t limit = keys.size() / 10 * SimpleLRU::ItemFootprint(keys[0].size(), 50);
+    for (auto &policy : POLICIES) {
+        for (bool admission : {false, true}) {
+            SimpleLRU storage(limit, policy.first, admission);
+            auto start = bench_clock::now();
+            double ratio = hit_ratio(storage, keys, order);
+            report("SimpleLRU:" + policy.second + (admission ? "+tinylfu" : "") + " zipf+scan", order.size(), start);
+            std::cout << "    hit ratio " << std::setprecision(3) << ratio << std::endl;
+        }
+    }
+}
+
+// 95% reads, 5% writes from several threads against striped storage, with and without inline values
+void bench_read_mostly(const std::vector<std::string> &keys, std::size_t n_threads) {
+    for (bool inline_values : {false, true})
+    for (auto policy : {SimpleLRU::Policy::LRU, SimpleLRU::Policy::CLOCK}) {
+        auto storage = StripedLRU::BuildStripedLRU(keys.size() * 1024, 4, policy, false, false, inline_values);
+        std::string value(50, 'v');
+        for (auto &key : keys) {
+            storage->Put(key, value);
+        }
+
+        std::size_t ops_per_thread = keys.size();
+        std::vector<std::thread> threads;
+        auto start = bench_clock::now();
+        for (std::size_t t = 0; t < n_threads; ++t) {
+            threads.emplace_back([&, t]() {
+                std::mt19937_64 rnd(t);
+                std::string out;
+                for (std::size_t n = 0; n < ops_per_thread; ++n) {
+                    const std::string &key = keys[rnd() % keys.size()];
+                    if (n % 20 == 0) {
+                        storage->Put(key, value);
+                    } else {
+                        storage->Get(key, out);
+                    }
+                }
+            });
+        }
+        for (auto &t : threads) {
+            t.join();
+        }
+        std::string name = policy == SimpleLRU::Policy::LRU ? "lru" : "clock";
+        if (inline_values) {
+            name += "+inline";
+        }
+        report("StripedLRU:" + name + " 95% get, " + std::to_string(n_threads) + " threads",
+               ops_per_thread * n_threads, start);
+    }
+}
+
+template <typename Lock> void bench_lock(const std::string &name, std::size_t count, std::size_t n_threads) {
+    Lock lock;
+    std::size_t counter = 0;
+    std::vector<std::thread> threads;
+    auto start = bench_clock::now();
+    for (std::size_t t = 0; t < n_threads; ++t) {
+        threads.emplace_back([&]() {
+            for (std::size_t i = 0; i < count; ++i) {
+                std::lock_guard<Lock> guard(lock);
+                counter++;
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    report(name + " lock/unlock, " + std::to_string(n_threads) + " threads", count * n_threads, start);
+}
+
+// Cost of the lock itself: futex based locks against std::mutex and pthread rwlock
+void bench_locks(std::size_t count) {
+    struct PthreadRWLock {
+        PthreadRWLock() { pthread_rwlock_init(&rwlock, nullptr); }
+        ~PthreadRWLock() { pthread_rwlock_destroy(&rwlock); }
+        void lock() { pthread_rwlock_wrlock(&rwlock); }
+        void unlock() { pthread_rwlock_unlock(&rwlock); }
+        pthread_rwlock_t rwlock;
+    };
+    for (std::size_t threads : {1, 4}) {
+        bench_lock<std::mutex>("std::mutex", count, threads);
+        bench_lock<Afina::Concurrency::Mutex>("Concurrency::Mutex", count, threads);
+        bench_lock<PthreadRWLock>("pthread_rwlock", count, threads);
+        bench_lock<Afina::Concurrency::SharedMutex>("Concurrency::SharedMutex", count, threads);
+    }
+}
+
+// Read-mostly load with Zipf keys, popular keys make stripes contended: stripe locks against flat combining
+// and lock-free reads
+void bench_lockfree(const std::vector<std::string> &keys, std::size_t n_threads) {
+    std::size_t ops_per_thread = keys.size() / n_threads;
+    std::vector<std::vector<std::size_t>> orders;
+    for (std::size_t t = 0; t < n_threads; ++t) {
+        orders.push_back(zipf_order(keys.size(), ops_per_thread, 0.99, t));
+    }
+
+    auto run = [&](Afina::Storage &storage, const std::string &name) {
+        std::string value(50, 'v');
+        for (auto &key : keys) {
+            storage.Put(key, value);
+        }
+        std::vector<std::thread> threads;
+        auto start = bench_clock::now();
+        for (std::size_t t = 0; t < n_threads; ++t) {
+            threads.emplace_back([&, t]() {
+                std::string out;
+                for (std::size_t n = 0; n < ops_per_thread; ++n) {
+                    const std::string &key = keys[orders[t][n]];
+                    if (n % 20 == 0) {
+                        storage.Put(key, value);
+                    } else {
+                        storage.Get(key, out);
+                    }
+                }
+            });
+        }
+        for (auto &t : threads) {
+            t.join();
+        }
+        report(name + " zipf 95% get, " + std::to_string(n_threads) + " threads", ops_per_thread * n_threads,
+               start);
+    };
+
+    auto striped = StripedLRU::BuildStripedLRU(keys.size() * 1024, 4);
+    run(*striped, "StripedLRU");
+    auto combining = StripedLRU::BuildStripedLRU(keys.size() * 1024, 4, SimpleLRU::Policy::LRU, false, true);
+    run(*combining, "StripedLRU+fc");
+    LockFreeCache lockfree(keys.size() * 1024);
+    run(lockfree, "LockFreeCache");
+}
+
+struct node {
+    std::string key;
+    std::uint64_t hash;
+};
+
+struct node_hash {
+    std::uint64_t operator()(const node *n) const { return n->hash; }
+};
+
+// Standard library string hash against the seeded wyhash of Afina::Key
+void bench_hash(const std::vector<std::string> &keys, const std::vector<std::size_t> &order) {
+    std::uint64_t sum = 0;
+    std::hash<std::string> hasher;
+    auto start = bench_clock::now();
+    for (auto i : order) {
+        sum += hasher(keys[i]);
+    }
+    report("std::hash", order.size(), start);
+
+    start = bench_clock::now();
+    for (auto i : order) {
+        sum += Afina::Hash(keys[i]);
+    }
+    report("Afina::Hash", order.size(), start);
+    if (sum == 0) {
+        std::cerr << "Unlikely hash sum" << std::endl;
+    }
+}
+
+// Old std::map index against open addressing one, both index nodes by key
+void bench_index(const std::vector<std::string> &keys, const std::vector<std::size_t> &order) {
+    std::hash<std::string> hasher;
+    std::vector<node> nodes;
+    nodes.reserve(keys.size());
+    for (auto &key : keys) {
+        nodes.push_back(node{key, hasher(key)});
+    }
+
+    std::size_t found = 0;
+    {
+        std::map<std::reference_wrapper<const std::string>, node *, std::less<const std::string>> index;
+        auto start = bench_clock::now();
+        for (auto &n : nodes) {
+            index.emplace(std::cref(n.key), &n);
+        }
+        report("std::map insert", nodes.size(), start);
+
+        start = bench_clock::now();
+        for (auto i : order) {
+            found += index.find(keys[i]) != index.end();
+        }
+        report("std::map lookup", order.size(), start);
+    }
+    {
+        HashIndex<node *, node_hash> index{node_hash()};
+        auto start = bench_clock::now();
+        for (auto &n : nodes) {
+            index.Insert(n.hash, &n);
+        }
+        report("HashIndex insert", nodes.size(), start);
+
+        start = bench_clock::now();
+        for (auto i : order) {
+            const std::string &key = keys[i];
+            found += index.Find(hasher(key), [&key](const node *n) { return n->key == key; }) != nullptr;
+        }
+        report("HashIndex lookup (with hashing)", order.size(), start);
+    }
+    if (found != 2 * order.size()) {
+        std::cerr << "Index lost keys" << std::endl;
+    }
+}
+
+void bench_storage(const std::vector<std::string> &keys, const std::vector<std::size_t> &order) {
+    SimpleLRU storage(keys.size() * 1024);
+    std::string value(50, 'v');
+
+    auto start = bench_clock::now();
+    for (auto &key : keys) {
+        storage.Put(key, value);
+    }
+    report("SimpleLRU Put", keys.size(), start);
+
+    start = bench_clock::now();
+    for (auto i : order) {
+        storage.Get(keys[i], value);
+    }
+    report("SimpleLRU Get", order.size(), start);
+
+    // Multi-get of 100 keys hashed beforehand, as parser does: one by one against interleaved batch
+    const std::size_t batch = 100;
+    std::vector<Afina::Storage::ReadItem> items(batch);
+    start = bench_clock::now();
+    for (std::size_t n = 0; n + batch <= order.size(); n += batch) {
+        for (std::size_t i = 0; i < batch; ++i) {
+            items[i].key = Afina::StoredKey(keys[order[n + i]]);
+        }
+        for (auto &item : items) {
+            item.found = storage.Get(item.key, item.value, &item.flags, &item.cas);
+        }
+    }
+    report("SimpleLRU Get x100", order.size(), start);
+
+    start = bench_clock::now();
+    for (std::size_t n = 0; n + batch <= order.size(); n += batch) {
+        for (std::size_t i = 0; i < batch; ++i) {
+            items[i].key = Afina::StoredKey(keys[order[n + i]]);
+        }
+        storage.GetMany(items);
+    }
+    report("SimpleLRU GetMany x100", order.size(), start);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::size_t count = 1000000;
+    if (argc > 1) {
+        count = std::stoul(argv[1]);
+    }
+
+    std::vector<std::string> keys = make_keys(count);
+    std::vector<std::size_t> order(count);
+    std::mt19937_64 rnd(42);
+    for (auto &i : order) {
+        i = rnd() % count;
+    }
+
+    std::cout << "Keys: " << count << std::endl;
+    bench_hash(keys, order);
+    bench_index(keys, order);
+    bench_storage(keys, order);
+    bench_policies(keys);
+    bench_admission(keys);
+    bench_locks(count * 10);
+    bench_read_mostly(keys, std::max(2u, std::thread::hardware_concurrency()));
+    for (std::size_t threads = 1; threads <= 4 * std::max(2u, std::thread::hardware_concurrency()); threads *= 2) {
+        bench_lockfree(keys, threads);
+    }
+    return 0;
+}
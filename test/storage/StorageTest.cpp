@@ -1,16 +1,39 @@
 #include "gtest/gtest.h"
+#include <chrono>
+#include <ctime>
 #include <iomanip>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <random>
 #include <set>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
+#include <afina/concurrency/ConditionVariable.h>
+#include <afina/concurrency/CoreLocal.h>
+#include <afina/concurrency/Event.h>
+#include <afina/concurrency/FlatCombine.h>
+#include <afina/concurrency/Latch.h>
+#include <afina/concurrency/Mutex.h>
+#include <afina/concurrency/SharedMutex.h>
+#include <afina/concurrency/SlotPool.h>
+#include <afina/concurrency/ThreadLocal.h>
 #include <afina/execute/Add.h>
 #include <afina/execute/Append.h>
 #include <afina/execute/Delete.h>
 #include <afina/execute/Get.h>
 #include <afina/execute/Set.h>
 
+#include "storage/FrequencySketch.h"
+#include "storage/HashIndex.h"
+#include "storage/InlineTable.h"
+#include "storage/LockFreeCache.h"
 #include "storage/SimpleLRU.h"
+#include "storage/StripedLRU.h"
+#include "storage/TimerWheel.h"
+#include "storage/ThreadSafeSimpleLRU.h"
 
 using namespace Afina::Backend;
 using namespace Afina::Execute;
@@ -19,6 +42,12 @@ using namespace std;
 
 
 
+std::string pad_space(const std::string &s, size_t length) {
+    std::string result = s;
+    result.resize(length, ' ');
+    return result;
+}
+
 TEST(StorageTest, PutGet) {
     SimpleLRU storage;
 
@@ -139,15 +168,1400 @@ TEST(StorageTest, DeleteHeadAndTailNode)
     EXPECT_TRUE(storage.Delete("KEY1"));
 }
 
-std::string pad_space(const std::string &s, size_t length) {
-    std::string result = s;
-    result.resize(length, ' ');
-    return result;
+TEST(StorageTest, PutGetFlags) {
+    SimpleLRU storage(1024 * 1024);
+    uint32_t flags = 0;
+    std::string value;
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1", 0xdeadbeef));
+    EXPECT_TRUE(storage.Get("KEY1", value, &flags));
+    EXPECT_EQ(0xdeadbeef, flags);
+
+    // Flags are replaced together with the value, also when node is reallocated
+    EXPECT_TRUE(storage.Set("KEY1", std::string(100, 'v'), 7));
+    EXPECT_TRUE(storage.Get("KEY1", value, &flags));
+    EXPECT_EQ(7, flags);
+
+    EXPECT_FALSE(storage.PutIfAbsent("KEY1", "val2", 8));
+    EXPECT_TRUE(storage.Get("KEY1", value, &flags));
+    EXPECT_EQ(7, flags);
+}
+
+TEST(StorageTest, CompareAndSet) {
+    SimpleLRU storage(1024 * 1024);
+    uint64_t cas1 = 0, cas2 = 0;
+    std::string value;
+
+    EXPECT_EQ(Afina::Storage::Status::NOT_FOUND, storage.CompareAndSet("KEY1", "val1", 0, 0, 0));
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Get("KEY1", value, nullptr, &cas1));
+
+    // Every modification gives a new version
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Get("KEY1", value, nullptr, &cas2));
+    EXPECT_NE(cas1, cas2);
+
+    EXPECT_EQ(Afina::Storage::Status::EXISTS, storage.CompareAndSet("KEY1", "val2", 0, 0, cas1));
+    EXPECT_EQ(Afina::Storage::Status::STORED, storage.CompareAndSet("KEY1", "val3", 5, 0, cas2));
+    EXPECT_EQ(Afina::Storage::Status::EXISTS, storage.CompareAndSet("KEY1", "val4", 0, 0, cas2));
+
+    uint32_t flags = 0;
+    EXPECT_TRUE(storage.Get("KEY1", value, &flags, &cas1));
+    EXPECT_EQ("val3", value);
+    EXPECT_EQ(5, flags);
+    EXPECT_NE(cas1, cas2);
+
+    // Deleted and added again key has new version
+    EXPECT_TRUE(storage.Delete("KEY1"));
+    EXPECT_TRUE(storage.Put("KEY1", "val3"));
+    EXPECT_EQ(Afina::Storage::Status::EXISTS, storage.CompareAndSet("KEY1", "val5", 0, 0, cas1));
+}
+
+// Every store reports the version Get sees after it
+TEST(StorageTest, StoreReturnsCas) {
+    std::vector<std::unique_ptr<Afina::Storage>> storages;
+    storages.emplace_back(new SimpleLRU(1024 * 1024));
+    storages.emplace_back(StripedLRU::BuildStripedLRU(16 * 1024 * 1024UL, 2, SimpleLRU::Policy::LRU, false, true));
+    storages.emplace_back(
+        StripedLRU::BuildStripedLRU(16 * 1024 * 1024UL, 2, SimpleLRU::Policy::LRU, false, false, true));
+    storages.emplace_back(new LockFreeCache());
+
+    const uint32_t later = std::time(nullptr) + 100;
+    for (size_t i = 0; i < storages.size(); ++i) {
+        Afina::Storage &storage = *storages[i];
+        std::string value;
+        uint64_t stored = 0, cas = 0;
+        uint32_t expire = 1;
+
+        EXPECT_TRUE(storage.Put("KEY1", "val1", 0, 0, &stored)) << i;
+        EXPECT_TRUE(storage.Get("KEY1", value, nullptr, &cas, &expire)) << i;
+        EXPECT_EQ(stored, cas) << i;
+        EXPECT_EQ(0, expire) << i;
+
+        EXPECT_TRUE(storage.PutIfAbsent("KEY2", "val2", 0, later, &stored)) << i;
+        EXPECT_TRUE(storage.Get("KEY2", value, nullptr, &cas, &expire)) << i;
+        EXPECT_EQ(stored, cas) << i;
+        EXPECT_EQ(later, expire) << i;
+
+        EXPECT_TRUE(storage.Set("KEY1", "val3", 0, 0, &stored)) << i;
+        EXPECT_NE(cas, stored) << i;
+        EXPECT_TRUE(storage.Append("KEY1", "!", &cas)) << i;
+        EXPECT_NE(stored, cas) << i;
+        EXPECT_TRUE(storage.Prepend("KEY1", "!", &stored)) << i;
+        EXPECT_NE(cas, stored) << i;
+        EXPECT_EQ(Afina::Storage::Status::STORED, storage.CompareAndSet("KEY1", "val4", 0, 0, stored, &stored)) << i;
+        EXPECT_TRUE(storage.Get("KEY1", value, nullptr, &cas)) << i;
+        EXPECT_EQ("val4", value) << i;
+        EXPECT_EQ(stored, cas) << i;
+
+        uint64_t number;
+        EXPECT_TRUE(storage.Put("NUM", "41")) << i;
+        EXPECT_EQ(Afina::Storage::Status::STORED, storage.Incr("NUM", 1, number, &stored)) << i;
+        EXPECT_TRUE(storage.Get("NUM", value, nullptr, &cas)) << i;
+        EXPECT_EQ(stored, cas) << i;
+        EXPECT_EQ(Afina::Storage::Status::STORED, storage.Decr("NUM", 1, number, &stored)) << i;
+        EXPECT_NE(cas, stored) << i;
+        EXPECT_TRUE(storage.Get("NUM", value, nullptr, &cas)) << i;
+        EXPECT_EQ(stored, cas) << i;
+    }
+}
+
+TEST(StorageTest, ConcurrentCompareAndSet) {
+    auto storage = StripedLRU::BuildStripedLRU(16 * 1024 * 1024UL, 4);
+    const int n_threads = 4, increments = 1000;
+    EXPECT_TRUE(storage->Put("counter", "0"));
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < n_threads; ++t) {
+        threads.emplace_back([&storage]() {
+            std::string value;
+            uint64_t cas;
+            for (int i = 0; i < increments;) {
+                ASSERT_TRUE(storage->Get("counter", value, nullptr, &cas));
+                std::string next = std::to_string(std::stoi(value) + 1);
+                if (storage->CompareAndSet("counter", next, 0, 0, cas) == Afina::Storage::Status::STORED) {
+                    i++;
+                }
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    std::string value;
+    EXPECT_TRUE(storage->Get("counter", value));
+    EXPECT_EQ(std::to_string(n_threads * increments), value);
+}
+
+TEST(StorageTest, AppendPrepend) {
+    SimpleLRU storage(1024 * 1024);
+    std::string value;
+    uint32_t flags;
+    uint64_t cas1, cas2;
+
+    EXPECT_FALSE(storage.Append("KEY1", "tail"));
+    EXPECT_FALSE(storage.Prepend("KEY1", "head"));
+    EXPECT_TRUE(storage.Put("KEY1", "body", 7));
+    EXPECT_TRUE(storage.Get("KEY1", value, nullptr, &cas1));
+
+    EXPECT_TRUE(storage.Append("KEY1", "tail"));
+    EXPECT_TRUE(storage.Prepend("KEY1", "head"));
+    EXPECT_TRUE(storage.Get("KEY1", value, &flags, &cas2));
+    EXPECT_EQ("headbodytail", value);
+    EXPECT_EQ(7, flags);
+    EXPECT_NE(cas1, cas2);
+
+    // Value growing by small pieces
+    std::string expected = value;
+    for (int i = 0; i < 1000; ++i) {
+        std::string piece = std::to_string(i);
+        EXPECT_TRUE(storage.Append("KEY1", piece));
+        expected += piece;
+    }
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ(expected, value);
+}
+
+TEST(StorageTest, IncrDecr) {
+    auto storage = StripedLRU::BuildStripedLRU(16 * 1024 * 1024UL, 4);
+    std::string value;
+    uint64_t result;
+
+    EXPECT_EQ(Afina::Storage::Status::NOT_FOUND, storage->Incr("KEY1", 1, result));
+    EXPECT_TRUE(storage->Put("KEY1", "9"));
+    EXPECT_EQ(Afina::Storage::Status::STORED, storage->Incr("KEY1", 1, result));
+    EXPECT_EQ(10, result);
+    EXPECT_TRUE(storage->Get("KEY1", value));
+    EXPECT_EQ("10", value);
+
+    EXPECT_EQ(Afina::Storage::Status::STORED, storage->Decr("KEY1", 3, result));
+    EXPECT_EQ(7, result);
+    EXPECT_EQ(Afina::Storage::Status::STORED, storage->Decr("KEY1", 100, result));
+    EXPECT_EQ(0, result);
+
+    // Increment wraps around
+    EXPECT_TRUE(storage->Put("KEY1", "18446744073709551615"));
+    EXPECT_EQ(Afina::Storage::Status::STORED, storage->Incr("KEY1", 2, result));
+    EXPECT_EQ(1, result);
+    EXPECT_TRUE(storage->Get("KEY1", value));
+    EXPECT_EQ("1", value);
+
+    EXPECT_TRUE(storage->Put("KEY2", "12a"));
+    EXPECT_EQ(Afina::Storage::Status::NOT_STORED, storage->Incr("KEY2", 1, result));
+    EXPECT_TRUE(storage->Put("KEY2", "18446744073709551616"));
+    EXPECT_EQ(Afina::Storage::Status::NOT_STORED, storage->Decr("KEY2", 1, result));
+    EXPECT_TRUE(storage->Put("KEY2", ""));
+    EXPECT_EQ(Afina::Storage::Status::NOT_STORED, storage->Incr("KEY2", 1, result));
+}
+
+TEST(StorageTest, ConcurrentIncr) {
+    auto storage = StripedLRU::BuildStripedLRU(16 * 1024 * 1024UL, 4);
+    const int n_threads = 4, increments = 1000;
+    EXPECT_TRUE(storage->Put("counter", "0"));
+    EXPECT_TRUE(storage->Put("list", ""));
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < n_threads; ++t) {
+        threads.emplace_back([&storage]() {
+            uint64_t result;
+            for (int i = 0; i < increments; ++i) {
+                EXPECT_EQ(Afina::Storage::Status::STORED, storage->Incr("counter", 1, result));
+                EXPECT_TRUE(storage->Append("list", "x"));
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    std::string value;
+    EXPECT_TRUE(storage->Get("counter", value));
+    EXPECT_EQ(std::to_string(n_threads * increments), value);
+    EXPECT_TRUE(storage->Get("list", value));
+    EXPECT_EQ(n_threads * increments, value.size());
+}
+
+TEST(StorageTest, DeleteOnlyNode) {
+    SimpleLRU storage;
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Delete("KEY1"));
+
+    std::string value;
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_TRUE(value == "val2");
+}
+
+TEST(StorageTest, GrowValueEvicts) {
+    const size_t length = 20;
+    SimpleLRU storage(3 * SimpleLRU::ItemFootprint(length, length));
+
+    std::string val(length, 'v');
+    EXPECT_TRUE(storage.Put("KEY1", val));
+    EXPECT_TRUE(storage.Put("KEY2", val));
+    EXPECT_TRUE(storage.Put("KEY3", val));
+
+    // Value doesn't fit into node anymore, so the least recent key has to go
+    EXPECT_TRUE(storage.Set("KEY2", std::string(4 * length, 'w')));
+
+    std::string value;
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_EQ(std::string(4 * length, 'w'), value);
+}
+
+TEST(StorageTest, ClockSecondChance) {
+    const size_t length = 20;
+    SimpleLRU storage(3 * SimpleLRU::ItemFootprint(length, length), SimpleLRU::Policy::CLOCK);
+
+    auto key = [length](int i) { return pad_space("Key " + std::to_string(i), length); };
+    std::string val(length, 'v');
+    EXPECT_TRUE(storage.Put(key(1), val));
+    EXPECT_TRUE(storage.Put(key(2), val));
+    EXPECT_TRUE(storage.Put(key(3), val));
+
+    // KEY1 is the oldest one, but it was referenced, so KEY2 goes away instead
+    std::string value;
+    EXPECT_TRUE(storage.Get(key(1), value));
+    EXPECT_TRUE(storage.Put(key(4), val));
+
+    EXPECT_TRUE(storage.Get(key(1), value));
+    EXPECT_FALSE(storage.Get(key(2), value));
+    EXPECT_TRUE(storage.Get(key(3), value));
+    EXPECT_TRUE(storage.Get(key(4), value));
+}
+
+TEST(StorageTest, ClockConcurrentReaders) {
+    const size_t length = 20;
+    const int count = 1000;
+    auto storage = StripedLRU::BuildStripedLRU(16 * 1024 * 1024UL, 4, SimpleLRU::Policy::CLOCK);
+
+    for (int i = 0; i < count; ++i) {
+        EXPECT_TRUE(storage->Put(pad_space("Key " + std::to_string(i), length), pad_space("Val " + std::to_string(i), length)));
+    }
+
+    std::vector<std::thread> readers;
+    std::vector<int> misses(4, 0);
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&, t]() {
+            std::string res;
+            for (int round = 0; round < 10; ++round) {
+                for (int i = 0; i < count; ++i) {
+                    if (!storage->Get(pad_space("Key " + std::to_string(i), length), res) ||
+                        res != pad_space("Val " + std::to_string(i), length)) {
+                        misses[t]++;
+                    }
+                }
+            }
+        });
+    }
+    // Writer keeps going in parallel on its own keys
+    for (int i = count; i < 2 * count; ++i) {
+        storage->Put(pad_space("Key " + std::to_string(i), length), pad_space("Val " + std::to_string(i), length));
+    }
+    for (auto &t : readers) {
+        t.join();
+    }
+    for (int m : misses) {
+        EXPECT_EQ(0, m);
+    }
+}
+
+TEST(StorageTest, AdmissionKeepsHotKeys) {
+    const size_t length = 20;
+    auto key = [length](const std::string &prefix, int i) { return pad_space(prefix + std::to_string(i), length); };
+    for (bool admission : {false, true}) {
+        SimpleLRU storage(100 * SimpleLRU::ItemFootprint(length, length), SimpleLRU::Policy::LRU, admission);
+        std::string res;
+        for (int i = 0; i < 50; ++i) {
+            EXPECT_TRUE(storage.Put(key("Hot ", i), key("Val ", i)));
+            for (int n = 0; n < 10; ++n) {
+                storage.Get(key("Hot ", i), res);
+            }
+        }
+        // One-time scan over the many cold keys
+        for (int i = 0; i < 1000; ++i) {
+            EXPECT_TRUE(storage.Put(key("Cold ", i), key("Val ", i)));
+        }
+
+        int hot = 0;
+        for (int i = 0; i < 50; ++i) {
+            hot += storage.Get(key("Hot ", i), res);
+        }
+        std::vector<std::pair<std::string, uint64_t>> stats;
+        storage.GetStats(stats);
+        uint64_t rejections = 0;
+        for (auto &stat : stats) {
+            if (stat.first == "admission_rejections") {
+                rejections = stat.second;
+            }
+        }
+        if (admission) {
+            EXPECT_GE(hot, 45);
+            EXPECT_GT(rejections, 0u);
+        } else {
+            EXPECT_EQ(0, hot);
+            EXPECT_EQ(0u, rejections);
+        }
+    }
+}
+
+TEST(StorageTest, StripedStatsSum) {
+    auto storage = StripedLRU::BuildStripedLRU(16 * 1024 * 1024UL, 4);
+    std::string res;
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_TRUE(storage->Put("Key " + std::to_string(i), "Val"));
+        EXPECT_TRUE(storage->Get("Key " + std::to_string(i), res));
+        EXPECT_FALSE(storage->Get("None " + std::to_string(i), res));
+    }
+    std::vector<std::pair<std::string, uint64_t>> stats;
+    storage->GetStats(stats);
+    std::map<std::string, uint64_t> by_name(stats.begin(), stats.end());
+    EXPECT_EQ(100u, by_name["get_hits"]);
+    EXPECT_EQ(100u, by_name["get_misses"]);
+    EXPECT_EQ(100u, by_name["curr_items"]);
+    EXPECT_EQ(16 * 1024 * 1024UL, by_name["limit_maxbytes"]);
+}
+
+TEST(StorageTest, StripedSkewedKeys) {
+    const size_t memory = 4 * 1024 * 1024UL, stripes = 4, length = 100;
+    auto storage = StripedLRU::BuildStripedLRU(memory, stripes);
+    std::hash<std::string> hash;
+    auto bytes = [&storage]() {
+        std::vector<std::pair<std::string, uint64_t>> stats;
+        storage->GetStats(stats);
+        return std::map<std::string, uint64_t>(stats.begin(), stats.end())["bytes"];
+    };
+
+    // All keys go to the first stripe, it could take the whole memory
+    std::vector<std::string> keys;
+    for (size_t i = 0; keys.size() < 2 * memory / SimpleLRU::ItemFootprint(length, length); ++i) {
+        std::string key = pad_space("Key " + std::to_string(i), length);
+        if (hash(key) % stripes == 0) {
+            keys.push_back(key);
+            EXPECT_TRUE(storage->Put(key, pad_space("Val", length)));
+        }
+    }
+    EXPECT_LE(bytes(), memory);
+    EXPECT_GE(bytes(), memory - SimpleLRU::ItemFootprint(length, length));
+
+    // Other stripe makes it give memory back
+    std::string res;
+    for (size_t i = 0; i < 100; ++i) {
+        std::string key = pad_space("Other " + std::to_string(i), length);
+        if (hash(key) % stripes != 0) {
+            EXPECT_TRUE(storage->Put(key, pad_space("Val", length)));
+            EXPECT_TRUE(storage->Get(key, res));
+        }
+    }
+    EXPECT_LE(bytes(), memory);
+    EXPECT_FALSE(storage->Get(keys[0], res));
+    EXPECT_TRUE(storage->Get(keys.back(), res));
+}
+
+TEST(StorageTest, StripedMaintainerKeepsHeadroom) {
+    const size_t memory = 4 * 1024 * 1024UL, length = 100;
+    auto storage = StripedLRU::BuildStripedLRU(memory, 4);
+    auto stats = [&storage]() {
+        std::vector<std::pair<std::string, uint64_t>> stats;
+        storage->GetStats(stats);
+        return std::map<std::string, uint64_t>(stats.begin(), stats.end());
+    };
+    storage->Start();
+
+    const size_t items = memory / SimpleLRU::ItemFootprint(length, length);
+    for (size_t i = 0; i < 2 * items; ++i) {
+        EXPECT_TRUE(storage->Put(pad_space("Key " + std::to_string(i), length), pad_space("Val", length)));
+    }
+    // Maintainer gets usage down to the low watermark
+    for (int i = 0; i < 100 && stats()["bytes"] > memory / 100 * 90; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_LE(stats()["bytes"], memory / 100 * 90);
+    EXPECT_GE(stats()["evictions"], items);
+
+    storage->Stop();
+    std::string res;
+    EXPECT_TRUE(storage->Get(pad_space("Key " + std::to_string(2 * items - 1), length), res));
+}
+
+TEST(StorageTest, StripedSmallMemory) {
+    // Many stripes for a small memory limit
+    auto storage = StripedLRU::BuildStripedLRU(1024 * 1024UL, 64);
+    std::string res;
+    EXPECT_TRUE(storage->Put("KEY1", std::string(512 * 1024, 'x')));
+    EXPECT_TRUE(storage->Get("KEY1", res));
+    EXPECT_EQ(512 * 1024, res.size());
+    EXPECT_THROW(StripedLRU::BuildStripedLRU(1024 * 1024UL, 0), std::runtime_error);
+}
+
+TEST(StorageTest, StripedBatch) {
+    auto storage = StripedLRU::BuildStripedLRU(16 * 1024 * 1024UL, 4);
+    std::vector<std::string> keys, values;
+    for (int i = 0; i < 100; ++i) {
+        keys.push_back("Key " + std::to_string(i));
+        values.push_back("Val " + std::to_string(i));
+    }
+    // The last of the same key items wins
+    keys.push_back("Key 0");
+    values.push_back("Last");
+
+    std::vector<Afina::Storage::WriteItem> writes(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        writes[i] = {Afina::StoredKey(keys[i]), &values[i], uint32_t(i), 0, false};
+    }
+    storage->PutMany(writes);
+    for (auto &item : writes) {
+        EXPECT_TRUE(item.stored);
+    }
+
+    std::string none = "None";
+    keys.push_back(none);
+    std::vector<Afina::Storage::ReadItem> reads(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        reads[i].key = Afina::StoredKey(keys[i]);
+    }
+    storage->GetMany(reads);
+    for (size_t i = 1; i < 100; ++i) {
+        EXPECT_TRUE(reads[i].found);
+        EXPECT_EQ(values[i], reads[i].value);
+        EXPECT_EQ(i, reads[i].flags);
+    }
+    EXPECT_TRUE(reads[0].found);
+    EXPECT_EQ("Last", reads[0].value);
+    EXPECT_EQ(100u, reads[0].flags);
+    EXPECT_EQ(reads[0].cas, reads[100].cas);
+    EXPECT_FALSE(reads[101].found);
+}
+
+TEST(StorageTest, StripedCombining) {
+    auto storage = StripedLRU::BuildStripedLRU(16 * 1024 * 1024UL, 2, SimpleLRU::Policy::LRU, false, true);
+    const int n_threads = 4, increments = 1000;
+    EXPECT_TRUE(storage->Put("counter", "0"));
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < n_threads; ++t) {
+        threads.emplace_back([&storage, t]() {
+            uint64_t number;
+            std::string value;
+            for (int i = 0; i < increments; ++i) {
+                EXPECT_EQ(Afina::Storage::Status::STORED, storage->Incr("counter", 1, number));
+                std::string key = "Key " + std::to_string(t) + " " + std::to_string(i);
+                EXPECT_TRUE(storage->Put(key, key));
+                EXPECT_TRUE(storage->Get(key, value));
+                EXPECT_EQ(key, value);
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    std::string value;
+    EXPECT_TRUE(storage->Get("counter", value));
+    EXPECT_EQ(std::to_string(n_threads * increments), value);
+    std::vector<std::pair<std::string, uint64_t>> stats;
+    storage->GetStats(stats);
+    std::map<std::string, uint64_t> by_name(stats.begin(), stats.end());
+    EXPECT_EQ(n_threads * increments + 1, by_name["curr_items"]);
+}
+
+TEST(StorageTest, BatchLookups) {
+    // Batches span several prefetch groups, have misses and repeated keys, and stripes get items selectively
+    SimpleLRU simple(16 * 1024 * 1024UL);
+    auto striped = StripedLRU::BuildStripedLRU(16 * 1024 * 1024UL, 4);
+    for (Afina::Storage *storage : {static_cast<Afina::Storage *>(&simple), static_cast<Afina::Storage *>(striped.get())}) {
+        for (int i = 0; i < 2000; i += 2) {
+            EXPECT_TRUE(storage->Put("Key " + std::to_string(i), "Val " + std::to_string(i), i));
+        }
+        std::vector<std::string> keys;
+        for (int i = 0; i < 300; ++i) {
+            keys.push_back("Key " + std::to_string(i * 7 % 500));
+        }
+        std::vector<Afina::Storage::ReadItem> items(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i) {
+            items[i].key = Afina::StoredKey(keys[i]);
+        }
+        storage->GetMany(items);
+        for (size_t i = 0; i < keys.size(); ++i) {
+            std::string value;
+            uint32_t flags;
+            ASSERT_EQ(storage->Get(keys[i], value, &flags), items[i].found) << keys[i];
+            if (items[i].found) {
+                EXPECT_EQ(value, items[i].value);
+                EXPECT_EQ(flags, items[i].flags);
+            }
+        }
+    }
+}
+
+TEST(StorageTest, LockFreeOperations) {
+    LockFreeCache storage;
+    std::string value;
+    uint32_t flags;
+    uint64_t cas, number;
+
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_TRUE(storage.Put("Key " + std::to_string(i), "Val " + std::to_string(i), i));
+    }
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_TRUE(storage.Get("Key " + std::to_string(i), value, &flags, &cas));
+        EXPECT_EQ("Val " + std::to_string(i), value);
+        EXPECT_EQ(i, flags);
+    }
+    EXPECT_FALSE(storage.PutIfAbsent("Key 1", "none"));
+    EXPECT_FALSE(storage.Set("None", "none"));
+    EXPECT_TRUE(storage.Set("Key 1", "1"));
+    EXPECT_EQ(Afina::Storage::Status::STORED, storage.Incr("Key 1", 41, number));
+    EXPECT_EQ(42, number);
+    EXPECT_EQ(Afina::Storage::Status::NOT_STORED, storage.Incr("Key 3", 1, number));
+    EXPECT_TRUE(storage.Append("Key 1", "!"));
+    EXPECT_TRUE(storage.Prepend("Key 1", "="));
+    EXPECT_TRUE(storage.Get("Key 1", value, &flags, &cas));
+    EXPECT_EQ("=42!", value);
+    EXPECT_EQ(Afina::Storage::Status::EXISTS, storage.CompareAndSet("Key 1", "no", 0, 0, cas + 1));
+    EXPECT_EQ(Afina::Storage::Status::STORED, storage.CompareAndSet("Key 1", "yes", 0, 0, cas));
+    EXPECT_TRUE(storage.Delete("Key 2"));
+    EXPECT_FALSE(storage.Delete("Key 2"));
+    EXPECT_FALSE(storage.Get("Key 2", value));
+
+    std::vector<std::pair<std::string, uint64_t>> stats;
+    storage.GetStats(stats);
+    std::map<std::string, uint64_t> by_name(stats.begin(), stats.end());
+    EXPECT_EQ(99u, by_name["curr_items"]);
+}
+
+TEST(StorageTest, LockFreeKeepsLimit) {
+    const size_t limit = 64 * 1024;
+    LockFreeCache storage(limit);
+    std::string value(100, 'v');
+    for (int i = 0; i < 10000; ++i) {
+        EXPECT_TRUE(storage.Put("Key " + std::to_string(i), value));
+    }
+
+    std::vector<std::pair<std::string, uint64_t>> stats;
+    storage.GetStats(stats);
+    std::map<std::string, uint64_t> by_name(stats.begin(), stats.end());
+    EXPECT_LE(by_name["bytes"], limit);
+    EXPECT_GT(by_name["evictions"], 0u);
+    EXPECT_TRUE(storage.Get("Key 9999", value));
+}
+
+TEST(StorageTest, LockFreeGrowsTable) {
+    LockFreeCache storage(64 * 1024 * 1024);
+    auto stats = [&storage]() {
+        std::vector<std::pair<std::string, uint64_t>> stats;
+        storage.GetStats(stats);
+        return std::map<std::string, uint64_t>(stats.begin(), stats.end());
+    };
+    uint64_t power = stats()["hash_power_level"];
+
+    // Keys stay reachable while their buckets are moved to the bigger table
+    const int count = 20000;
+    for (int i = 0; i < count; ++i) {
+        ASSERT_TRUE(storage.Put("Key " + std::to_string(i), "Val " + std::to_string(i)));
+        if (i % 1000 == 0) {
+            std::string value;
+            for (int j = 0; j <= i; j += 97) {
+                ASSERT_TRUE(storage.Get("Key " + std::to_string(j), value));
+                EXPECT_EQ("Val " + std::to_string(j), value);
+            }
+        }
+    }
+    auto after = stats();
+    EXPECT_LT(power, after["hash_power_level"]);
+    EXPECT_EQ(count, after["curr_items"]);
+    EXPECT_EQ(0u, after["evictions"]);
+    for (int i = 0; i < count; ++i) {
+        std::string value;
+        ASSERT_TRUE(storage.Get("Key " + std::to_string(i), value));
+        EXPECT_EQ("Val " + std::to_string(i), value);
+    }
+}
+
+TEST(StorageTest, LockFreeConcurrent) {
+    LockFreeCache storage(256 * 1024);
+    const int n_threads = 4, rounds = 5000;
+    EXPECT_TRUE(storage.Put("counter", "0"));
+
+    // Readers check values are never torn while writers replace and evict them
+    std::vector<std::thread> threads;
+    for (int t = 0; t < n_threads; ++t) {
+        threads.emplace_back([&storage, t]() {
+            uint64_t number;
+            std::string value;
+            for (int i = 0; i < rounds; ++i) {
+                std::string key = "Key " + std::to_string(i % 500);
+                if (t % 2 == 0) {
+                    EXPECT_EQ(Afina::Storage::Status::STORED, storage.Incr("counter", 1, number));
+                    storage.Put(key, key + std::string(i % 100, '.'));
+                } else if (storage.Get(key, value)) {
+                    EXPECT_EQ(0u, value.find(key));
+                }
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("counter", value));
+    EXPECT_EQ(std::to_string((n_threads / 2) * rounds), value);
+}
+
+TEST(InlineTest, MirrorsWrites) {
+    ThreadSafeSimplLRU storage(1024 * 1024, SimpleLRU::Policy::LRU, false, nullptr, true);
+    ASSERT_TRUE(storage.InlineValues());
+    std::string value;
+    uint32_t flags;
+    uint64_t cas, number;
+
+    EXPECT_TRUE(storage.Put("flag", "on", 7));
+    EXPECT_TRUE(storage.Get("flag", value, &flags, &cas));
+    EXPECT_EQ("on", value);
+    EXPECT_EQ(7, flags);
+
+    // Every modification reaches the copy readers take without lock
+    EXPECT_TRUE(storage.Append("flag", "ly"));
+    EXPECT_TRUE(storage.Get("flag", value, nullptr, &number));
+    EXPECT_EQ("only", value);
+    EXPECT_NE(cas, number);
+    EXPECT_TRUE(storage.Put("count", "41"));
+    EXPECT_EQ(Afina::Storage::Status::STORED, storage.Incr("count", 1, number));
+    EXPECT_TRUE(storage.Get("count", value));
+    EXPECT_EQ("42", value);
+
+    // Values above the inline limit are served by the cache
+    std::string big(InlineTable::INLINE_LIMIT, 'b');
+    EXPECT_TRUE(storage.Put("flag", big));
+    EXPECT_TRUE(storage.Get("flag", value));
+    EXPECT_EQ(big, value);
+    EXPECT_TRUE(storage.Set("flag", "off"));
+    EXPECT_TRUE(storage.Get("flag", value));
+    EXPECT_EQ("off", value);
+
+    EXPECT_TRUE(storage.Delete("flag"));
+    EXPECT_FALSE(storage.Get("flag", value));
+
+    std::vector<std::string> keys = {"count", "flag", "none"};
+    std::vector<Afina::Storage::ReadItem> items(keys.size());
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        items[i].key = Afina::StoredKey(keys[i]);
+    }
+    storage.GetMany(items);
+    EXPECT_TRUE(items[0].found);
+    EXPECT_EQ("42", items[0].value);
+    EXPECT_FALSE(items[1].found);
+    EXPECT_FALSE(items[2].found);
+}
+
+TEST(InlineTest, KeepsRecency) {
+    const size_t length = 20;
+    ThreadSafeSimplLRU storage(1024 * 1024, SimpleLRU::Policy::LRU, false, nullptr, true);
+    EXPECT_TRUE(storage.Put("hot", "value"));
+
+    // Hot key is read only from the inline table, still cache doesn't evict it as the least recent one.
+    // Other values don't fit into the table, so they never take the hot key slot
+    std::string value;
+    std::string other(InlineTable::INLINE_LIMIT, 'v');
+    const int count = 1024 * 1024 / SimpleLRU::ItemFootprint(length, other.size()) * 2;
+    for (int i = 0; i < count; ++i) {
+        EXPECT_TRUE(storage.Put(pad_space("Key " + std::to_string(i), length), other));
+        EXPECT_TRUE(storage.Get("hot", value));
+    }
+    EXPECT_EQ("value", value);
+    EXPECT_FALSE(storage.Get(pad_space("Key 0", length), value));
+
+    std::vector<std::pair<std::string, uint64_t>> stats;
+    storage.GetStats(stats);
+    std::map<std::string, uint64_t> items(stats.begin(), stats.end());
+    EXPECT_EQ(count, items["get_hits"]);
+    EXPECT_EQ(1, items["get_misses"]);
+}
+
+TEST(InlineTest, ConcurrentReadersSeeWholeValues) {
+    auto storage = StripedLRU::BuildStripedLRU(4 * 1024 * 1024, 4, SimpleLRU::Policy::CLOCK, false, false, true);
+    const int n_threads = 4, rounds = 20000;
+
+    // Writers fill value with one letter and put the same letter into flags, readers check copy is never torn
+    std::vector<std::thread> threads;
+    for (int t = 0; t < n_threads; ++t) {
+        threads.emplace_back([&storage, t]() {
+            std::string value;
+            uint32_t flags;
+            for (int i = 0; i < rounds; ++i) {
+                std::string key = "Key " + std::to_string(i % 8);
+                if (t % 2 == 0) {
+                    char letter = 'a' + (i + t) % 26;
+                    storage->Put(key, std::string(8 + i % 64, letter), letter);
+                } else if (storage->Get(key, value, &flags)) {
+                    EXPECT_EQ(std::string(value.size(), char(flags)), value);
+                }
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+}
+
+TEST(FlatCombineTest, BatchesOperations) {
+    struct Op {
+        int add;
+        long result;
+    };
+    long sum = 0;
+    std::size_t batches = 0, ops = 0;
+    // Client limit is below the number of threads, so some of them take the lock alone
+    Afina::Concurrency::FlatCombine<Op> combiner(
+        [&](Op *const *batch, std::size_t count) {
+            batches++;
+            for (std::size_t i = 0; i < count; ++i) {
+                sum += batch[i]->add;
+                batch[i]->result = sum;
+                ops++;
+            }
+        },
+        4);
+
+    const int n_threads = 6, rounds = 10000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < n_threads; ++t) {
+        threads.emplace_back([&combiner]() {
+            long last = 0;
+            for (int i = 0; i < rounds; ++i) {
+                Op op{1, 0};
+                combiner.Execute(op);
+                EXPECT_LT(last, op.result);
+                last = op.result;
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(n_threads * rounds, sum);
+    EXPECT_EQ(n_threads * rounds, ops);
+    EXPECT_LE(batches, ops);
+}
+
+TEST(FlatCombineTest, ThrowingBatchReleasesWaiters) {
+    struct Op {
+        bool fail;
+    };
+    long done = 0;
+    Afina::Concurrency::FlatCombine<Op> combiner(
+        [&done](Op *const *batch, std::size_t count) {
+            for (std::size_t i = 0; i < count; ++i) {
+                if (batch[i]->fail) {
+                    throw std::runtime_error("failed op");
+                }
+                done++;
+            }
+        },
+        2);
+
+    // Threads come and go, far more of them than records, some ops throw: nobody hangs and lock is free after
+    const int n_threads = 3, rounds = 100;
+    long thrown = 0;
+    std::mutex thrown_lock;
+    for (int round = 0; round < rounds; ++round) {
+        std::vector<std::thread> threads;
+        for (int t = 0; t < n_threads; ++t) {
+            threads.emplace_back([&combiner, &thrown, &thrown_lock, t]() {
+                Op op{t == 0};
+                try {
+                    combiner.Execute(op);
+                } catch (const std::runtime_error &) {
+                    std::lock_guard<std::mutex> lock(thrown_lock);
+                    thrown++;
+                }
+            });
+        }
+        for (auto &t : threads) {
+            t.join();
+        }
+    }
+    // Failing op always throws, ops batched together with it throw as well, even if they are done
+    EXPECT_GE(thrown, rounds);
+    EXPECT_GE(thrown + done, n_threads * rounds);
+    long before = done;
+    Op op{false};
+    combiner.Execute(op);
+    EXPECT_EQ(before + 1, done);
+}
+
+TEST(FlatCombineTest, SlowBatchParksWaiters) {
+    struct Op {
+        int add;
+    };
+    long sum = 0;
+    // Batch takes far longer than the waiters spin, so they park and must be woken to finish or to combine
+    Afina::Concurrency::FlatCombine<Op> combiner(
+        [&sum](Op *const *batch, std::size_t count) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            for (std::size_t i = 0; i < count; ++i) {
+                sum += batch[i]->add;
+            }
+        },
+        4);
+
+    const int n_threads = 4, rounds = 200;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < n_threads; ++t) {
+        threads.emplace_back([&combiner]() {
+            for (int i = 0; i < rounds; ++i) {
+                Op op{1};
+                combiner.Execute(op);
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(n_threads * rounds, sum);
+}
+
+TEST(ThreadLocalTest, SlotsPerThread) {
+    Afina::Concurrency::ThreadLocal<std::atomic<uint64_t>> counters;
+    auto sum = [&counters]() {
+        uint64_t result = 0;
+        counters.ForEach([&result](const std::atomic<uint64_t> &slot) { result += slot.load(); });
+        return result;
+    };
+
+    std::atomic<uint64_t> *first = &counters.Get();
+    for (int round = 0; round < 3; ++round) {
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&counters, first]() {
+                auto &slot = counters.Get();
+                EXPECT_NE(first, &slot);
+                EXPECT_EQ(&slot, &counters.Get());
+                for (int i = 0; i < 1000; ++i) {
+                    slot.store(slot.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                }
+            });
+        }
+        for (auto &t : threads) {
+            t.join();
+        }
+    }
+    EXPECT_EQ(&counters.Get(), first);
+    // Values of exited threads stay, their slots are reused
+    EXPECT_EQ(12000u, sum());
+    size_t slots = 0;
+    counters.ForEach([&slots](const std::atomic<uint64_t> &) { slots++; });
+    EXPECT_LE(slots, 5u);
+}
+
+TEST(SlotPoolTest, ReusesSlotsOfExitedThreads) {
+    Afina::Concurrency::SlotPool pool(4);
+    const std::size_t no_slot = Afina::Concurrency::SlotPool::NO_SLOT;
+
+    std::size_t first = pool.Get();
+    EXPECT_EQ(0u, first);
+    EXPECT_EQ(first, pool.Get());
+    for (int i = 0; i < 100; ++i) {
+        std::thread([&pool, no_slot]() {
+            std::size_t slot = pool.Get();
+            EXPECT_NE(no_slot, slot);
+            EXPECT_EQ(slot, pool.Get());
+            EXPECT_TRUE(pool.InUse(slot));
+        }).join();
+    }
+    // Index of the exited thread is free and handed to the next one, so the bound doesn't grow
+    EXPECT_EQ(2u, pool.Bound());
+    EXPECT_FALSE(pool.InUse(1));
+
+    // Threads above the capacity get no slot until some other thread exits
+    std::vector<std::thread> threads;
+    Afina::Concurrency::Latch started(3), finish(1);
+    for (int t = 0; t < 3; ++t) {
+        threads.emplace_back([&pool, &started, &finish, no_slot]() {
+            EXPECT_NE(no_slot, pool.Get());
+            started.CountDown();
+            finish.Wait();
+        });
+    }
+    started.Wait();
+    EXPECT_EQ(4u, pool.Bound());
+    std::thread([&pool, no_slot]() { EXPECT_EQ(no_slot, pool.Get()); }).join();
+    finish.CountDown();
+    for (auto &t : threads) {
+        t.join();
+    }
+    std::thread([&pool, no_slot]() { EXPECT_NE(no_slot, pool.Get()); }).join();
+}
+
+TEST(CoreLocalTest, SumsAllCores) {
+    Afina::Concurrency::CoreLocal<std::atomic<uint64_t>> counters;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&counters]() {
+            for (int i = 0; i < 1000; ++i) {
+                counters.Get().fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    uint64_t sum = 0;
+    counters.ForEach([&sum](const std::atomic<uint64_t> &slot) { sum += slot.load(); });
+    EXPECT_EQ(4000u, sum);
+}
+
+TEST(FutexTest, MutexExcludes) {
+    Afina::Concurrency::Mutex mutex;
+    long counter = 0;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&mutex, &counter]() {
+            for (int i = 0; i < 20000; ++i) {
+                std::lock_guard<Afina::Concurrency::Mutex> lock(mutex);
+                counter++;
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(80000, counter);
+    EXPECT_TRUE(mutex.try_lock());
+    EXPECT_FALSE(mutex.try_lock());
+    mutex.unlock();
+}
+
+TEST(FutexTest, SharedMutexPrefersWriters) {
+    Afina::Concurrency::SharedMutex mutex;
+    mutex.lock_shared();
+    EXPECT_TRUE(mutex.try_lock_shared());
+    EXPECT_FALSE(mutex.try_lock());
+    mutex.unlock_shared();
+
+    // Waiting writer blocks new readers, and gets the lock once the last reader leaves
+    std::atomic<bool> written(false);
+    std::thread writer([&mutex, &written]() {
+        std::lock_guard<Afina::Concurrency::SharedMutex> lock(mutex);
+        written = true;
+    });
+    while (mutex.try_lock_shared()) {
+        mutex.unlock_shared();
+        std::this_thread::yield();
+    }
+    EXPECT_FALSE(written);
+    mutex.unlock_shared();
+    writer.join();
+    EXPECT_TRUE(written);
+
+    long counter = 0, sum = 0;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&mutex, &counter, &sum, t]() {
+            for (int i = 0; i < 10000; ++i) {
+                if (t % 2 == 0) {
+                    std::lock_guard<Afina::Concurrency::SharedMutex> lock(mutex);
+                    counter++;
+                } else {
+                    Afina::Concurrency::SharedLockGuard<Afina::Concurrency::SharedMutex> lock(mutex);
+                    EXPECT_LE(counter, 20000);
+                }
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(20000, counter);
+}
+
+TEST(FutexTest, LatchAndEvent) {
+    Afina::Concurrency::Latch started(4);
+    Afina::Concurrency::Event go;
+    std::atomic<int> finished(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&]() {
+            started.CountDown();
+            go.Wait();
+            finished++;
+        });
+    }
+    started.Wait();
+    EXPECT_TRUE(started.TryWait());
+    EXPECT_EQ(0, finished);
+    EXPECT_FALSE(go.WaitFor(std::chrono::milliseconds(10)));
+    go.Set();
+    for (auto &t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(4, finished);
+    EXPECT_TRUE(go.WaitFor(std::chrono::milliseconds(0)));
+    go.Reset();
+    EXPECT_FALSE(go.IsSet());
+}
+
+TEST(FutexTest, ConditionVariable) {
+    Afina::Concurrency::Mutex mutex;
+    Afina::Concurrency::ConditionVariable cv;
+    int produced = 0, consumed = 0;
+    std::thread consumer([&]() {
+        std::unique_lock<Afina::Concurrency::Mutex> lock(mutex);
+        while (consumed < 1000) {
+            while (produced == consumed) {
+                cv.wait(lock);
+            }
+            consumed++;
+        }
+    });
+    for (int i = 0; i < 1000; ++i) {
+        std::lock_guard<Afina::Concurrency::Mutex> lock(mutex);
+        produced++;
+        cv.notify_one();
+    }
+    consumer.join();
+    EXPECT_EQ(1000, consumed);
+
+    std::unique_lock<Afina::Concurrency::Mutex> lock(mutex);
+    auto deadline = std::chrono::system_clock::now() + std::chrono::milliseconds(10);
+    while (cv.wait_until(lock, deadline) != std::cv_status::timeout) {
+    }
+    EXPECT_GE(std::chrono::system_clock::now(), deadline);
+}
+
+TEST(FrequencySketchTest, CountsAndAges) {
+    FrequencySketch sketch(1024);
+    for (int i = 0; i < 10; ++i) {
+        sketch.Increment(42);
+    }
+    EXPECT_EQ(10u, sketch.Frequency(42));
+    EXPECT_EQ(0u, sketch.Frequency(43));
+    for (int i = 0; i < 10; ++i) {
+        sketch.Increment(42);
+    }
+    // Counters saturate
+    EXPECT_EQ(15u, sketch.Frequency(42));
+
+    // Lots of other keys make counters to be halved
+    for (uint64_t i = 0; i < 20 * 1024; ++i) {
+        sketch.Increment(1000 + i);
+    }
+    EXPECT_LT(sketch.Frequency(42), 15u);
+}
+
+const std::vector<SimpleLRU::Policy> ALL_POLICIES = {SimpleLRU::Policy::LRU, SimpleLRU::Policy::CLOCK,
+                                                     SimpleLRU::Policy::SLRU, SimpleLRU::Policy::TWO_Q,
+                                                     SimpleLRU::Policy::ARC};
+
+TEST(PolicyTest, KeepsLimit) {
+    const size_t length = 20;
+    for (auto policy : ALL_POLICIES) {
+        for (bool admission : {false, true}) {
+            size_t limit = 1000 * SimpleLRU::ItemFootprint(length, length);
+            SimpleLRU storage(limit, policy, admission);
+            std::string res;
+            for (long i = 0; i < 5000; ++i) {
+                auto key = pad_space("Key " + std::to_string(i % 1500), length);
+                auto val = pad_space("Val " + std::to_string(i), length);
+                EXPECT_TRUE(storage.Put(key, val));
+                EXPECT_TRUE(storage.Get(key, res));
+                EXPECT_EQ(val, res);
+                if (i % 7 == 0) {
+                    storage.Delete(pad_space("Key " + std::to_string((i + 500) % 1500), length));
+                }
+                // Values of the different size make nodes reallocate
+                if (i % 11 == 0) {
+                    EXPECT_TRUE(storage.Set(key, pad_space(val, 3 * length)));
+                }
+            }
+
+            std::vector<std::pair<std::string, uint64_t>> stats;
+            storage.GetStats(stats);
+            std::map<std::string, uint64_t> by_name(stats.begin(), stats.end());
+            EXPECT_LE(by_name["bytes"], limit);
+            EXPECT_GT(by_name["curr_items"], 700u);
+            EXPECT_GT(by_name["evictions"], 0u);
+        }
+    }
+}
+
+TEST(PolicyTest, ScanResistance) {
+    const size_t length = 20;
+    auto key = [length](const std::string &prefix, int i) { return pad_space(prefix + std::to_string(i), length); };
+    for (auto policy : {SimpleLRU::Policy::SLRU, SimpleLRU::Policy::TWO_Q, SimpleLRU::Policy::ARC}) {
+        SimpleLRU storage(100 * SimpleLRU::ItemFootprint(length, length), policy);
+        std::string res;
+        for (int i = 0; i < 50; ++i) {
+            storage.Put(key("Hot ", i), key("Val ", i));
+            storage.Get(key("Hot ", i), res);
+        }
+        for (int i = 0; i < 100; ++i) {
+            EXPECT_TRUE(storage.Put(key("Warm ", i), key("Val ", i)));
+        }
+        // 2Q takes key as hot only if it comes back after being evicted from the FIFO
+        for (int i = 0; i < 50; ++i) {
+            storage.Put(key("Hot ", i), key("Val ", i));
+            storage.Get(key("Hot ", i), res);
+        }
+
+        // One-time scan over the many cold keys
+        for (int i = 0; i < 1000; ++i) {
+            EXPECT_TRUE(storage.Put(key("Cold ", i), key("Val ", i)));
+        }
+        int hot = 0;
+        for (int i = 0; i < 50; ++i) {
+            hot += storage.Get(key("Hot ", i), res);
+        }
+        EXPECT_GE(hot, 40) << "policy " << int(policy);
+    }
+}
+
+// SimpleLRU with the clock moved by test
+class ManualClockLRU : public SimpleLRU {
+public:
+    ManualClockLRU(size_t max_size) : SimpleLRU(max_size), now(std::time(nullptr)) {}
+
+    uint32_t now;
+
+protected:
+    uint32_t _clock() const override { return now; }
+};
+
+TEST(ExpireTest, AppendKeepsExpire) {
+    ManualClockLRU storage(1024 * 1024);
+    std::string res;
+    uint64_t result;
+    EXPECT_TRUE(storage.Put("KEY1", "val1", 0, storage.now + 10));
+    EXPECT_TRUE(storage.Put("KEY2", "1", 0, storage.now + 10));
+    EXPECT_TRUE(storage.Append("KEY1", "tail"));
+    EXPECT_EQ(Afina::Storage::Status::STORED, storage.Incr("KEY2", 1, result));
+
+    storage.now += 10;
+    EXPECT_FALSE(storage.Get("KEY1", res));
+    EXPECT_EQ(Afina::Storage::Status::NOT_FOUND, storage.Incr("KEY2", 1, result));
+}
+
+TEST(ExpireTest, GetSkipsExpired) {
+    ManualClockLRU storage(1024 * 1024);
+    std::string res;
+    EXPECT_TRUE(storage.Put("KEY1", "val1", 0, storage.now + 10));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_TRUE(storage.Get("KEY1", res));
+
+    storage.now += 10;
+    EXPECT_FALSE(storage.Get("KEY1", res));
+    EXPECT_TRUE(storage.Get("KEY2", res));
+
+    // Expired key is absent for writers as well
+    EXPECT_FALSE(storage.Append("KEY1", "val1"));
+    EXPECT_FALSE(storage.Set("KEY1", "val1"));
+    EXPECT_TRUE(storage.PutIfAbsent("KEY1", "val1"));
+    EXPECT_TRUE(storage.Get("KEY1", res));
+    EXPECT_EQ("val1", res);
+
+    // Expire time in the past removes the key
+    EXPECT_TRUE(storage.Put("KEY2", "val2", 0, storage.now - 1));
+    EXPECT_FALSE(storage.Get("KEY2", res));
+}
+
+TEST(ExpireTest, TimersReclaimMemory) {
+    const size_t length = 20;
+    ManualClockLRU storage(1000 * SimpleLRU::ItemFootprint(length, length));
+    uint32_t start = storage.now;
+    for (int i = 0; i < 500; ++i) {
+        EXPECT_TRUE(storage.Put(pad_space("Key " + std::to_string(i), length), pad_space("Val", length), 0,
+                                start + 1 + i * 100));
+    }
+    // Updates reschedule timers
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_TRUE(storage.Set(pad_space("Key " + std::to_string(i), length), pad_space("Val", length)));
+    }
+
+    auto items = [&storage]() {
+        std::vector<std::pair<std::string, uint64_t>> stats;
+        storage.GetStats(stats);
+        return std::map<std::string, uint64_t>(stats.begin(), stats.end());
+    };
+
+    // Single write reclaims all expired items, no matter how long the cache was idle
+    storage.now = start + 250 * 100;
+    storage.Put("other", "value");
+    EXPECT_EQ(500 - 150 + 1, items()["curr_items"]);
+    EXPECT_EQ(150, items()["expirations"]);
+
+    storage.now = start + 1000 * 100;
+    storage.Delete("other");
+    EXPECT_EQ(100, items()["curr_items"]);
+    EXPECT_EQ(400, items()["expirations"]);
+    EXPECT_EQ(0, items()["evictions"]);
+}
+
+TEST(TimerWheelTest, FiresOnTime) {
+    const uint32_t start = 1500000000;
+    std::vector<CacheNode> storage(2000);
+    std::vector<CacheNode *> nodes;
+    std::mt19937 rnd(1);
+    TimerWheel wheel(nodes, start);
+    for (uint32_t id = 0; id < storage.size(); ++id) {
+        nodes.push_back(&storage[id]);
+        // Timers from seconds up to years, including already expired ones
+        uint32_t delay = rnd() % 4 == 0 ? rnd() % 100 : rnd() % (1u << (rnd() % 27));
+        storage[id].expire = start + delay;
+        storage[id].timer_slot = CacheNode::NO_SLOT;
+        wheel.Schedule(id);
+    }
+    for (uint32_t id = 0; id < storage.size(); id += 10) {
+        wheel.Cancel(id);
+    }
+
+    std::vector<bool> fired(storage.size(), false);
+    std::vector<uint32_t> expired;
+    uint32_t now = start;
+    while (wheel.Size() > 0) {
+        now += 1 + rnd() % 100000;
+        expired.clear();
+        wheel.Advance(now, expired);
+        for (uint32_t id : expired) {
+            EXPECT_FALSE(fired[id]);
+            EXPECT_LE(storage[id].expire, now);
+            fired[id] = true;
+        }
+        for (uint32_t id = 0; id < storage.size(); ++id) {
+            if (id % 10 != 0 && storage[id].expire <= now) {
+                ASSERT_TRUE(fired[id]) << id << " expires at " << storage[id].expire << ", now " << now;
+            }
+        }
+    }
+    for (uint32_t id = 0; id < storage.size(); ++id) {
+        EXPECT_EQ(id % 10 != 0, fired[id]);
+    }
+}
+
+struct IdentityHash {
+    uint64_t operator()(uint64_t v) const { return v; }
+};
+
+TEST(KeyTest, HashCoversAllLengths) {
+    // Every length takes its own branch of the hash: empty, up to 3 bytes, up to 16, up to 48 and longer
+    std::string text(200, 'x');
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        text[i] = 'a' + (i * 7) % 26;
+    }
+    std::set<uint64_t> hashes;
+    for (std::size_t size = 0; size <= text.size(); ++size) {
+        hashes.insert(Afina::Hash(text.data(), size));
+        EXPECT_EQ(Afina::Hash(text.substr(0, size)), Afina::Hash(text.data(), size));
+    }
+    EXPECT_EQ(text.size() + 1, hashes.size());
+
+    // Key carries hash computed once, keys built different ways are the same
+    Afina::Key key(text);
+    EXPECT_EQ(Afina::Hash(text), key.hash());
+    EXPECT_TRUE(key == Afina::Key(text.data(), text.size(), key.hash()));
+    EXPECT_FALSE(key == Afina::Key(text.data(), text.size() - 1));
+    EXPECT_EQ(text, key.str());
+}
+
+// Key of the call argument converts from any string, key kept in the item never refers to a temporary one
+TEST(KeyTest, StoredKeyRejectsTemporaries) {
+    static_assert(std::is_convertible<std::string, Afina::Key>::value, "");
+    static_assert(std::is_constructible<Afina::StoredKey, std::string &>::value, "");
+    static_assert(!std::is_convertible<std::string &, Afina::StoredKey>::value, "");
+    static_assert(!std::is_constructible<Afina::StoredKey, std::string>::value, "");
+    static_assert(!std::is_constructible<Afina::StoredKey, const std::string>::value, "");
+
+    std::string name = "Key 1";
+    Afina::Storage::ReadItem item;
+    item.key = Afina::StoredKey(name);
+    EXPECT_EQ(Afina::Key(name), item.key);
+    EXPECT_EQ(Afina::Hash(name), item.key.hash());
+}
+
+TEST(KeyTest, HashSpreadsLowBits) {
+    // Stripes and lock-free buckets are chosen by the low bits of the hash
+    const int buckets = 256, count = buckets * 256;
+    std::vector<int> load(buckets);
+    for (int i = 0; i < count; ++i) {
+        load[Afina::Hash("key:" + std::to_string(i)) % buckets]++;
+    }
+    for (int n : load) {
+        EXPECT_GT(n, 128);
+        EXPECT_LT(n, 384);
+    }
+}
+
+TEST(HashIndexTest, InsertFindErase) {
+    HashIndex<uint64_t, IdentityHash> index(IdentityHash{});
+
+    const uint64_t count = 100000;
+    for (uint64_t i = 0; i < count; ++i) {
+        index.Insert(i, i);
+    }
+    EXPECT_EQ(count, index.size());
+
+    for (uint64_t i = 0; i < count; ++i) {
+        const uint64_t *pos = index.Find(i, [i](uint64_t v) { return v == i; });
+        ASSERT_TRUE(pos != nullptr);
+        EXPECT_EQ(i, *pos);
+    }
+    EXPECT_TRUE(index.Find(count, [count](uint64_t v) { return v == count; }) == nullptr);
+
+    for (uint64_t i = 0; i < count; i += 2) {
+        EXPECT_TRUE(index.Erase(i, [i](uint64_t v) { return v == i; }));
+    }
+    EXPECT_FALSE(index.Erase(0, [](uint64_t v) { return v == 0; }));
+    EXPECT_EQ(count / 2, index.size());
+
+    for (uint64_t i = 0; i < count; ++i) {
+        bool found = index.Find(i, [i](uint64_t v) { return v == i; }) != nullptr;
+        EXPECT_EQ(i % 2 == 1, found);
+    }
+}
+
+TEST(HashIndexTest, ChurnKeepsSize) {
+    HashIndex<uint64_t, IdentityHash> index(IdentityHash{}, 64);
+
+    // Constant number of live elements, but lots of tombstones
+    for (uint64_t i = 0; i < 100000; ++i) {
+        index.Insert(i, i);
+        if (i >= 32) {
+            uint64_t old = i - 32;
+            EXPECT_TRUE(index.Erase(old, [old](uint64_t v) { return v == old; }));
+        }
+    }
+    EXPECT_EQ(32, index.size());
+    for (uint64_t i = 100000 - 32; i < 100000; ++i) {
+        EXPECT_TRUE(index.Find(i, [i](uint64_t v) { return v == i; }) != nullptr);
+    }
+}
+
+TEST(HashIndexTest, EraseDuringGrow) {
+    HashIndex<uint64_t, IdentityHash> index(IdentityHash{});
+
+    // Every insert could start a grow or move groups, element erased meanwhile must stay erased
+    for (uint64_t i = 0; i < 10000; ++i) {
+        index.Insert(i, i);
+        if (i % 2 == 1) {
+            uint64_t old = i / 2;
+            EXPECT_TRUE(index.Erase(old, [old](uint64_t v) { return v == old; }));
+            EXPECT_TRUE(index.Find(old, [old](uint64_t v) { return v == old; }) == nullptr);
+        }
+    }
+    EXPECT_EQ(5000, index.size());
+    for (uint64_t i = 0; i < 10000; ++i) {
+        bool found = index.Find(i, [i](uint64_t v) { return v == i; }) != nullptr;
+        EXPECT_EQ(i >= 5000, found);
+    }
 }
 
 TEST(StorageTest, BigTest) {
     const size_t length = 20;
-    SimpleLRU storage(2 * 100000 * length);
+    SimpleLRU storage(100000 * SimpleLRU::ItemFootprint(length, length));
 
     for (long i = 0; i < 100000; ++i) {
         auto key = pad_space("Key " + std::to_string(i), length);
@@ -168,7 +1582,7 @@ TEST(StorageTest, BigTest) {
 
 TEST(StorageTest, MaxTest) {
     const size_t length = 20;
-    SimpleLRU storage(2 * 1000 * length);
+    SimpleLRU storage(1000 * SimpleLRU::ItemFootprint(length, length));
 
     std::stringstream ss;
 